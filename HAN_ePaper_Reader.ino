@@ -1,14 +1,23 @@
 #include <WiFi.h>
 #include <ArduinoOTA.h>
-#include <time.h>
+#include <LittleFS.h>
 
 #include "src/han_types.h"
 #include "src/config_store.h"
 #include "src/han_reader.h"
+#include "src/han_autodetect.h"
 #include "src/price_engine.h"
 #include "src/tariff_engine.h"
 #include "src/homey_http.h"
 #include "src/ui_display.h"
+#include "src/scheduler.h"
+#include "src/boot_metrics.h"
+#include "src/time_service.h"
+#include "src/history_store.h"
+#include "src/energy_accum.h"
+#include "src/energy_checkpoint.h"
+#include "src/cost_ledger.h"
+#include "src/capacity_guard.h"
 #include "src/version.h"
 
 #ifndef HANREADER_FORCE_HEADLESS
@@ -27,47 +36,70 @@ static DeviceConfig cfg;
 static HanSnapshot data;
 static HourBar bars[24];
 
+static const uint32_t HAN_STALE_MS = 30000UL;
+static const uint32_t WIFI_CONNECT_TIMEOUT_MS = 20000UL;
+
+enum NetState : uint8_t {
+  NET_AP_ONLY = 0,
+  NET_CONNECTING,
+  NET_ONLINE,
+};
+
 static uint32_t lastLoopSampleMs = 0;
-static uint32_t lastRefreshMs = 0;
+static uint32_t lastHanSeq = 0;
+static uint32_t lastTelegramMs = 0;
 static uint32_t refreshMs = 180000UL;
 static bool timeReady = false;
+static bool otaStarted = false;
+static bool apStarted = false;
+static bool displayReady = false;
+static NetState netState = NET_AP_ONLY;
+static uint32_t netStateMs = 0;
+
+static int8_t taskWebId = -1;
+static int8_t taskHanId = -1;
+static int8_t taskIntegrateId = -1;
+static int8_t taskTariffId = -1;
+static int8_t taskMetaId = -1;
+static int8_t taskPriceId = -1;
+static int8_t taskRenderId = -1;
+static int8_t taskNetId = -1;
+
+static CapacityPeaks monthPeaks;
+static uint8_t currentBarHour = 0;
 
-static int lastHour = -1;
-static int lastDay = -1;
-static int lastMonth = -1;
-static int lastYear = -1;
+// The first register reading after a restore closes the power-off gap.
+static bool reconcilePending = false;
 
-static float hourEnergyKwh = 0.0f;
-static float hourPowerL1Ws = 0.0f;
-static float hourPowerL2Ws = 0.0f;
-static float hourPowerL3Ws = 0.0f;
-static float hourPowerTotWs = 0.0f;
-static float hourSpanSeconds = 0.0f;
+// While a capture is replayed its readings are shown but nothing is booked:
+// no integration, register anchoring, history, ledger, capacity peaks or
+// routine checkpoints. The live anchor is put back when the UART returns.
+static bool replayActive = false;
+static AccumAnchor replayAnchor;
 
-static float monthTop3Kw[3] = {0.0f, 0.0f, 0.0f};
-static uint8_t currentBarHour = 0;
+// Register corrections waiting to be charged as estimated cost; they need a
+// month with metered energy to take the average rate from.
+static float pendingEstimateKwh = 0.0f;
 
 static bool displayActive()
 {
   return cfg.display_enabled && HANREADER_FORCE_HEADLESS == 0;
 }
 
-static String nowHHMM()
+static void nowHHMM(char out[6])
 {
-  tm t;
-  if (!getLocalTime(&t, 50)) return "--:--";
-  char buf[6];
-  snprintf(buf, sizeof(buf), "%02d:%02d", t.tm_hour, t.tm_min);
-  return String(buf);
+  strlcpy(out, time_now().hhmm, 6);
 }
 
-static String ipLastOctetDot()
+static void ipLastOctetDot(char out[8])
 {
-  if (WiFi.status() != WL_CONNECTED) return "";
+  if (WiFi.status() != WL_CONNECTED)
+  {
+    out[0] = '\0';
+    return;
+  }
   IPAddress ip = WiFi.localIP();
-  char buf[8];
-  snprintf(buf, sizeof(buf), ".%u", ip[3]);
-  return String(buf);
+  snprintf(out, 8, ".%u", ip[3]);
 }
 
 static String buildApSsid()
@@ -87,23 +119,59 @@ static String apIp()
   return String(buf);
 }
 
-static void setupTimeNTP()
+static void ensureDisplay()
 {
-  configTime(0, 0, NTP1, NTP2);
-  setenv("TZ", TZ_INFO, 1);
-  tzset();
+  if (displayReady || !displayActive()) return;
+  ui_epaper_hard_clear();
+  ui_init();
+  displayReady = true;
+}
 
-  tm t;
-  for (int i = 0; i < 40; ++i)
+static void startAccessPoint()
+{
+  if (apStarted) return;
+  WiFi.mode(WIFI_AP_STA);
+  String ssid = buildApSsid();
+  WiFi.softAP(ssid.c_str(), PRODUCT_AP_PASS);
+  apStarted = true;
+
+  const bool staOk = WiFi.status() == WL_CONNECTED;
+  String ip = staOk ? WiFi.localIP().toString() : apIp();
+  String url = String("http://") + ip + "/admin";
+  if (displayActive())
   {
-    if (getLocalTime(&t, 250))
-    {
-      timeReady = true;
-      return;
-    }
-    delay(250);
+    ensureDisplay();
+    ui_render_onboarding(ssid, PRODUCT_AP_PASS, ip, url);
+  }
+}
+
+// Kicks off WiFi without waiting for it; taskNet() follows it up.
+static void startNetwork()
+{
+  WiFi.setHostname(PRODUCT_DEVICE_NAME);
+  netStateMs = millis();
+
+  if (cfg.wifi_ssid.length() > 0)
+  {
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(true);
+    WiFi.begin(cfg.wifi_ssid.c_str(), cfg.wifi_pass.c_str());
+    netState = NET_CONNECTING;
+  }
+  else
+  {
+    netState = NET_AP_ONLY;
   }
-  timeReady = false;
+
+  if (!cfg.setup_completed || netState == NET_AP_ONLY) startAccessPoint();
+}
+
+// Readings published before SNTP finished carry no wall-clock time; give the
+// latest one its time now, back-dated by its age.
+static void stampPendingTelegram()
+{
+  if (lastHanSeq == 0 || data.data_time[0] != '-') return;
+  time_format_hhmm(time_service_epoch_at(lastTelegramMs), data.data_time);
 }
 
 static void initBars()
@@ -130,279 +198,436 @@ static void pushHourToBars(uint8_t hour, float avgL1, float avgL2, float avgL3,
   bars[23].kwh = kwh;
 }
 
-static void updateTop3(float kw)
+static float top3AvgKw()
 {
-  if (kw > monthTop3Kw[0])
-  {
-    monthTop3Kw[2] = monthTop3Kw[1];
-    monthTop3Kw[1] = monthTop3Kw[0];
-    monthTop3Kw[0] = kw;
-  }
-  else if (kw > monthTop3Kw[1])
-  {
-    monthTop3Kw[2] = monthTop3Kw[1];
-    monthTop3Kw[1] = kw;
-  }
-  else if (kw > monthTop3Kw[2])
-  {
-    monthTop3Kw[2] = kw;
-  }
+  return capacity_peaks_mean_kw(monthPeaks);
 }
 
-static float top3AvgKw()
+static uint16_t clampW(float w)
 {
-  int n = 0;
-  float s = 0.0f;
-  for (int i = 0; i < 3; ++i)
-  {
-    if (monthTop3Kw[i] > 0.01f)
-    {
-      s += monthTop3Kw[i];
-      ++n;
-    }
-  }
-  if (n == 0) return 0.0f;
-  return s / static_cast<float>(n);
+  if (w <= 0.0f) return 0;
+  if (w >= 65535.0f) return 65535;
+  return static_cast<uint16_t>(w + 0.5f);
 }
 
-static bool isWeekend(const tm& t)
+static void closeMinute(const TimeNow& now)
 {
-  return (t.tm_wday == 0 || t.tm_wday == 6);
+  const AccumResult m = accum_close(ACC_MINUTE, now.minute_start);
+  if (m.start == 0 || replayActive) return;
+
+  HistRecord r;
+  r.start = m.start;
+  r.energy_dwh = static_cast<uint32_t>(m.energy_kwh * 10000.0f + 0.5f);
+  r.l1_w = clampW(m.phase_avg_w[0]);
+  r.l2_w = clampW(m.phase_avg_w[1]);
+  r.l3_w = clampW(m.phase_avg_w[2]);
+  r.peak_w = clampW(m.peak_w);
+  history_store_add_minute(r);
+
+  // The spot price is still the one of the closing minute; the price task
+  // runs after the clock events.
+  time_t at = static_cast<time_t>(m.start);
+  tm local;
+  localtime_r(&at, &local);
+  cost_ledger_charge(m.energy_kwh, data.price_spot_nok_kwh, tariff_active(), local);
+  if (pendingEstimateKwh != 0.0f && cost_ledger_charge_estimated(pendingEstimateKwh)) pendingEstimateKwh = 0.0f;
 }
 
-static void finalizeHourIfNeeded(const tm& nowTm)
+static void closeHour(const TimeNow& now)
 {
-  if (lastHour < 0)
-  {
-    lastHour = nowTm.tm_hour;
-    currentBarHour = static_cast<uint8_t>(nowTm.tm_hour);
-    return;
-  }
+  const AccumResult h = accum_close(ACC_HOUR, now.hour_start);
+  pushHourToBars(currentBarHour, h.phase_avg_w[0], h.phase_avg_w[1], h.phase_avg_w[2], h.avg_w, h.energy_kwh);
+  if (!replayActive) capacity_peaks_add_hour(monthPeaks, h.avg_w / 1000.0f);
+  currentBarHour = static_cast<uint8_t>(now.local.tm_hour);
+}
+
+static void syncEnergyTotals()
+{
+  data.day_energy_kwh = accum_energy_kwh(ACC_DAY);
+  data.month_energy_kwh = accum_energy_kwh(ACC_MONTH);
+  data.year_energy_kwh = accum_energy_kwh(ACC_YEAR);
+}
+
+static void syncCosts()
+{
+  data.day_cost_nok = cost_ledger_current(COST_DAY).total_nok;
+  data.month_cost_nok = cost_ledger_current(COST_MONTH).total_nok;
+}
 
-  if (nowTm.tm_hour == lastHour) return;
+static bool restoreBar(const HistRecord& r, void* ctx)
+{
+  const uint32_t lastStart = *static_cast<const uint32_t*>(ctx);
+  const uint32_t age = (lastStart - r.start) / 3600UL;
+  if (age > 23) return true;
 
-  float avgL1 = (hourSpanSeconds > 0.1f) ? (hourPowerL1Ws / hourSpanSeconds) : 0.0f;
-  float avgL2 = (hourSpanSeconds > 0.1f) ? (hourPowerL2Ws / hourSpanSeconds) : 0.0f;
-  float avgL3 = (hourSpanSeconds > 0.1f) ? (hourPowerL3Ws / hourSpanSeconds) : 0.0f;
-  float avgTot = (hourSpanSeconds > 0.1f) ? (hourPowerTotWs / hourSpanSeconds) : 0.0f;
+  time_t at = static_cast<time_t>(r.start);
+  tm t;
+  localtime_r(&at, &t);
+  HourBar& b = bars[23 - age];
+  b.hour = static_cast<uint8_t>(t.tm_hour);
+  b.l1_w = r.l1_w;
+  b.l2_w = r.l2_w;
+  b.l3_w = r.l3_w;
+  b.total_w = history_record_avg_w(r, HIST_HOUR);
+  b.kwh = r.energy_dwh / 10000.0f;
+  return true;
+}
 
-  pushHourToBars(currentBarHour, avgL1, avgL2, avgL3, avgTot, hourEnergyKwh);
-  updateTop3(avgTot / 1000.0f);
+// The 24 h bars survive a reboot through the hourly tier.
+static void restoreBarsFromHistory(const TimeNow& now)
+{
+  const uint32_t epoch = static_cast<uint32_t>(now.epoch);
+  uint32_t lastStart = epoch - (epoch % 3600UL) - 3600UL;
+  history_store_query(HIST_HOUR, lastStart - 23UL * 3600UL, lastStart + 1, restoreBar, &lastStart);
+}
 
-  hourEnergyKwh = 0.0f;
-  hourPowerL1Ws = 0.0f;
-  hourPowerL2Ws = 0.0f;
-  hourPowerL3Ws = 0.0f;
-  hourPowerTotWs = 0.0f;
-  hourSpanSeconds = 0.0f;
+static void updateTariff(const tm& nowTm)
+{
+  float spotNow = isnan(data.price_spot_nok_kwh) ? 0.0f : data.price_spot_nok_kwh;
+  TariffResult tariff = tariff_compute_now(spotNow, top3AvgKw(), nowTm);
+  data.price_grid_nok_kwh = tariff.grid_nok_kwh;
+  data.price_total_nok_kwh = tariff.total_nok_kwh;
+  data.selected_capacity_step_kw = tariff.selected_capacity_kw;
+  data.selected_capacity_step_nok_month = tariff.selected_capacity_nok_month;
+  cost_ledger_set_monthly(tariff.selected_capacity_nok_month, tariff_active().fixed_monthly_nok, tariff_active().vat_factor);
+}
 
-  lastHour = nowTm.tm_hour;
-  currentBarHour = static_cast<uint8_t>(nowTm.tm_hour);
+// Windows restored from a checkpoint that ended while the device was down.
+static uint8_t windowsEndedSince(const TimeNow& now)
+{
+  uint8_t events = 0;
+  if (accum_start(ACC_MINUTE) != now.minute_start) events |= TIME_EV_MINUTE;
+  if (accum_start(ACC_QUARTER) != now.quarter_start) events |= TIME_EV_QUARTER;
+  if (accum_start(ACC_HOUR) != now.hour_start) events |= TIME_EV_HOUR;
+  if (accum_start(ACC_DAY) != now.day_start) events |= TIME_EV_DAY;
+  if (accum_start(ACC_MONTH) != now.month_start) events |= TIME_EV_MONTH;
+  if (accum_start(ACC_YEAR) != now.year_start) events |= TIME_EV_YEAR;
+  return events;
 }
 
-static void resetTimeBucketsIfNeeded(const tm& nowTm)
+static void onClockEvent(uint8_t events, const TimeNow& now)
 {
-  if (lastDay < 0)
+  if (events & TIME_EV_VALID)
   {
-    lastDay = nowTm.tm_mday;
-    lastMonth = nowTm.tm_mon;
-    lastYear = nowTm.tm_year;
-    return;
+    timeReady = true;
+    boot_mark(BOOT_TIME_VALID);
+    stampPendingTelegram();
+    // Capacity step for the cost windows that may close below.
+    updateTariff(now.local);
+
+    if (accum_start(ACC_HOUR) != 0)
+    {
+      // Restored windows: close the ones that are over, through the normal path.
+      time_t hourStart = static_cast<time_t>(accum_start(ACC_HOUR));
+      tm t;
+      localtime_r(&hourStart, &t);
+      currentBarHour = static_cast<uint8_t>(t.tm_hour);
+      events |= windowsEndedSince(now);
+    }
+    else
+    {
+      // Energy since boot stays in the windows the clock now places it in.
+      currentBarHour = static_cast<uint8_t>(now.local.tm_hour);
+      accum_set_start(ACC_MINUTE, now.minute_start);
+      accum_set_start(ACC_QUARTER, now.quarter_start);
+      accum_set_start(ACC_HOUR, now.hour_start);
+      accum_set_start(ACC_DAY, now.day_start);
+      accum_set_start(ACC_MONTH, now.month_start);
+      accum_set_start(ACC_YEAR, now.year_start);
+      cost_ledger_set_start(COST_DAY, now.day_start);
+      cost_ledger_set_start(COST_MONTH, now.month_start);
+    }
+
+    // Loading the page index touches every page file; done here rather than
+    // in setup() to stay off the boot path.
+    history_store_begin();
+    restoreBarsFromHistory(now);
   }
 
-  if (nowTm.tm_mday != lastDay)
+  // Minute first: its peak feeds the longer windows closing at the same time.
+  if (events & TIME_EV_MINUTE) closeMinute(now);
+  if (events & TIME_EV_QUARTER) accum_close(ACC_QUARTER, now.quarter_start);
+  if (events & TIME_EV_HOUR) closeHour(now);
+  if (events & TIME_EV_DAY)
   {
-    data.day_energy_kwh = 0.0f;
-    lastDay = nowTm.tm_mday;
+    accum_close(ACC_DAY, now.day_start);
+    cost_ledger_close(COST_DAY, now.day_start);
+    capacity_peaks_close_day(monthPeaks);
   }
-
-  if (nowTm.tm_mon != lastMonth)
+  if (events & TIME_EV_MONTH)
   {
-    data.month_energy_kwh = 0.0f;
-    monthTop3Kw[0] = monthTop3Kw[1] = monthTop3Kw[2] = 0.0f;
-    lastMonth = nowTm.tm_mon;
+    accum_close(ACC_MONTH, now.month_start);
+    cost_ledger_close(COST_MONTH, now.month_start);
+    capacity_peaks_reset(monthPeaks);
   }
+  if (events & TIME_EV_YEAR) accum_close(ACC_YEAR, now.year_start);
+  syncEnergyTotals();
+  if (events & (TIME_EV_VALID | TIME_EV_MINUTE)) syncCosts();
+
+  if ((events & (TIME_EV_QUARTER | TIME_EV_HOUR)) && !replayActive) energy_checkpoint_save(false);
 
-  if (nowTm.tm_year != lastYear)
+  // New hour: new spot price, tariff band and possibly capacity step.
+  if (events & (TIME_EV_VALID | TIME_EV_HOUR))
+  {
+    sched_trigger(taskPriceId);
+    sched_trigger(taskTariffId);
+  }
+  // Day tables may have 15-minute prices.
+  else if (events & TIME_EV_QUARTER)
   {
-    data.year_energy_kwh = 0.0f;
-    lastYear = nowTm.tm_year;
+    sched_trigger(taskPriceId);
   }
 }
 
-static void applyEnergyIntegration(float dtSeconds)
+static void applyEnergyIntegration(uint32_t dtMs)
 {
   float importW = (data.stale || isnan(data.import_power_w)) ? 0.0f : max(data.import_power_w, 0.0f);
+  float exportW = (data.stale || isnan(data.export_power_w)) ? 0.0f : max(data.export_power_w, 0.0f);
   float l1 = isnan(data.phase_power_w[0]) ? 0.0f : max(data.phase_power_w[0], 0.0f);
   float l2 = isnan(data.phase_power_w[1]) ? 0.0f : max(data.phase_power_w[1], 0.0f);
   float l3 = isnan(data.phase_power_w[2]) ? 0.0f : max(data.phase_power_w[2], 0.0f);
 
-  float kwh = (importW * dtSeconds) / 3600000.0f;
-  data.day_energy_kwh += kwh;
-  data.month_energy_kwh += kwh;
-  data.year_energy_kwh += kwh;
-
-  hourEnergyKwh += kwh;
-  hourPowerL1Ws += l1 * dtSeconds;
-  hourPowerL2Ws += l2 * dtSeconds;
-  hourPowerL3Ws += l3 * dtSeconds;
-  hourPowerTotWs += importW * dtSeconds;
-  hourSpanSeconds += dtSeconds;
+  // Replayed power is not this house's; the next live register reading
+  // books what was used meanwhile.
+  if (!replayActive) accum_sample(importW, exportW, l1, l2, l3, dtMs);
+  syncEnergyTotals();
 }
 
 static void updateMetadata()
 {
-  data.wifi_status = (WiFi.status() == WL_CONNECTED) ? "OK" : "NO";
-  data.ip_suffix = ipLastOctetDot();
-  data.zone = cfg.price_zone;
-  data.refresh_time = nowHHMM();
+  strlcpy(data.wifi_status, (WiFi.status() == WL_CONNECTED) ? "OK" : "NO", sizeof(data.wifi_status));
+  ipLastOctetDot(data.ip_suffix);
+  strlcpy(data.zone, cfg.price_zone.c_str(), sizeof(data.zone));
+  nowHHMM(data.refresh_time);
 }
 
-static void updatePriceAndTariff(const tm& nowTm)
-{
-  SpotPriceResult spot = price_engine_get_now(cfg);
-  if (spot.ok) data.price_spot_nok_kwh = spot.nok_per_kwh;
-
-  float spotNow = isnan(data.price_spot_nok_kwh) ? 0.0f : data.price_spot_nok_kwh;
-  TariffResult tariff = tariff_compute_now(cfg,
-                                           spotNow,
-                                           top3AvgKw(),
-                                           isWeekend(nowTm),
-                                           nowTm.tm_hour);
-  data.price_grid_nok_kwh = tariff.grid_nok_kwh;
-  data.price_total_nok_kwh = tariff.total_nok_kwh;
-  data.selected_capacity_step_kw = tariff.selected_capacity_kw;
-  data.selected_capacity_step_nok_month = tariff.selected_capacity_nok_month;
-}
+// Scheduler tasks. Each runs to completion; anything that used to run every
+// 50 ms now runs on its own period or when an event makes it necessary.
 
-static void updateDataFromSources()
+static void taskWeb()
 {
-  HanSnapshot parsed = data;
-  bool got = false;
-  if (cfg.han_enabled)
-  {
-    got = han_reader_poll(parsed);
-  }
-
-  if (got)
-  {
-    data = parsed;
-    data.stale = false;
-    data.data_time = nowHHMM();
-  }
-  else
-  {
-    data.stale = true;
-  }
+  webportal_loop();
+  if (otaStarted) ArduinoOTA.handle();
+  // A restart that timed out waiting for the ingest task leaves the reader
+  // stopped; keep retrying with the saved setting.
+  if (!han_reader_running()) han_reader_begin(cfg);
 
-  tm nowTm;
-  if (getLocalTime(&nowTm, 20))
+  if (webportal_consume_refresh_request())
   {
-    finalizeHourIfNeeded(nowTm);
-    resetTimeBucketsIfNeeded(nowTm);
-    updatePriceAndTariff(nowTm);
+    refreshMs = cfg.poll_interval_ms;
+    if (refreshMs < 180000UL) refreshMs = 180000UL;
+    sched_set_period(taskRenderId, refreshMs);
+    han_reader_begin(cfg);
+    tariff_engine_configure(cfg);
+    sched_trigger(taskHanId);
+    sched_trigger(taskPriceId);
+    sched_trigger(taskTariffId);
+    sched_trigger(taskMetaId);
+    sched_trigger(taskRenderId);
   }
+}
 
-  updateMetadata();
+static void onHanPublished()
+{
+  sched_trigger(taskHanId);
 }
 
-void setup()
+static void onPriceFetched()
 {
-  Serial.begin(115200);
-  delay(200);
+  sched_trigger(taskPriceId);
+}
 
-  config_begin();
-  cfg = config_load();
-  refreshMs = cfg.poll_interval_ms;
+static void collectCheckpoint(EnergyCheckpoint& ck)
+{
+  ck.saved_epoch = time_valid() ? static_cast<uint32_t>(time_now().epoch) : 0;
+  accum_export(ck.accum);
+  ck.capacity = monthPeaks;
+  cost_ledger_export(ck.cost);
+}
 
-  initBars();
+static void restoreCheckpoint(const EnergyCheckpoint& ck)
+{
+  accum_import(ck.accum);
+  cost_ledger_import(ck.cost);
+  monthPeaks = ck.capacity;
+  reconcilePending = ck.accum.register_wh[0] >= 0;
+  syncEnergyTotals();
+}
 
-  if (displayActive())
+// Register readings anchor the accumulators; integration only fills in
+// between. After a restore the first correction also covers the time we
+// were down, which is what the checkpoint stats report. Like any correction
+// it goes into day, month and year only: the restored hour and minute (and
+// so capacity peaks and the ledger) keep what was integrated.
+static void trackRegisters()
+{
+  if (data.import_wh_total < 0 && data.export_wh_total < 0) return;
+  const float correctionWh = accum_register(data.import_wh_total, data.export_wh_total);
+  pendingEstimateKwh += correctionWh / 1000.0f;
+  if (reconcilePending && data.import_wh_total >= 0)
   {
-    ui_epaper_hard_clear();
-    ui_init();
+    energy_checkpoint_note_reconciled(correctionWh / 1000.0f);
+    reconcilePending = false;
   }
+  syncEnergyTotals();
+}
 
-  WiFi.setHostname(PRODUCT_DEVICE_NAME);
-  bool staOk = false;
+static void followReplay()
+{
+  const bool replay = han_reader_replaying();
+  if (replay == replayActive) return;
+  replayActive = replay;
+  if (replay) replayAnchor = accum_anchor_save();
+  else accum_anchor_restore(replayAnchor);
+  strlcpy(data.source, replay ? "REPLAY" : "HAN", sizeof(data.source));
+}
 
-  if (cfg.wifi_ssid.length() > 0)
+static void taskHan()
+{
+  followReplay();
+  // Bytes are parsed on the ingest task; only copy meter values when a new
+  // validated telegram was published.
+  if (cfg.han_enabled && han_reader_fetch(lastHanSeq, data))
   {
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(cfg.wifi_ssid.c_str(), cfg.wifi_pass.c_str());
-    uint32_t start = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - start < 20000UL) delay(250);
-    staOk = WiFi.status() == WL_CONNECTED;
+    lastTelegramMs = millis();
+    nowHHMM(data.data_time);
+    boot_mark(BOOT_FIRST_TELEGRAM);
+    if (!replayActive) trackRegisters();
   }
+  han_autodetect_tick(cfg, lastHanSeq != 0);
+  data.stale = (lastHanSeq == 0) || (millis() - lastTelegramMs > HAN_STALE_MS);
+}
 
-  if (!cfg.setup_completed || !staOk)
-  {
-    WiFi.mode(WIFI_AP_STA);
-    String ssid = buildApSsid();
-    WiFi.softAP(ssid.c_str(), PRODUCT_AP_PASS);
-
-    String ip = staOk ? WiFi.localIP().toString() : apIp();
-    String url = String("http://") + ip + "/admin";
-    if (displayActive()) ui_render_onboarding(ssid, PRODUCT_AP_PASS, ip, url);
-  }
+static void taskIntegrate()
+{
+  followReplay();
+  uint32_t nowMs = millis();
+  uint32_t dt = nowMs - lastLoopSampleMs;
+  lastLoopSampleMs = nowMs;
+  applyEnergyIntegration(dt);
 
-  if (WiFi.status() == WL_CONNECTED)
-  {
-    setupTimeNTP();
-    ArduinoOTA.setHostname(PRODUCT_DEVICE_NAME);
-    ArduinoOTA.begin();
-  }
+  const TimeNow& now = time_now();
+  const float liveW = (data.stale || replayActive) ? 0.0f : data.import_power_w;
+  capacity_guard_update(accum_current(ACC_HOUR), liveW, monthPeaks, tariff_active(),
+                        now.valid ? static_cast<uint32_t>(now.epoch) : 0, dt);
 
-  han_reader_begin(cfg);
-  webportal_begin(cfg);
+  // Integrate first so the closing second still counts for the old hour.
+  time_service_tick();
+}
 
-  updateDataFromSources();
+static void taskTariff()
+{
+  if (!time_valid()) return;
+  updateTariff(time_now().local);
   webportal_set_data(data, bars, top3AvgKw());
+}
+
+static void taskPrice()
+{
+  // The price lookup waits for the clock; nothing to fetch until SNTP is in.
+  if (!timeReady && !cfg.manual_spot_enabled) return;
+  SpotPriceResult spot = price_engine_get_now(cfg);
+  if (!spot.ok || spot.nok_per_kwh == data.price_spot_nok_kwh) return;
+  data.price_spot_nok_kwh = spot.nok_per_kwh;
+  sched_trigger(taskTariffId);
+}
+
+static void taskMeta()
+{
+  updateMetadata();
+}
 
+static void taskRender()
+{
+  nowHHMM(data.refresh_time);
   if (displayActive() && cfg.setup_completed)
   {
+    ensureDisplay();
     ui_render(data, bars);
   }
-
-  lastLoopSampleMs = millis();
-  lastRefreshMs = millis();
 }
 
-void loop()
+static void taskNet()
 {
-  webportal_loop();
-  ArduinoOTA.handle();
-
-  if (!timeReady && WiFi.status() == WL_CONNECTED) setupTimeNTP();
-
-  uint32_t nowMs = millis();
-  float dt = (nowMs >= lastLoopSampleMs) ? (nowMs - lastLoopSampleMs) / 1000.0f : 0.0f;
-  lastLoopSampleMs = nowMs;
-
-  updateDataFromSources();
-  applyEnergyIntegration(dt);
+  const bool up = WiFi.status() == WL_CONNECTED;
 
-  if (webportal_consume_refresh_request())
+  if (netState == NET_CONNECTING && up)
   {
-    refreshMs = cfg.poll_interval_ms;
-    if (refreshMs < 180000UL) refreshMs = 180000UL;
-    han_reader_begin(cfg);
-    updateDataFromSources();
-    lastRefreshMs = 0;
+    netState = NET_ONLINE;
+    netStateMs = millis();
+    boot_mark(BOOT_WIFI_UP);
+    if (!otaStarted)
+    {
+      time_service_start_sntp(TZ_INFO, NTP1, NTP2);
+      ArduinoOTA.setHostname(PRODUCT_DEVICE_NAME);
+      ArduinoOTA.onStart([]() {
+        energy_checkpoint_save(true);
+        history_store_flush();
+      });
+      ArduinoOTA.begin();
+      otaStarted = true;
+      boot_mark(BOOT_OTA_READY);
+    }
+    sched_trigger(taskMetaId);
+    sched_trigger(taskPriceId);
+  }
+  else if (netState == NET_CONNECTING && !apStarted && millis() - netStateMs > WIFI_CONNECT_TIMEOUT_MS)
+  {
+    // Keep trying STA in the background, but make the device reachable.
+    startAccessPoint();
   }
+  else if (netState == NET_ONLINE && !up)
+  {
+    netState = NET_CONNECTING;
+    netStateMs = millis();
+    sched_trigger(taskMetaId);
+  }
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  config_begin();
+  LittleFS.begin(true);
+  cfg = config_load();
+  refreshMs = cfg.poll_interval_ms;
+  tariff_engine_configure(cfg);
 
+  initBars();
+  EnergyCheckpoint ck;
+  if (energy_checkpoint_begin(collectCheckpoint, ck)) restoreCheckpoint(ck);
+  time_service_subscribe(TIME_EV_VALID | TIME_EV_MINUTE | TIME_EV_QUARTER | TIME_EV_HOUR | TIME_EV_DAY | TIME_EV_MONTH | TIME_EV_YEAR, onClockEvent);
+  price_engine_begin();
+  price_engine_on_update(onPriceFetched);
+
+  // HAN and the local API first; WiFi, SNTP, OTA and the display come up
+  // from the scheduler without holding anything else back.
+  han_reader_on_publish(onHanPublished);
+  han_reader_begin(cfg);
+  startNetwork();
+  webportal_begin(cfg);
   webportal_set_data(data, bars, top3AvgKw());
 
-  if (nowMs - lastRefreshMs >= refreshMs)
-  {
-    lastRefreshMs = nowMs;
-    data.refresh_time = nowHHMM();
+  lastLoopSampleMs = millis();
 
-    if (displayActive() && cfg.setup_completed)
-    {
-      ui_render(data, bars);
-    }
-  }
+  // Lower number = higher priority. Deadlines are how late a run may start.
+  taskWebId = sched_add("web", taskWeb, 10, 50, 0);
+  taskHanId = sched_add("han", taskHan, 1000, 100, 1);
+  taskIntegrateId = sched_add("integrate", taskIntegrate, 1000, 250, 2);
+  taskTariffId = sched_add("tariff", taskTariff, 0, 500, 3);
+  taskNetId = sched_add("net", taskNet, 250, 500, 4);
+  taskMetaId = sched_add("meta", taskMeta, 5000, 1000, 5);
+  taskPriceId = sched_add("price", taskPrice, 60000, 100, 6);
+  taskRenderId = sched_add("render", taskRender, refreshMs, 5000, 7);
+
+  // Light sleep stops the UART clock and would drop HAN bytes.
+  sched_configure_power(!cfg.han_enabled);
+
+  sched_trigger(taskTariffId);
+}
 
-  delay(50);
+void loop()
+{
+  sched_run_once();
 }
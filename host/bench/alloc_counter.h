@@ -0,0 +1,9 @@
+#pragma once
+
+// Heap allocations made by the whole process so far (global operator new
+// is replaced in alloc_counter.cpp). Benchmarks read it before and after a
+// run to report allocations per item.
+
+#include <stdint.h>
+
+uint64_t alloc_count();
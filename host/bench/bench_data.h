@@ -0,0 +1,24 @@
+#pragma once
+
+// Recorded inputs for the host benchmarks and tests, from host/data.
+
+#include <stdio.h>
+
+#include <string>
+
+#ifndef HANREADER_HOST_DATA
+#define HANREADER_HOST_DATA "host/data"
+#endif
+
+inline std::string load_data_file(const char* name)
+{
+  std::string path = std::string(HANREADER_HOST_DATA) + "/" + name;
+  std::string out;
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return out;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  fclose(f);
+  return out;
+}
@@ -0,0 +1,86 @@
+// Decodes the HDLC vendor corpus (Aidon, Kaifa, Kamstrup lists 1-3) as one
+// byte stream: framing with HCS/FCS check plus the DLMS push-list decode,
+// reported as bytes/s and frames/s.
+
+#include <string.h>
+
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench_data.h"
+#include "dlms_decoder.h"
+
+static std::vector<uint8_t> corpus_stream(const char* prefix)
+{
+  std::vector<uint8_t> out;
+  std::istringstream in(load_data_file("hdlc_corpus.txt"));
+  std::string line;
+  while (std::getline(in, line))
+  {
+    if (line.empty() || line[0] == '#' || line.compare(0, strlen(prefix), prefix) != 0) continue;
+    for (size_t i = line.find(' ') + 1; i + 1 < line.size(); i += 2)
+    {
+      out.push_back(static_cast<uint8_t>(std::stoul(line.substr(i, 2), nullptr, 16)));
+    }
+  }
+  return out;
+}
+
+static void hdlc_bench(benchmark::State& state, const char* prefix)
+{
+  const std::vector<uint8_t> stream = corpus_stream(prefix);
+  if (stream.empty())
+  {
+    state.SkipWithError("hdlc_corpus.txt missing");
+    return;
+  }
+  static HdlcDecoder d;  // 1 KB frame buffer
+  hdlc_decoder_reset(d);
+  DlmsValue out[DLMS_MAX_VALUES];
+  uint32_t frames = 0;
+  uint32_t values = 0;
+  for (auto _ : state)
+  {
+    frames = 0;
+    values = 0;
+    for (uint8_t b : stream)
+    {
+      if (!hdlc_decoder_feed(d, b)) continue;
+      ++frames;
+      values += dlms_decode_frame(d, out);
+    }
+    benchmark::DoNotOptimize(out[0].value);
+  }
+  const int64_t iterations = static_cast<int64_t>(state.iterations());
+  state.SetBytesProcessed(iterations * static_cast<int64_t>(stream.size()));
+  state.SetItemsProcessed(iterations * frames);
+  state.counters["frames"] = frames;
+  state.counters["values"] = values;
+}
+
+static void BM_HdlcAidon(benchmark::State& state)
+{
+  hdlc_bench(state, "aidon");
+}
+BENCHMARK(BM_HdlcAidon);
+
+static void BM_HdlcKaifa(benchmark::State& state)
+{
+  hdlc_bench(state, "kaifa");
+}
+BENCHMARK(BM_HdlcKaifa);
+
+static void BM_HdlcKamstrup(benchmark::State& state)
+{
+  hdlc_bench(state, "kamstrup");
+}
+BENCHMARK(BM_HdlcKamstrup);
+
+static void BM_HdlcAllVendors(benchmark::State& state)
+{
+  hdlc_bench(state, "");
+}
+BENCHMARK(BM_HdlcAllVendors);
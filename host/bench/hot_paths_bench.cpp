@@ -0,0 +1,124 @@
+// Host benchmarks for the firmware hot paths: OBIS telegram parsing, tariff
+// lookup and the JSON rendered for /status (price payload parsing is in
+// price_bench.cpp). Run with --benchmark_format=json (or the bench_json
+// target) for machine-readable output.
+
+#include <benchmark/benchmark.h>
+
+#include "bench_data.h"
+#include "capacity_guard.h"
+#include "config_store.h"
+#include "cost_ledger.h"
+#include "obis_parser.h"
+#include "perf_stats.h"
+#include "tariff_engine.h"
+
+static tm local_tm(int year, int mon, int mday, int hour)
+{
+  tm t = {};
+  t.tm_year = year - 1900;
+  t.tm_mon = mon - 1;
+  t.tm_mday = mday;
+  t.tm_hour = hour;
+  t.tm_isdst = -1;
+  time_t epoch = mktime(&t);
+  tm out;
+  localtime_r(&epoch, &out);
+  return out;
+}
+
+static CompiledTariff compiled_default()
+{
+  DeviceConfig cfg = config_load();
+  CompiledTariff t;
+  tariff_compile(cfg, t);
+  return t;
+}
+
+static void BM_ObisTelegram(benchmark::State& state)
+{
+  const std::string telegram = load_data_file("dsmr_telegram.txt");
+  if (telegram.empty())
+  {
+    state.SkipWithError("dsmr_telegram.txt missing");
+    return;
+  }
+  ObisParser p;
+  float sum = 0.0f;
+  for (auto _ : state)
+  {
+    obis_parser_reset(p);
+    for (char c : telegram)
+    {
+      const ObisEvent ev = obis_parser_feed(p, c);
+      if (ev >= OBIS_VOLTAGE_L1) sum += obis_parser_value(p);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  if (!obis_parser_telegram_ok(p)) state.SkipWithError("telegram CRC mismatch");
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * telegram.size());
+}
+BENCHMARK(BM_ObisTelegram);
+
+static void BM_TariffCompile(benchmark::State& state)
+{
+  const DeviceConfig cfg = config_load();
+  CompiledTariff t;
+  for (auto _ : state)
+  {
+    tariff_compile(cfg, t);
+    benchmark::DoNotOptimize(t.grid_nok_kwh[0]);
+  }
+}
+BENCHMARK(BM_TariffCompile);
+
+// One lookup per hour of a week, as the live path does once per update.
+static void BM_TariffCompute(benchmark::State& state)
+{
+  const CompiledTariff t = compiled_default();
+  tm week[168];
+  for (int h = 0; h < 168; ++h) week[h] = local_tm(2026, 2, 9 + h / 24, h % 24);
+  for (auto _ : state)
+  {
+    for (int h = 0; h < 168; ++h)
+    {
+      const TariffResult r = tariff_compute(t, 0.85f, 4.2f + 0.01f * h, tariff_rate_index(t, week[h]));
+      benchmark::DoNotOptimize(r.total_nok_kwh);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * 168);
+}
+BENCHMARK(BM_TariffCompute);
+
+// The String-built JSON blocks of /status.
+static void BM_StatusJson(benchmark::State& state)
+{
+  const CompiledTariff t = compiled_default();
+  const tm local = local_tm(2026, 2, 9, 8);
+  cost_ledger_set_monthly(tariff_capacity_monthly_nok(t, 4.2f), t.fixed_monthly_nok, t.vat_factor);
+  for (int m = 0; m < 60; ++m) cost_ledger_charge(0.05f, 0.85f, t, local);
+
+  AccumResult hour;
+  hour.start = 1770620400u;
+  hour.span_s = 1500.0f;
+  hour.energy_kwh = 1.8f;
+  CapacityPeaks peaks;
+  capacity_peaks_add_hour(peaks, 4.1f);
+  capacity_peaks_close_day(peaks);
+  capacity_peaks_add_hour(peaks, 3.7f);
+  capacity_guard_update(hour, 4500.0f, peaks, t, 1770621900u, 1000);
+
+  for (int i = 0; i < PERF_PROBE_COUNT; ++i) perf_record(static_cast<PerfProbe>(i), 120 + i, 512);
+
+  size_t bytes = 0;
+  for (auto _ : state)
+  {
+    String out = cost_ledger_json();
+    out += capacity_guard_json();
+    out += perf_json();
+    bytes = out.length();
+    benchmark::DoNotOptimize(out.c_str());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * bytes);
+}
+BENCHMARK(BM_StatusJson);
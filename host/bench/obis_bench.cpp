@@ -0,0 +1,181 @@
+// Replays a recorded DSMR capture (60 telegrams, 10 s apart) through the
+// streaming OBIS parser and through the String line parser it replaced,
+// reporting bytes/s, telegrams/s and heap allocations per telegram.
+//
+// The host String is std::string with a 15-byte small-string buffer; the
+// ESP32 core's String keeps fewer bytes inline, so the legacy parser
+// allocates at least as often on the device as counted here.
+
+#include <Arduino.h>
+#include <benchmark/benchmark.h>
+
+#include "alloc_counter.h"
+#include "bench_data.h"
+#include "obis_parser.h"
+
+namespace {
+
+struct Readings {
+  float voltage_v[3];
+  float current_a[3];
+  float phase_power_w[3];
+  float import_power_w;
+  float export_power_w;
+  float import_energy_kwh_total;
+  float export_energy_kwh_total;
+};
+
+// ---- Legacy parser (han_reader.cpp before the OBIS state machine) ----
+
+struct LegacyState {
+  String lineBuf;
+  String meter_id;
+  Readings r;
+};
+
+float legacy_parse_obis_value(const String& line)
+{
+  const int open = line.indexOf('(');
+  const int close = line.indexOf('*', open + 1);
+  if (open < 0) return NAN;
+  const int end = (close > open) ? close : line.indexOf(')', open + 1);
+  if (end <= open) return NAN;
+
+  String num = line.substring(open + 1, end);
+  num.trim();
+  num.replace(',', '.');
+  return num.toFloat();
+}
+
+void legacy_parse_line(LegacyState& s, const String& line)
+{
+  Readings& r = s.r;
+  if (line.startsWith("/"))
+  {
+    s.meter_id = line;
+    return;
+  }
+
+  if (line.startsWith("1-0:32.7.0")) r.voltage_v[0] = legacy_parse_obis_value(line);
+  else if (line.startsWith("1-0:52.7.0")) r.voltage_v[1] = legacy_parse_obis_value(line);
+  else if (line.startsWith("1-0:72.7.0")) r.voltage_v[2] = legacy_parse_obis_value(line);
+  else if (line.startsWith("1-0:31.7.0")) r.current_a[0] = legacy_parse_obis_value(line);
+  else if (line.startsWith("1-0:51.7.0")) r.current_a[1] = legacy_parse_obis_value(line);
+  else if (line.startsWith("1-0:71.7.0")) r.current_a[2] = legacy_parse_obis_value(line);
+  else if (line.startsWith("1-0:21.7.0")) r.phase_power_w[0] = legacy_parse_obis_value(line) * 1000.0f;
+  else if (line.startsWith("1-0:41.7.0")) r.phase_power_w[1] = legacy_parse_obis_value(line) * 1000.0f;
+  else if (line.startsWith("1-0:61.7.0")) r.phase_power_w[2] = legacy_parse_obis_value(line) * 1000.0f;
+  else if (line.startsWith("1-0:1.7.0")) r.import_power_w = legacy_parse_obis_value(line) * 1000.0f;
+  else if (line.startsWith("1-0:2.7.0")) r.export_power_w = legacy_parse_obis_value(line) * 1000.0f;
+  else if (line.startsWith("1-0:1.8.0")) r.import_energy_kwh_total = legacy_parse_obis_value(line);
+  else if (line.startsWith("1-0:2.8.0")) r.export_energy_kwh_total = legacy_parse_obis_value(line);
+}
+
+// Returns the number of telegrams ('!' lines) seen.
+uint32_t legacy_feed(LegacyState& s, const std::string& bytes)
+{
+  uint32_t telegrams = 0;
+  for (char c : bytes)
+  {
+    if (c == '\r') continue;
+    if (c == '\n')
+    {
+      String line = s.lineBuf;
+      s.lineBuf = "";
+      line.trim();
+      if (line.length() == 0) continue;
+
+      legacy_parse_line(s, line);
+      if (line.startsWith("!")) ++telegrams;
+      continue;
+    }
+    if (s.lineBuf.length() < 220) s.lineBuf += c;
+  }
+  return telegrams;
+}
+
+// ---- Streaming parser, publishing the same fields ----
+
+uint32_t obis_feed(ObisParser& p, Readings& r, const std::string& bytes)
+{
+  uint32_t telegrams = 0;
+  for (char c : bytes)
+  {
+    const ObisEvent ev = obis_parser_feed(p, c);
+    switch (ev)
+    {
+      case OBIS_NONE: case OBIS_HEADER: break;
+      case OBIS_END: telegrams += obis_parser_telegram_ok(p) ? 1 : 0; break;
+      case OBIS_VOLTAGE_L1: r.voltage_v[0] = obis_parser_value(p); break;
+      case OBIS_VOLTAGE_L2: r.voltage_v[1] = obis_parser_value(p); break;
+      case OBIS_VOLTAGE_L3: r.voltage_v[2] = obis_parser_value(p); break;
+      case OBIS_CURRENT_L1: r.current_a[0] = obis_parser_value(p); break;
+      case OBIS_CURRENT_L2: r.current_a[1] = obis_parser_value(p); break;
+      case OBIS_CURRENT_L3: r.current_a[2] = obis_parser_value(p); break;
+      case OBIS_POWER_L1_KW: r.phase_power_w[0] = obis_parser_value(p) * 1000.0f; break;
+      case OBIS_POWER_L2_KW: r.phase_power_w[1] = obis_parser_value(p) * 1000.0f; break;
+      case OBIS_POWER_L3_KW: r.phase_power_w[2] = obis_parser_value(p) * 1000.0f; break;
+      case OBIS_IMPORT_POWER_KW: r.import_power_w = obis_parser_value(p) * 1000.0f; break;
+      case OBIS_EXPORT_POWER_KW: r.export_power_w = obis_parser_value(p) * 1000.0f; break;
+      case OBIS_IMPORT_ENERGY_KWH: r.import_energy_kwh_total = obis_parser_value(p); break;
+      case OBIS_EXPORT_ENERGY_KWH: r.export_energy_kwh_total = obis_parser_value(p); break;
+    }
+  }
+  return telegrams;
+}
+
+void report(benchmark::State& state, size_t bytes, uint32_t telegrams, uint64_t allocs)
+{
+  const int64_t iterations = static_cast<int64_t>(state.iterations());
+  state.SetBytesProcessed(iterations * static_cast<int64_t>(bytes));
+  state.SetItemsProcessed(iterations * telegrams);
+  state.counters["telegrams"] = telegrams;
+  state.counters["allocs_per_telegram"] =
+      (iterations > 0 && telegrams > 0) ? static_cast<double>(allocs) / (iterations * telegrams) : 0.0;
+}
+
+}  // namespace
+
+static void BM_ObisReplay(benchmark::State& state)
+{
+  const std::string capture = load_data_file("dsmr_capture.txt");
+  if (capture.empty())
+  {
+    state.SkipWithError("dsmr_capture.txt missing");
+    return;
+  }
+  ObisParser p;
+  obis_parser_reset(p);
+  Readings r = {};
+  uint32_t telegrams = 0;
+  const uint64_t allocs0 = alloc_count();
+  for (auto _ : state)
+  {
+    telegrams = obis_feed(p, r, capture);
+    benchmark::DoNotOptimize(r);
+  }
+  report(state, capture.size(), telegrams, alloc_count() - allocs0);
+}
+BENCHMARK(BM_ObisReplay);
+
+static void BM_ObisReplayLegacy(benchmark::State& state)
+{
+  const std::string capture = load_data_file("dsmr_capture.txt");
+  if (capture.empty())
+  {
+    state.SkipWithError("dsmr_capture.txt missing");
+    return;
+  }
+  LegacyState s;
+  s.lineBuf.reserve(160);
+  s.r = Readings();
+  uint32_t telegrams = 0;
+  const uint64_t allocs0 = alloc_count();
+  for (auto _ : state)
+  {
+    telegrams = legacy_feed(s, capture);
+    benchmark::DoNotOptimize(s.r);
+  }
+  report(state, capture.size(), telegrams, alloc_count() - allocs0);
+}
+BENCHMARK(BM_ObisReplayLegacy);
@@ -0,0 +1,162 @@
+// Recorded hvakosterstrommen payloads (24 hourly and 96 quarter-hour
+// prices) through the streaming price tokenizer and through the parser it
+// replaced, which needed the whole body in a String and searched it with
+// indexOf/substring. The legacy run looks up 23:00, the last hour, so both
+// make one pass over the payload; only the new parser yields every entry.
+
+#include <Arduino.h>
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "alloc_counter.h"
+#include "bench_data.h"
+#include "price_json.h"
+
+namespace {
+
+// ---- Legacy parser (price_engine.cpp before the streaming tokenizer) ----
+
+int legacy_hour_from_iso(const String& iso)
+{
+  // 2026-02-09T13:00:00+01:00
+  const int t = iso.indexOf('T');
+  if (t < 0 || t + 3 >= static_cast<int>(iso.length())) return -1;
+  return iso.substring(t + 1, t + 3).toInt();
+}
+
+bool legacy_parse_current_hour_price(const String& payload, int currentHour, float& out)
+{
+  int pos = 0;
+  while (true)
+  {
+    int ts = payload.indexOf("\"time_start\":\"", pos);
+    if (ts < 0) break;
+    int te = payload.indexOf('"', ts + 14);
+    if (te < 0) break;
+
+    String iso = payload.substring(ts + 14, te);
+    int h = legacy_hour_from_iso(iso);
+
+    int ps = payload.indexOf("\"NOK_per_kWh\":", te);
+    if (ps < 0) break;
+    int pe = payload.indexOf(',', ps);
+    if (pe < 0) pe = payload.indexOf('}', ps);
+    if (pe < 0) break;
+
+    String val = payload.substring(ps + 14, pe);
+    val.trim();
+
+    if (h == currentHour)
+    {
+      out = val.toFloat();
+      return true;
+    }
+
+    pos = pe + 1;
+  }
+
+  return false;
+}
+
+// The old parser pairs each time_start with the NOK_per_kWh after it. The
+// API (and the recorded files) put the price first, so on a real payload
+// it read the next hour's price and never found the last hour; reorder the
+// keys once so it does its intended work.
+std::string time_first(const std::string& body)
+{
+  std::string out;
+  size_t pos = 0;
+  while (true)
+  {
+    const size_t open = body.find('{', pos);
+    if (open == std::string::npos) break;
+    const size_t close = body.find('}', open);
+    const std::string entry = body.substr(open + 1, close - open - 1);
+    const size_t ts = entry.find("\"time_start\"");
+    const size_t comma = entry.rfind(',', ts);
+    out += out.empty() ? "[{" : ",{";
+    out += entry.substr(ts) + "," + entry.substr(0, comma) + "}";
+    pos = close + 1;
+  }
+  return out + "]";
+}
+
+void report(benchmark::State& state, size_t bytes, uint64_t allocs)
+{
+  const int64_t iterations = static_cast<int64_t>(state.iterations());
+  state.SetBytesProcessed(iterations * static_cast<int64_t>(bytes));
+  state.counters["allocs_per_payload"] = iterations > 0 ? static_cast<double>(allocs) / iterations : 0.0;
+}
+
+void price_json_bench(benchmark::State& state, const char* file)
+{
+  const std::string body = load_data_file(file);
+  if (body.empty())
+  {
+    state.SkipWithError("price payload missing");
+    return;
+  }
+  PriceJsonParser p;
+  float last = 0.0f;
+  const uint64_t allocs0 = alloc_count();
+  for (auto _ : state)
+  {
+    price_json_reset(p);
+    for (char c : body)
+    {
+      if (price_json_feed(p, c) == PJSON_ENTRY) last = p.nok_per_kwh;
+    }
+    benchmark::DoNotOptimize(last);
+  }
+  report(state, body.size(), alloc_count() - allocs0);
+  state.counters["entries"] = p.entries;
+}
+
+void price_legacy_bench(benchmark::State& state, const char* file)
+{
+  const std::string recorded = load_data_file(file);
+  if (recorded.empty())
+  {
+    state.SkipWithError("price payload missing");
+    return;
+  }
+  const std::string body = time_first(recorded);
+  float price = NAN;
+  bool found = false;
+  const uint64_t allocs0 = alloc_count();
+  for (auto _ : state)
+  {
+    const String payload(body);  // http.getString()
+    found = legacy_parse_current_hour_price(payload, 23, price);
+    benchmark::DoNotOptimize(price);
+  }
+  report(state, body.size(), alloc_count() - allocs0);
+  if (!found) state.SkipWithError("23:00 not found");
+}
+
+}  // namespace
+
+static void BM_PricePayloadHourly(benchmark::State& state)
+{
+  price_json_bench(state, "prices_NO1_hour.json");
+}
+BENCHMARK(BM_PricePayloadHourly);
+
+static void BM_PricePayloadHourlyLegacy(benchmark::State& state)
+{
+  price_legacy_bench(state, "prices_NO1_hour.json");
+}
+BENCHMARK(BM_PricePayloadHourlyLegacy);
+
+static void BM_PricePayload15Min(benchmark::State& state)
+{
+  price_json_bench(state, "prices_NO1_15m.json");
+}
+BENCHMARK(BM_PricePayload15Min);
+
+static void BM_PricePayload15MinLegacy(benchmark::State& state)
+{
+  price_legacy_bench(state, "prices_NO1_15m.json");
+}
+BENCHMARK(BM_PricePayload15MinLegacy);
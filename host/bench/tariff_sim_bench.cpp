@@ -0,0 +1,118 @@
+// A year of hourly household load (8760 slots) replayed against the three
+// built-in DSO profiles and the default CUSTOM tariff, as /status/tariff_sim
+// does. The load pass (sim_load_add: calendar byte and capacity peaks) and
+// the per-tariff replay are measured apart; the counters carry each
+// tariff's yearly grid cost so a run also shows the simulated result.
+
+#include <stdlib.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "config_store.h"
+#include "tariff_engine.h"
+#include "tariff_sim.h"
+
+namespace {
+
+const char* const kProfiles[] = {"CUSTOM", "ELVIA_EXAMPLE", "BKK_EXAMPLE", "TENSIO_EXAMPLE"};
+const size_t kProfileCount = sizeof(kProfiles) / sizeof(kProfiles[0]);
+
+struct Year {
+  std::vector<uint32_t> start;
+  std::vector<float> kwh;
+  std::vector<tm> local;
+};
+
+// Night base load, morning and evening peaks, more in winter, an EV charge
+// on weekday evenings.
+const Year& year_2025()
+{
+  static Year y;
+  if (!y.start.empty()) return y;
+  setenv("TZ", "CET-1CEST,M3.5.0/2,M10.5.0/3", 1);
+  tzset();
+  tm t0 = {};
+  t0.tm_year = 125;
+  t0.tm_mday = 1;
+  t0.tm_isdst = -1;
+  const uint32_t from = static_cast<uint32_t>(mktime(&t0));
+  for (uint32_t i = 0; i < 8760; ++i)
+  {
+    const uint32_t at = from + i * 3600;
+    const time_t e = static_cast<time_t>(at);
+    tm l;
+    localtime_r(&e, &l);
+    const bool winter = l.tm_mon <= 2 || l.tm_mon >= 10;
+    float kw = 0.5f;
+    if (l.tm_hour >= 6 && l.tm_hour < 9) kw += 1.5f;
+    if (l.tm_hour >= 16 && l.tm_hour < 22) kw += 2.0f;
+    if (winter) kw *= 1.8f;
+    if (l.tm_wday >= 1 && l.tm_wday <= 5 && l.tm_hour == 22 && l.tm_mday % 3 == 0) kw += 7.0f;
+    y.start.push_back(at);
+    y.kwh.push_back(kw);
+    y.local.push_back(l);
+  }
+  return y;
+}
+
+struct SimArrays {
+  std::vector<float> kwh = std::vector<float>(SIM_SLOTS_MAX);
+  std::vector<uint8_t> hour = std::vector<uint8_t>(SIM_SLOTS_MAX);
+  std::vector<uint8_t> cal = std::vector<uint8_t>(SIM_SLOTS_MAX);
+};
+
+void load_year(SimLoad& load, SimArrays& a, const Year& y)
+{
+  sim_load_init(load, a.kwh.data(), a.hour.data(), a.cal.data(), SIM_SLOTS_MAX, 3600);
+  for (size_t i = 0; i < y.start.size(); ++i) sim_load_add(load, y.start[i], y.kwh[i], y.local[i]);
+  sim_load_finish(load);
+}
+
+}  // namespace
+
+static void BM_TariffSimLoadYear(benchmark::State& state)
+{
+  const Year& y = year_2025();
+  SimArrays a;
+  SimLoad load;
+  for (auto _ : state)
+  {
+    load_year(load, a, y);
+    benchmark::DoNotOptimize(load.month_peak_kw[0]);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * load.count);
+  state.counters["slots"] = load.count;
+  state.counters["months"] = load.months;
+}
+BENCHMARK(BM_TariffSimLoadYear);
+
+static void BM_TariffSimYearAllProfiles(benchmark::State& state)
+{
+  const Year& y = year_2025();
+  SimArrays a;
+  SimLoad load;
+  load_year(load, a, y);
+
+  CompiledTariff tariffs[kProfileCount];
+  for (size_t p = 0; p < kProfileCount; ++p)
+  {
+    DeviceConfig cfg = config_load();
+    cfg.tariff_profile = kProfiles[p];
+    config_apply_tariff_profile(cfg, true);
+    tariff_compile(cfg, tariffs[p]);
+  }
+
+  SimResult results[kProfileCount];
+  for (auto _ : state)
+  {
+    for (size_t p = 0; p < kProfileCount; ++p) results[p] = tariff_sim_run(load, tariffs[p]);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * load.count * kProfileCount);
+  state.counters["kwh"] = results[0].kwh;
+  state.counters["charged_months"] = results[0].months;
+  for (size_t p = 0; p < kProfileCount; ++p) state.counters[std::string(kProfiles[p]) + "_nok"] = results[p].total_nok;
+}
+BENCHMARK(BM_TariffSimYearAllProfiles);
@@ -0,0 +1,44 @@
+#pragma once
+
+// Minimal Arduino core for the host build: types, String, timing and the
+// few ESP32 helpers the portable modules touch. Time is the host's
+// monotonic clock plus an offset tests can move (host_advance_ms).
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "WString.h"
+
+using std::max;
+using std::min;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void host_advance_ms(uint32_t ms);
+
+uint32_t esp_random();
+
+// SNTP is not started on the host; time() is the host clock.
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char* server2 = nullptr,
+                const char* server3 = nullptr);
+
+#if !defined(__GLIBC__) || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+class EspClass {
+ public:
+  uint32_t getFreeHeap() const { return 0; }
+  uint32_t getMinFreeHeap() const { return 0; }
+  uint64_t getEfuseMac() const { return 0x0000A1B2C3D4E5F6ULL; }
+};
+
+extern EspClass ESP;
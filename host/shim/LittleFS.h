@@ -0,0 +1,46 @@
+#pragma once
+
+// LittleFS stand-in over a host directory. Paths map below a root that tests
+// point at a temp directory (host_littlefs_root); files are plain stdio
+// files, so a test can "reboot" and read back what the module wrote.
+
+#include <Arduino.h>
+
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+class File {
+ public:
+  File() {}
+  explicit File(FILE* f) : f_(f, fclose) {}
+
+  explicit operator bool() const { return f_ != nullptr; }
+  size_t read(uint8_t* buf, size_t len) { return f_ ? fread(buf, 1, len, f_.get()) : 0; }
+  int read()
+  {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+  size_t write(const uint8_t* buf, size_t len) { return f_ ? fwrite(buf, 1, len, f_.get()) : 0; }
+  size_t size() const;
+  void close() { f_.reset(); }
+
+ private:
+  std::shared_ptr<FILE> f_;
+};
+
+class LittleFSFS {
+ public:
+  bool begin(bool formatOnFail = false);
+  File open(const char* path, const char* mode = FILE_READ);
+  bool exists(const char* path);
+  bool remove(const char* path);
+};
+
+extern LittleFSFS LittleFS;
+
+// Directory that stands in for the flash root; created if missing.
+void host_littlefs_root(const char* dir);
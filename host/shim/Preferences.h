@@ -0,0 +1,44 @@
+#pragma once
+
+// In-memory NVS stand-in. Namespaces live for the life of the process, so
+// a test can save, "reboot" (new Preferences object) and load again.
+
+#include <Arduino.h>
+
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false);
+  void end() {}
+  bool clear();
+  bool remove(const char* key);
+  bool isKey(const char* key);
+
+  size_t putBool(const char* key, bool v) { return putRaw(key, &v, sizeof(v)); }
+  size_t putInt(const char* key, int32_t v) { return putRaw(key, &v, sizeof(v)); }
+  size_t putUInt(const char* key, uint32_t v) { return putRaw(key, &v, sizeof(v)); }
+  size_t putULong(const char* key, uint32_t v) { return putRaw(key, &v, sizeof(v)); }
+  size_t putFloat(const char* key, float v) { return putRaw(key, &v, sizeof(v)); }
+  size_t putString(const char* key, const String& v) { return putRaw(key, v.c_str(), v.length() + 1); }
+  size_t putBytes(const char* key, const void* v, size_t len) { return putRaw(key, v, len); }
+
+  bool getBool(const char* key, bool def = false) { return get(key, def); }
+  int32_t getInt(const char* key, int32_t def = 0) { return get(key, def); }
+  uint32_t getUInt(const char* key, uint32_t def = 0) { return get(key, def); }
+  uint32_t getULong(const char* key, uint32_t def = 0) { return get(key, def); }
+  float getFloat(const char* key, float def = NAN) { return get(key, def); }
+  String getString(const char* key, const String& def = String());
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+ private:
+  size_t putRaw(const char* key, const void* v, size_t len);
+
+  template <typename T>
+  T get(const char* key, T def)
+  {
+    T v;
+    return getBytesLength(key) == sizeof(T) && getBytes(key, &v, sizeof(T)) == sizeof(T) ? v : def;
+  }
+
+  String ns_;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+// Host stand-in for the Arduino String: the subset the firmware uses, over
+// std::string. Numbers format like the ESP32 core (floats with a fixed
+// number of decimals, default 2).
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+class String {
+ public:
+  String() = default;
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  explicit String(char c) : s_(1, c) {}
+  explicit String(int v) : s_(std::to_string(v)) {}
+  explicit String(unsigned int v) : s_(std::to_string(v)) {}
+  explicit String(long v) : s_(std::to_string(v)) {}
+  explicit String(unsigned long v) : s_(std::to_string(v)) {}
+  explicit String(long long v) : s_(std::to_string(v)) {}
+  explicit String(unsigned long long v) : s_(std::to_string(v)) {}
+  explicit String(unsigned char v) : s_(std::to_string(v)) {}
+  explicit String(float v, unsigned char decimals = 2) { format(v, decimals); }
+  explicit String(double v, unsigned char decimals = 2) { format(v, decimals); }
+
+  unsigned int length() const { return static_cast<unsigned int>(s_.size()); }
+  bool isEmpty() const { return s_.empty(); }
+  const char* c_str() const { return s_.c_str(); }
+  bool reserve(unsigned int n)
+  {
+    s_.reserve(n);
+    return true;
+  }
+  char charAt(unsigned int i) const { return i < s_.size() ? s_[i] : '\0'; }
+  char operator[](unsigned int i) const { return charAt(i); }
+
+  String& operator+=(const String& o)
+  {
+    s_ += o.s_;
+    return *this;
+  }
+  String& operator+=(const char* o)
+  {
+    if (o) s_ += o;
+    return *this;
+  }
+  String& operator+=(char c)
+  {
+    s_ += c;
+    return *this;
+  }
+  bool concat(const String& o)
+  {
+    s_ += o.s_;
+    return true;
+  }
+
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o) const { return o && s_ == o; }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+  bool operator!=(const char* o) const { return !(*this == o); }
+  bool operator<(const String& o) const { return s_ < o.s_; }
+  bool equals(const String& o) const { return s_ == o.s_; }
+  bool equalsIgnoreCase(const String& o) const;
+  bool startsWith(const String& p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+  bool endsWith(const String& p) const
+  {
+    return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0;
+  }
+
+  int indexOf(char c, unsigned int from = 0) const { return pos(s_.find(c, from)); }
+  int indexOf(const String& p, unsigned int from = 0) const { return pos(s_.find(p.s_, from)); }
+  int lastIndexOf(char c) const { return pos(s_.rfind(c)); }
+  String substring(unsigned int from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const
+  {
+    if (from > to) std::swap(from, to);
+    if (from >= s_.size()) return String();
+    return String(s_.substr(from, to - from));
+  }
+
+  void trim();
+  void toUpperCase();
+  void toLowerCase();
+  void replace(const String& from, const String& to);
+  void replace(char from, char to)
+  {
+    for (char& c : s_)
+    {
+      if (c == from) c = to;
+    }
+  }
+  void remove(unsigned int index, unsigned int count = 0xFFFFFFFFu)
+  {
+    if (index < s_.size()) s_.erase(index, count);
+  }
+
+  long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s_.c_str(), nullptr); }
+  double toDouble() const { return strtod(s_.c_str(), nullptr); }
+
+  friend String operator+(const String& a, const String& b)
+  {
+    String r(a);
+    r += b;
+    return r;
+  }
+  friend String operator+(const String& a, const char* b)
+  {
+    String r(a);
+    r += b;
+    return r;
+  }
+  friend String operator+(const char* a, const String& b)
+  {
+    String r(a);
+    r += b;
+    return r;
+  }
+  friend String operator+(const String& a, char b)
+  {
+    String r(a);
+    r += b;
+    return r;
+  }
+
+ private:
+  static int pos(size_t p) { return p == std::string::npos ? -1 : static_cast<int>(p); }
+  void format(double v, unsigned char decimals);
+
+  std::string s_;
+};
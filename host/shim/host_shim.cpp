@@ -0,0 +1,245 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+
+#include <sys/stat.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+EspClass ESP;
+
+static uint64_t g_offset_us = 0;
+
+static uint64_t now_us()
+{
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return static_cast<uint64_t>(duration_cast<microseconds>(steady_clock::now() - start).count()) + g_offset_us;
+}
+
+uint32_t millis()
+{
+  return static_cast<uint32_t>(now_us() / 1000ULL);
+}
+
+uint32_t micros()
+{
+  return static_cast<uint32_t>(now_us());
+}
+
+void delay(uint32_t ms)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void host_advance_ms(uint32_t ms)
+{
+  g_offset_us += static_cast<uint64_t>(ms) * 1000ULL;
+}
+
+uint32_t esp_random()
+{
+  // xorshift32: deterministic across runs.
+  static uint32_t x = 2463534242u;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+void configTime(long, int, const char*, const char*, const char*) {}
+
+#if !defined(__GLIBC__) || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char* dst, const char* src, size_t size)
+{
+  const size_t len = strlen(src);
+  if (size > 0)
+  {
+    const size_t n = (len < size - 1) ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+#endif
+
+// ---- String ----
+
+static char lower(char c)
+{
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool String::equalsIgnoreCase(const String& o) const
+{
+  if (s_.size() != o.s_.size()) return false;
+  for (size_t i = 0; i < s_.size(); ++i)
+  {
+    if (lower(s_[i]) != lower(o.s_[i])) return false;
+  }
+  return true;
+}
+
+void String::trim()
+{
+  const char* ws = " \t\r\n";
+  const size_t b = s_.find_first_not_of(ws);
+  if (b == std::string::npos)
+  {
+    s_.clear();
+    return;
+  }
+  s_ = s_.substr(b, s_.find_last_not_of(ws) - b + 1);
+}
+
+void String::toUpperCase()
+{
+  for (char& c : s_)
+  {
+    if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+  }
+}
+
+void String::toLowerCase()
+{
+  for (char& c : s_) c = lower(c);
+}
+
+void String::replace(const String& from, const String& to)
+{
+  if (from.s_.empty()) return;
+  size_t p = 0;
+  while ((p = s_.find(from.s_, p)) != std::string::npos)
+  {
+    s_.replace(p, from.s_.size(), to.s_);
+    p += to.s_.size();
+  }
+}
+
+void String::format(double v, unsigned char decimals)
+{
+  // The ESP32 core prints "nan"/"inf" too; callers that emit JSON must
+  // handle non-finite values themselves.
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+  s_ = buf;
+}
+
+// ---- Preferences ----
+
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>>& store()
+{
+  static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> s;
+  return s;
+}
+
+bool Preferences::begin(const char* name, bool)
+{
+  ns_ = name;
+  return true;
+}
+
+bool Preferences::clear()
+{
+  store()[ns_.c_str()].clear();
+  return true;
+}
+
+bool Preferences::remove(const char* key)
+{
+  return store()[ns_.c_str()].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key)
+{
+  return store()[ns_.c_str()].count(key) > 0;
+}
+
+size_t Preferences::putRaw(const char* key, const void* v, size_t len)
+{
+  const uint8_t* p = static_cast<const uint8_t*>(v);
+  store()[ns_.c_str()][key].assign(p, p + len);
+  return len;
+}
+
+String Preferences::getString(const char* key, const String& def)
+{
+  auto& ns = store()[ns_.c_str()];
+  auto it = ns.find(key);
+  if (it == ns.end() || it->second.empty()) return def;
+  return String(reinterpret_cast<const char*>(it->second.data()));
+}
+
+size_t Preferences::getBytesLength(const char* key)
+{
+  auto& ns = store()[ns_.c_str()];
+  auto it = ns.find(key);
+  return it == ns.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen)
+{
+  auto& ns = store()[ns_.c_str()];
+  auto it = ns.find(key);
+  if (it == ns.end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+// ---- LittleFS ----
+
+LittleFSFS LittleFS;
+
+static std::string& fs_root()
+{
+  static std::string root = "littlefs";
+  return root;
+}
+
+static std::string fs_path(const char* path)
+{
+  return fs_root() + path;
+}
+
+void host_littlefs_root(const char* dir)
+{
+  fs_root() = dir;
+  mkdir(dir, 0755);
+}
+
+size_t File::size() const
+{
+  if (!f_) return 0;
+  struct stat st;
+  return fstat(fileno(f_.get()), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+}
+
+bool LittleFSFS::begin(bool)
+{
+  mkdir(fs_root().c_str(), 0755);
+  return true;
+}
+
+File LittleFSFS::open(const char* path, const char* mode)
+{
+  const char* m = "rb";
+  if (strcmp(mode, FILE_WRITE) == 0) m = "wb";
+  else if (strcmp(mode, FILE_APPEND) == 0) m = "ab";
+  FILE* f = fopen(fs_path(path).c_str(), m);
+  return f ? File(f) : File();
+}
+
+bool LittleFSFS::exists(const char* path)
+{
+  struct stat st;
+  return stat(fs_path(path).c_str(), &st) == 0;
+}
+
+bool LittleFSFS::remove(const char* path)
+{
+  return ::remove(fs_path(path).c_str()) == 0;
+}
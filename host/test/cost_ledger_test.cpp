@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include "cost_ledger.h"
+
+namespace {
+
+// Flat grid rate: 0.40 energy charge, 0.10 elavgift, 0.01 Enova, 25 % VAT.
+CompiledTariff flat_tariff()
+{
+  CompiledTariff t = CompiledTariff();
+  for (uint8_t i = 0; i < TARIFF_RATE_SLOTS; ++i) t.energy_nok_kwh[i] = 0.40f;
+  t.elavgift_nok_kwh = 0.10f;
+  t.enova_nok_kwh = 0.01f;
+  t.vat_factor = 1.25f;
+  return t;
+}
+
+tm noon()
+{
+  tm local = {};
+  local.tm_year = 2026 - 1900;
+  local.tm_mon = 2;
+  local.tm_mday = 4;  // Wednesday
+  local.tm_wday = 3;
+  local.tm_hour = 12;
+  return local;
+}
+
+CostWindowState open_window(CostSpan span)
+{
+  CostLedgerState st;
+  cost_ledger_export(st);
+  return st.open[span];
+}
+
+}  // namespace
+
+TEST(CostLedger, ChargesEveryPartWithVat)
+{
+  cost_ledger_import(CostLedgerState());
+  cost_ledger_charge(1.0f, 1.0f, flat_tariff(), noon());
+  const CostWindowState w = open_window(COST_DAY);
+  EXPECT_EQ(1000000, w.energy_mwh);
+  EXPECT_EQ(1000000, w.unok[COST_SPOT]);
+  EXPECT_EQ(400000, w.unok[COST_ENERGY]);
+  EXPECT_EQ(100000, w.unok[COST_ELAVGIFT]);
+  EXPECT_EQ(10000, w.unok[COST_ENOVA]);
+  EXPECT_NEAR(377500, w.unok[COST_VAT], 2);
+  EXPECT_EQ(0u, w.unpriced_min);
+}
+
+TEST(CostLedger, MissingSpotPriceIsCounted)
+{
+  cost_ledger_import(CostLedgerState());
+  cost_ledger_charge(1.0f, 1.0f, flat_tariff(), noon());
+  cost_ledger_charge(1.0f, NAN, flat_tariff(), noon());
+  cost_ledger_charge(1.0f, NAN, flat_tariff(), noon());
+  for (uint8_t s = 0; s < COST_SPAN_COUNT; ++s)
+  {
+    const CostWindowState w = open_window(static_cast<CostSpan>(s));
+    EXPECT_EQ(2u, w.unpriced_min);
+    EXPECT_EQ(1000000, w.unok[COST_SPOT]);
+    EXPECT_EQ(1200000, w.unok[COST_ENERGY]);
+  }
+}
+
+TEST(CostLedger, CorrectionChargedAtAverageRateAndFlagged)
+{
+  cost_ledger_import(CostLedgerState());
+  cost_ledger_charge(1.0f, 1.0f, flat_tariff(), noon());
+  cost_ledger_charge(1.0f, 0.5f, flat_tariff(), noon());
+  ASSERT_TRUE(cost_ledger_charge_estimated(1.0f));
+
+  const CostWindowState w = open_window(COST_MONTH);
+  EXPECT_EQ(3000000, w.energy_mwh);
+  EXPECT_EQ(1000000, w.estimated_mwh);
+  EXPECT_EQ(2250000, w.unok[COST_SPOT]);  // 1.5 NOK for 2 kWh, then half again
+  EXPECT_EQ(1200000, w.unok[COST_ENERGY]);
+
+  int64_t metered = 0;
+  for (uint8_t i = 0; i < COST_PART_COUNT; ++i) metered += w.unok[i];
+  EXPECT_NEAR(metered / 3, w.estimated_unok, 2);
+
+  // A negative correction (integration overshot the register) takes it back.
+  ASSERT_TRUE(cost_ledger_charge_estimated(-1.0f));
+  const CostWindowState back = open_window(COST_DAY);
+  EXPECT_EQ(2000000, back.energy_mwh);
+  EXPECT_EQ(0, back.estimated_mwh);
+  EXPECT_NEAR(1500000, back.unok[COST_SPOT], 2);
+}
+
+TEST(CostLedger, CorrectionWaitsForMeteredEnergy)
+{
+  cost_ledger_import(CostLedgerState());
+  EXPECT_FALSE(cost_ledger_charge_estimated(2.0f));
+  const CostWindowState w = open_window(COST_DAY);
+  EXPECT_EQ(0, w.energy_mwh);
+  EXPECT_EQ(0, w.estimated_mwh);
+}
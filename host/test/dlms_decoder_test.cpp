@@ -0,0 +1,282 @@
+#include <gtest/gtest.h>
+
+#include <math.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench_data.h"
+#include "dlms_decoder.h"
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+// host/data/hdlc_corpus.txt: "<name> <hex>" per line, '#' comments.
+const std::map<std::string, Bytes>& corpus()
+{
+  static std::map<std::string, Bytes> frames;
+  if (!frames.empty()) return frames;
+  std::istringstream in(load_data_file("hdlc_corpus.txt"));
+  std::string line;
+  while (std::getline(in, line))
+  {
+    if (line.empty() || line[0] == '#') continue;
+    const size_t space = line.find(' ');
+    Bytes b;
+    for (size_t i = space + 1; i + 1 < line.size(); i += 2) b.push_back(static_cast<uint8_t>(std::stoul(line.substr(i, 2), nullptr, 16)));
+    frames[line.substr(0, space)] = b;
+  }
+  return frames;
+}
+
+// Bit-by-bit CRC-16/X.25, independent of the decoder's table.
+uint16_t crc_x25(const uint8_t* data, size_t len)
+{
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; ++i)
+  {
+    crc ^= data[i];
+    for (int b = 0; b < 8; ++b) crc = (crc & 1) ? static_cast<uint16_t>((crc >> 1) ^ 0x8408) : crc >> 1;
+  }
+  return static_cast<uint16_t>(crc ^ 0xFFFF);
+}
+
+struct Decoded {
+  int frames = 0;
+  std::map<ObisEvent, DlmsValue> values;
+  std::string header;
+  uint8_t count = 0;
+};
+
+Decoded decode(HdlcDecoder& d, const Bytes& bytes)
+{
+  Decoded r;
+  DlmsValue out[DLMS_MAX_VALUES];
+  for (uint8_t b : bytes)
+  {
+    if (!hdlc_decoder_feed(d, b)) continue;
+    ++r.frames;
+    r.count = dlms_decode_frame(d, out);
+    for (uint8_t i = 0; i < r.count; ++i)
+    {
+      if (out[i].field == OBIS_HEADER) r.header.assign(out[i].text, out[i].text_len);
+      else r.values[out[i].field] = out[i];
+    }
+  }
+  return r;
+}
+
+Decoded decode(const std::string& name)
+{
+  const auto it = corpus().find(name);
+  EXPECT_NE(corpus().end(), it) << name;
+  HdlcDecoder d;
+  hdlc_decoder_reset(d);
+  return it == corpus().end() ? Decoded() : decode(d, it->second);
+}
+
+float value(const Decoded& r, ObisEvent field)
+{
+  const auto it = r.values.find(field);
+  return it == r.values.end() ? NAN : it->second.value;
+}
+
+int64_t milli(const Decoded& r, ObisEvent field)
+{
+  const auto it = r.values.find(field);
+  return it == r.values.end() ? -1 : it->second.milli;
+}
+
+}  // namespace
+
+TEST(HdlcCrc, CheckValue)
+{
+  const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  EXPECT_EQ(0x906E, hdlc_crc16(check, sizeof(check)));
+  EXPECT_EQ(0x906E, crc_x25(check, sizeof(check)));
+}
+
+TEST(HdlcCrc, CorpusChecksumsIndependentlyValid)
+{
+  ASSERT_EQ(10u, corpus().size());
+  for (const auto& kv : corpus())
+  {
+    const Bytes& f = kv.second;
+    ASSERT_GE(f.size(), 12u) << kv.first;
+    const size_t n = f.size() - 2;  // without flags
+    const uint8_t* body = f.data() + 1;
+    EXPECT_EQ(crc_x25(body, n - 2), body[n - 2] | (body[n - 1] << 8)) << kv.first;
+    EXPECT_EQ(hdlc_crc16(body, n - 2), crc_x25(body, n - 2)) << kv.first;
+  }
+}
+
+TEST(HdlcDecoder, AllCorpusFramesAccepted)
+{
+  for (const auto& kv : corpus())
+  {
+    HdlcDecoder d;
+    hdlc_decoder_reset(d);
+    d.frames_ok = d.frames_bad = 0;
+    EXPECT_EQ(1, decode(d, kv.second).frames) << kv.first;
+    EXPECT_EQ(0u, d.frames_bad) << kv.first;
+  }
+}
+
+TEST(HdlcDecoder, CorruptedInfoFailsFcs)
+{
+  Bytes f = corpus().at("aidon_list2_3p");
+  f[40] ^= 0x01;
+  HdlcDecoder d;
+  hdlc_decoder_reset(d);
+  d.frames_bad = 0;
+  EXPECT_EQ(0, decode(d, f).frames);
+  EXPECT_EQ(1u, d.frames_bad);
+}
+
+TEST(HdlcDecoder, CorruptedHeaderFailsHcs)
+{
+  // Flip a header checksum byte and repair the FCS, so only the HCS is wrong.
+  Bytes f = corpus().at("kaifa_list2_3p");
+  const size_t hcs = 1 + 2 + 3 + 1;  // flag, format, address 01 / 02 01, control
+  f[hcs] ^= 0xFF;
+  const size_t n = f.size() - 2;
+  const uint16_t fcs = crc_x25(f.data() + 1, n - 2);
+  f[n - 1] = static_cast<uint8_t>(fcs & 0xFF);
+  f[n] = static_cast<uint8_t>(fcs >> 8);
+  HdlcDecoder d;
+  hdlc_decoder_reset(d);
+  EXPECT_EQ(0, decode(d, f).frames);
+}
+
+TEST(HdlcDecoder, NonHdlcFormatRejected)
+{
+  Bytes f = corpus().at("aidon_list1");
+  f[1] = 0x30;
+  HdlcDecoder d;
+  hdlc_decoder_reset(d);
+  d.frames_bad = 0;
+  EXPECT_EQ(0, decode(d, f).frames);
+  EXPECT_EQ(1u, d.frames_bad);
+}
+
+TEST(HdlcDecoder, StreamWithSharedFlagsAndNoise)
+{
+  // Noise without flags, then every frame back to back with one flag between.
+  Bytes stream = {0x00, 0xFF, 0x13, 0x55};
+  for (const auto& kv : corpus())
+  {
+    const Bytes& f = kv.second;
+    stream.insert(stream.end(), stream.empty() || stream.back() != 0x7E ? f.begin() : f.begin() + 1, f.end());
+  }
+  HdlcDecoder d;
+  hdlc_decoder_reset(d);
+  EXPECT_EQ(10, decode(d, stream).frames);
+}
+
+TEST(DlmsDecode, AidonList1)
+{
+  const Decoded r = decode("aidon_list1");
+  EXPECT_EQ(1, r.count);
+  EXPECT_FLOAT_EQ(0.503f, value(r, OBIS_IMPORT_POWER_KW));
+}
+
+TEST(DlmsDecode, AidonList2ThreePhase)
+{
+  const Decoded r = decode("aidon_list2_3p");
+  EXPECT_EQ(9, r.count);
+  EXPECT_EQ("7359992890941742", r.header);
+  EXPECT_FLOAT_EQ(1.509f, value(r, OBIS_IMPORT_POWER_KW));
+  EXPECT_FLOAT_EQ(0.0f, value(r, OBIS_EXPORT_POWER_KW));
+  EXPECT_FLOAT_EQ(5.9f, value(r, OBIS_CURRENT_L1));
+  EXPECT_FLOAT_EQ(7.2f, value(r, OBIS_CURRENT_L2));
+  EXPECT_FLOAT_EQ(1.3f, value(r, OBIS_CURRENT_L3));
+  EXPECT_FLOAT_EQ(236.1f, value(r, OBIS_VOLTAGE_L1));
+  EXPECT_FLOAT_EQ(235.7f, value(r, OBIS_VOLTAGE_L2));
+  EXPECT_FLOAT_EQ(237.3f, value(r, OBIS_VOLTAGE_L3));
+  EXPECT_EQ(5900, milli(r, OBIS_CURRENT_L1));
+}
+
+TEST(DlmsDecode, AidonList3Energy)
+{
+  const Decoded r = decode("aidon_list3_3p");
+  EXPECT_EQ(11, r.count);
+  EXPECT_EQ(12345670, milli(r, OBIS_IMPORT_ENERGY_KWH));
+  EXPECT_EQ(890, milli(r, OBIS_EXPORT_ENERGY_KWH));
+  EXPECT_NEAR(12345.67f, value(r, OBIS_IMPORT_ENERGY_KWH), 0.01f);
+}
+
+TEST(DlmsDecode, KaifaList1)
+{
+  const Decoded r = decode("kaifa_list1");
+  EXPECT_EQ(1, r.count);
+  EXPECT_FLOAT_EQ(1.43f, value(r, OBIS_IMPORT_POWER_KW));
+}
+
+TEST(DlmsDecode, KaifaList2ThreePhase)
+{
+  const Decoded r = decode("kaifa_list2_3p");
+  EXPECT_EQ(9, r.count);
+  EXPECT_EQ("6970631401753985", r.header);
+  EXPECT_FLOAT_EQ(1.43f, value(r, OBIS_IMPORT_POWER_KW));
+  EXPECT_FLOAT_EQ(1.852f, value(r, OBIS_CURRENT_L1));
+  EXPECT_FLOAT_EQ(1.694f, value(r, OBIS_CURRENT_L2));
+  EXPECT_FLOAT_EQ(1.836f, value(r, OBIS_CURRENT_L3));
+  EXPECT_FLOAT_EQ(239.8f, value(r, OBIS_VOLTAGE_L1));
+  EXPECT_FLOAT_EQ(240.1f, value(r, OBIS_VOLTAGE_L2));
+  EXPECT_FLOAT_EQ(239.7f, value(r, OBIS_VOLTAGE_L3));
+}
+
+TEST(DlmsDecode, KaifaList3Energy)
+{
+  const Decoded r = decode("kaifa_list3_3p");
+  EXPECT_EQ(11, r.count);
+  EXPECT_EQ("6970631401753985", r.header);
+  EXPECT_EQ(12345678, milli(r, OBIS_IMPORT_ENERGY_KWH));
+  EXPECT_EQ(9012, milli(r, OBIS_EXPORT_ENERGY_KWH));
+}
+
+TEST(DlmsDecode, KaifaList2SinglePhase)
+{
+  const Decoded r = decode("kaifa_list2_1p");
+  EXPECT_EQ(5, r.count);
+  EXPECT_FLOAT_EQ(2.21f, value(r, OBIS_IMPORT_POWER_KW));
+  EXPECT_FLOAT_EQ(0.015f, value(r, OBIS_EXPORT_POWER_KW));
+  EXPECT_FLOAT_EQ(9.634f, value(r, OBIS_CURRENT_L1));
+  EXPECT_FLOAT_EQ(230.2f, value(r, OBIS_VOLTAGE_L1));
+  EXPECT_EQ(0u, r.values.count(OBIS_VOLTAGE_L2));
+}
+
+TEST(DlmsDecode, KaifaList2ItWithoutI2)
+{
+  const Decoded r = decode("kaifa_list2_it");
+  EXPECT_EQ(8, r.count);
+  EXPECT_FLOAT_EQ(7.8f, value(r, OBIS_CURRENT_L1));
+  EXPECT_EQ(0u, r.values.count(OBIS_CURRENT_L2));
+  EXPECT_FLOAT_EQ(7.65f, value(r, OBIS_CURRENT_L3));
+  EXPECT_FLOAT_EQ(230.1f, value(r, OBIS_VOLTAGE_L1));
+  EXPECT_FLOAT_EQ(230.5f, value(r, OBIS_VOLTAGE_L3));
+}
+
+TEST(DlmsDecode, KamstrupList2ThreePhase)
+{
+  const Decoded r = decode("kamstrup_list2_3p");
+  EXPECT_EQ(9, r.count);
+  EXPECT_EQ("5706567000000000", r.header);
+  EXPECT_FLOAT_EQ(1.479f, value(r, OBIS_IMPORT_POWER_KW));
+  EXPECT_FLOAT_EQ(3.56f, value(r, OBIS_CURRENT_L1));
+  EXPECT_FLOAT_EQ(2.54f, value(r, OBIS_CURRENT_L2));
+  EXPECT_FLOAT_EQ(0.89f, value(r, OBIS_CURRENT_L3));
+  EXPECT_FLOAT_EQ(233.0f, value(r, OBIS_VOLTAGE_L1));
+  EXPECT_FLOAT_EQ(232.0f, value(r, OBIS_VOLTAGE_L3));
+}
+
+TEST(DlmsDecode, KamstrupList3Energy)
+{
+  const Decoded r = decode("kamstrup_list3_3p");
+  EXPECT_EQ(11, r.count);
+  EXPECT_EQ(12345670, milli(r, OBIS_IMPORT_ENERGY_KWH));
+  EXPECT_EQ(0, milli(r, OBIS_EXPORT_ENERGY_KWH));
+}
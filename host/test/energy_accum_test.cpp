@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "energy_accum.h"
+
+namespace {
+
+const uint32_t kDay = 1767222000UL;  // 2026-01-01 00:00 CET
+
+// Fresh accumulators with every window opened at kDay.
+void reset_windows()
+{
+  accum_import(AccumState());
+  for (uint8_t p = 0; p < ACC_PERIOD_COUNT; ++p) accum_set_start(static_cast<AccumPeriod>(p), kDay);
+}
+
+// Constant import power for the given number of seconds, one sample per second.
+void run(float w, uint32_t seconds)
+{
+  for (uint32_t i = 0; i < seconds; ++i) accum_sample(w, 0.0f, w, 0.0f, 0.0f, 1000);
+}
+
+}  // namespace
+
+TEST(EnergyAccum, IntegrationFillsEveryWindow)
+{
+  reset_windows();
+  run(3600.0f, 60);
+  for (uint8_t p = 0; p < ACC_PERIOD_COUNT; ++p)
+  {
+    EXPECT_NEAR(0.06f, accum_energy_kwh(static_cast<AccumPeriod>(p)), 1e-6f) << int(p);
+  }
+  EXPECT_NEAR(3600.0f, accum_current(ACC_HOUR).avg_w, 0.01f);
+}
+
+TEST(EnergyAccum, RegisterCorrectionOnlyInDayMonthYear)
+{
+  reset_windows();
+  accum_register(1000000, 5000);
+  run(1000.0f, 36);  // 10 Wh integrated
+  // The meter saw 510 Wh: 500 Wh were missed (stale link, gap).
+  EXPECT_NEAR(500.0f, accum_register(1000510, 5000), 0.01f);
+
+  EXPECT_NEAR(0.010f, accum_energy_kwh(ACC_MINUTE), 1e-6f);
+  EXPECT_NEAR(0.010f, accum_energy_kwh(ACC_QUARTER), 1e-6f);
+  EXPECT_NEAR(0.010f, accum_energy_kwh(ACC_HOUR), 1e-6f);
+  EXPECT_NEAR(1000.0f, accum_current(ACC_HOUR).avg_w, 0.01f);
+  EXPECT_NEAR(0.510f, accum_energy_kwh(ACC_DAY), 1e-6f);
+  EXPECT_NEAR(0.510f, accum_energy_kwh(ACC_MONTH), 1e-6f);
+  EXPECT_NEAR(0.510f, accum_energy_kwh(ACC_YEAR), 1e-6f);
+}
+
+TEST(EnergyAccum, ExportCorrectionFollowsSameRule)
+{
+  reset_windows();
+  accum_register(1000, 2000);
+  accum_register(1000, 2250);
+  EXPECT_NEAR(0.0f, accum_current(ACC_HOUR).export_kwh, 1e-6f);
+  EXPECT_NEAR(0.25f, accum_current(ACC_DAY).export_kwh, 1e-6f);
+}
+
+TEST(EnergyAccum, CheckpointRoundTripKeepsCorrectionsInLongWindows)
+{
+  reset_windows();
+  accum_register(1000, -1);
+  run(1800.0f, 20);  // 10 Wh
+  accum_register(1110, -1);
+
+  AccumState st;
+  accum_export(st);
+  accum_import(st);
+  EXPECT_NEAR(0.010f, accum_energy_kwh(ACC_HOUR), 1e-6f);
+  EXPECT_NEAR(0.110f, accum_energy_kwh(ACC_DAY), 1e-6f);
+
+  run(1800.0f, 20);
+  EXPECT_NEAR(0.020f, accum_energy_kwh(ACC_HOUR), 1e-6f);
+  EXPECT_NEAR(0.120f, accum_energy_kwh(ACC_DAY), 1e-6f);
+}
+
+TEST(EnergyAccum, AnchorSaveRestore)
+{
+  reset_windows();
+  accum_register(1000, 500);
+  run(3600.0f, 5);  // 5 Wh pending
+  const AccumAnchor a = accum_anchor_save();
+
+  // Readings from another meter (a replay) re-anchor...
+  accum_register(9000000, 0);
+  accum_register(9000100, 0);
+  // ...and restoring puts the live anchor and pending energy back.
+  accum_anchor_restore(a);
+  const float corr = accum_register(1020, 500);
+  EXPECT_NEAR(15.0f, corr, 0.01f);
+  EXPECT_EQ(1020, accum_register_stats().import_wh);
+}
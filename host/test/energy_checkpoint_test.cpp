@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include "capacity_peaks.h"
+#include "energy_accum.h"
+#include "energy_checkpoint.h"
+
+namespace {
+
+const uint32_t kDay = 1767222000UL;  // 2026-01-01 00:00 CET
+
+CapacityPeaks g_peaks;
+
+// Same as the firmware's collectCheckpoint, minus the cost ledger.
+void collect(EnergyCheckpoint& ck)
+{
+  accum_export(ck.accum);
+  ck.capacity = g_peaks;
+}
+
+void run(float w, uint32_t seconds)
+{
+  for (uint32_t i = 0; i < seconds; ++i) accum_sample(w, 0.0f, w, 0.0f, 0.0f, 1000);
+}
+
+}  // namespace
+
+// Boot after a power cut: the checkpoint brings back the open hour, and the
+// first register reading books what was metered while the device was down.
+// That gap energy belongs to the day, not to the restored hour's average.
+TEST(EnergyCheckpoint, ReconciliationLeavesHourAndCapacityPeaksAlone)
+{
+  accum_import(AccumState());
+  for (uint8_t p = 0; p < ACC_PERIOD_COUNT; ++p) accum_set_start(static_cast<AccumPeriod>(p), kDay);
+  g_peaks = CapacityPeaks();
+
+  accum_register(1000000, -1);
+  run(2000.0f, 3600);
+  accum_register(1002000, -1);
+  const AccumResult first = accum_close(ACC_HOUR, kDay + 3600);
+  EXPECT_NEAR(2000.0f, first.avg_w, 0.01f);
+  capacity_peaks_add_hour(g_peaks, first.avg_w / 1000.0f);
+
+  run(1000.0f, 900);  // 250 Wh into the next hour, then the power goes
+  EnergyCheckpoint ck;
+  energy_checkpoint_begin(collect, ck);
+  ASSERT_TRUE(energy_checkpoint_save(true));
+
+  // Reboot: wipe RAM state, restore from NVS.
+  accum_import(AccumState());
+  g_peaks = CapacityPeaks();
+  ASSERT_TRUE(energy_checkpoint_begin(collect, ck));
+  accum_import(ck.accum);
+  g_peaks = ck.capacity;
+
+  // Down for three hours at 2 kW: the register has moved 6.25 kWh since the
+  // last reading, of which 250 Wh were integrated before the cut.
+  const float corrWh = accum_register(1008250, -1);
+  EXPECT_NEAR(6000.0f, corrWh, 0.01f);
+
+  const AccumResult hour = accum_close(ACC_HOUR, kDay + 5 * 3600);
+  EXPECT_NEAR(0.25f, hour.energy_kwh, 1e-5f);
+  EXPECT_NEAR(1000.0f, hour.avg_w, 0.01f);
+  capacity_peaks_add_hour(g_peaks, hour.avg_w / 1000.0f);
+  EXPECT_FLOAT_EQ(2.0f, g_peaks.day_max_kw);
+  EXPECT_FLOAT_EQ(2.0f, capacity_peaks_mean_kw(g_peaks));
+
+  EXPECT_NEAR(8.25f, accum_energy_kwh(ACC_DAY), 1e-4f);
+}
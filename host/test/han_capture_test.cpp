@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "bench_data.h"
+#include "dlms_decoder.h"
+#include "han_capture_format.h"
+#include "obis_parser.h"
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+Bytes load_capture(const char* name)
+{
+  const std::string s = load_data_file(name);
+  return Bytes(s.begin(), s.end());
+}
+
+struct Replayed {
+  int records = 0;
+  uint64_t bytes = 0;
+  uint64_t ms = 0;
+  Bytes stream;
+};
+
+Replayed replay(const Bytes& capture)
+{
+  Replayed r;
+  HanCaptureReader reader;
+  EXPECT_TRUE(han_capture_reader_open(reader, capture.data(), capture.size()));
+  HanCaptureRecord rec;
+  while (han_capture_reader_next(reader, rec))
+  {
+    ++r.records;
+    r.bytes += rec.len;
+    r.ms += rec.dt_ms;
+    r.stream.insert(r.stream.end(), rec.data, rec.data + rec.len);
+  }
+  return r;
+}
+
+}  // namespace
+
+TEST(HanCapture, VarintRoundTrip)
+{
+  const uint32_t values[] = {0, 1, 127, 128, 300, 16383, 16384, 2097151, 0xFFFFFFFFu};
+  for (uint32_t v : values)
+  {
+    uint8_t buf[sizeof(HAN_CAPTURE_MAGIC) + HAN_CAPTURE_HEAD_MAX + 1];
+    memcpy(buf, HAN_CAPTURE_MAGIC, sizeof(HAN_CAPTURE_MAGIC));
+    size_t n = sizeof(HAN_CAPTURE_MAGIC);
+    n += han_capture_put_head(buf + n, v, 1);
+    ASSERT_LE(n, sizeof(buf) - 1);
+    buf[n++] = 0x7E;
+
+    HanCaptureReader r;
+    ASSERT_TRUE(han_capture_reader_open(r, buf, n));
+    HanCaptureRecord rec;
+    ASSERT_TRUE(han_capture_reader_next(r, rec)) << v;
+    EXPECT_EQ(v, rec.dt_ms);
+    EXPECT_EQ(1u, rec.len);
+    EXPECT_EQ(0x7E, rec.data[0]);
+    EXPECT_FALSE(han_capture_reader_next(r, rec));
+  }
+}
+
+TEST(HanCapture, RejectsWrongMagicOrVersion)
+{
+  const uint8_t other[] = {'H', 'A', 'N', 'C', 2, 0, 0};
+  HanCaptureReader r;
+  EXPECT_FALSE(han_capture_reader_open(r, other, sizeof(other)));
+  EXPECT_FALSE(han_capture_reader_open(r, other, 3));
+}
+
+TEST(HanCapture, TruncatedLastRecordIsDropped)
+{
+  const Bytes capture = load_capture("han_capture_dsmr.bin");
+  ASSERT_FALSE(capture.empty());
+  const Replayed full = replay(capture);
+
+  // Cut inside the payload of the last record, then inside its head.
+  const Bytes cut(capture.begin(), capture.end() - 5);
+  EXPECT_EQ(full.records - 1, replay(cut).records);
+  const Bytes tiny(capture.begin(), capture.begin() + sizeof(HAN_CAPTURE_MAGIC) + 1);
+  EXPECT_EQ(0, replay(tiny).records);
+}
+
+TEST(HanCapture, DsmrCaptureReplaysThroughParser)
+{
+  const Bytes capture = load_capture("han_capture_dsmr.bin");
+  ASSERT_FALSE(capture.empty());
+  const Replayed r = replay(capture);
+  EXPECT_EQ(360, r.records);
+  EXPECT_EQ(load_data_file("dsmr_capture.txt").size(), r.bytes);
+  EXPECT_GE(r.ms, 59u * 10000u);
+
+  ObisParser p;
+  obis_parser_reset(p);
+  int telegrams = 0;
+  int ok = 0;
+  int64_t firstWh = -1;
+  int64_t lastWh = -1;
+  for (uint8_t b : r.stream)
+  {
+    const ObisEvent ev = obis_parser_feed(p, static_cast<char>(b));
+    if (ev == OBIS_IMPORT_ENERGY_KWH)
+    {
+      lastWh = obis_parser_value_milli(p);
+      if (firstWh < 0) firstWh = lastWh;
+    }
+    if (ev != OBIS_END) continue;
+    ++telegrams;
+    if (obis_parser_telegram_ok(p)) ++ok;
+  }
+  EXPECT_EQ(60, telegrams);
+  EXPECT_EQ(60, ok);
+  EXPECT_EQ(12345685, firstWh);
+  EXPECT_EQ(12346078, lastWh);
+}
+
+TEST(HanCapture, KaifaCaptureReplaysThroughDecoder)
+{
+  const Bytes capture = load_capture("han_capture_kaifa.bin");
+  ASSERT_FALSE(capture.empty());
+  const Replayed r = replay(capture);
+  EXPECT_EQ(77, r.records);
+
+  HdlcDecoder d;
+  hdlc_decoder_reset(d);
+  DlmsValue out[DLMS_MAX_VALUES];
+  int frames = 0;
+  int withPower = 0;
+  int64_t importWh = -1;
+  for (uint8_t b : r.stream)
+  {
+    if (!hdlc_decoder_feed(d, b)) continue;
+    ++frames;
+    const uint8_t n = dlms_decode_frame(d, out);
+    for (uint8_t i = 0; i < n; ++i)
+    {
+      if (out[i].field == OBIS_IMPORT_POWER_KW) ++withPower;
+      if (out[i].field == OBIS_IMPORT_ENERGY_KWH) importWh = out[i].milli;
+    }
+  }
+  EXPECT_EQ(31, frames);
+  EXPECT_EQ(0u, d.frames_bad);
+  EXPECT_EQ(31, withPower);
+  EXPECT_EQ(12345678, importWh);
+}
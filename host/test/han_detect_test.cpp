@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench_data.h"
+#include "han_detect.h"
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+Bytes bytes_of(const std::string& s)
+{
+  return Bytes(s.begin(), s.end());
+}
+
+// host/data/hdlc_corpus.txt frames, in file order.
+std::vector<std::pair<std::string, Bytes>> hdlc_corpus()
+{
+  std::vector<std::pair<std::string, Bytes>> frames;
+  std::istringstream in(load_data_file("hdlc_corpus.txt"));
+  std::string line;
+  while (std::getline(in, line))
+  {
+    if (line.empty() || line[0] == '#') continue;
+    const size_t space = line.find(' ');
+    Bytes b;
+    for (size_t i = space + 1; i + 1 < line.size(); i += 2) b.push_back(static_cast<uint8_t>(std::stoul(line.substr(i, 2), nullptr, 16)));
+    frames.push_back(std::make_pair(line.substr(0, space), b));
+  }
+  return frames;
+}
+
+HanDetectScore score(const Bytes& stream)
+{
+  HanDetector d;
+  han_detector_reset(d);
+  han_detector_feed(d, stream.data(), stream.size());
+  return d.score;
+}
+
+// The DSMR sample telegram with its CRC digits removed (DSMR 2.x style).
+std::string plain_telegram()
+{
+  std::string t = load_data_file("dsmr_telegram.txt");
+  const size_t bang = t.find('!');
+  return t.substr(0, bang + 1) + "\r\n";
+}
+
+// What a UART at rxBaud makes of 8N1 bytes sent at txBaud: wait for a
+// falling edge, sample the data bits mid-period by its own clock, then hunt
+// for the next edge after the stop bit. invert flips the line.
+Bytes reclock(const Bytes& in, uint32_t txBaud, uint32_t rxBaud, bool invert = false)
+{
+  std::vector<uint8_t> bits;
+  bits.push_back(1);
+  for (uint8_t b : in)
+  {
+    bits.push_back(0);
+    for (int i = 0; i < 8; ++i) bits.push_back((b >> i) & 1);
+    bits.push_back(1);
+  }
+  for (int i = 0; i < 20; ++i) bits.push_back(1);
+  if (invert)
+  {
+    for (uint8_t& b : bits) b ^= 1;
+  }
+
+  auto level = [&](double t) -> uint8_t {
+    const size_t i = static_cast<size_t>(t * txBaud);
+    return i < bits.size() ? bits[i] : (invert ? 0 : 1);
+  };
+
+  Bytes out;
+  double t = 0.0;
+  size_t edge = 1;
+  for (;;)
+  {
+    edge = std::max(edge, static_cast<size_t>(t * txBaud) + 1);
+    while (edge < bits.size() && !(bits[edge - 1] == 1 && bits[edge] == 0)) ++edge;
+    if (edge >= bits.size()) break;
+    const double t0 = static_cast<double>(edge) / txBaud;
+    uint8_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint8_t>(level(t0 + (i + 1.5) / rxBaud) << i);
+    out.push_back(v);
+    t = t0 + 9.5 / rxBaud;
+  }
+  return out;
+}
+
+Bytes noise(size_t n, uint32_t seed)
+{
+  Bytes out(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    seed = seed * 1103515245u + 12345u;
+    out[i] = static_cast<uint8_t>(seed >> 16);
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(HanDetect, DsmrCaptureIsConfident)
+{
+  const HanDetectScore s = score(bytes_of(load_data_file("dsmr_capture.txt")));
+  EXPECT_EQ(60, s.dsmr_telegrams);
+  EXPECT_EQ(60, s.dsmr_crc_ok);
+  EXPECT_TRUE(han_detector_confident(s));
+  EXPECT_STREQ("DSMR", han_detector_protocol(s));
+}
+
+TEST(HanDetect, OneCrcCheckedTelegramIsEnough)
+{
+  const HanDetectScore s = score(bytes_of(load_data_file("dsmr_telegram.txt")));
+  EXPECT_EQ(1, s.dsmr_crc_ok);
+  EXPECT_TRUE(han_detector_confident(s));
+}
+
+TEST(HanDetect, OneTelegramWithoutCrcIsNotEnough)
+{
+  const HanDetectScore one = score(bytes_of(plain_telegram()));
+  EXPECT_EQ(1, one.dsmr_telegrams);
+  EXPECT_EQ(0, one.dsmr_crc_ok);
+  EXPECT_FALSE(han_detector_confident(one));
+
+  const HanDetectScore two = score(bytes_of(plain_telegram() + plain_telegram()));
+  EXPECT_EQ(1, two.dsmr_plain_repeats);
+  EXPECT_TRUE(han_detector_confident(two));
+  EXPECT_STREQ("DSMR", han_detector_protocol(two));
+}
+
+TEST(HanDetect, CrcLessTelegramsMustAgreeOnFields)
+{
+  // Two CRC-less "telegrams" with different known fields, as line noise
+  // that happens to contain '/' and '!' might produce.
+  const std::string a = "/XYZ5\r\n\r\n1-0:1.7.0(01.234*kW)\r\n!\r\n";
+  const std::string b = "/XYZ5\r\n\r\n1-0:32.7.0(230.1*V)\r\n!\r\n";
+  const HanDetectScore s = score(bytes_of(a + b));
+  EXPECT_EQ(2, s.dsmr_telegrams);
+  EXPECT_FALSE(han_detector_confident(s));
+
+  // Header and end without any known field never count.
+  const std::string empty = "/XYZ5\r\n\r\n!\r\n";
+  EXPECT_FALSE(han_detector_confident(score(bytes_of(empty + empty + empty))));
+}
+
+TEST(HanDetect, EveryHdlcCorpusFrameIsConfident)
+{
+  for (const auto& f : hdlc_corpus())
+  {
+    const HanDetectScore s = score(f.second);
+    EXPECT_EQ(1, s.hdlc_frames) << f.first;
+    EXPECT_TRUE(han_detector_confident(s)) << f.first;
+    EXPECT_STREQ("HDLC", han_detector_protocol(s)) << f.first;
+  }
+}
+
+TEST(HanDetect, NoiseIsNotConfident)
+{
+  for (uint32_t seed = 1; seed <= 20; ++seed)
+  {
+    const HanDetectScore s = score(noise(8192, seed));
+    EXPECT_FALSE(han_detector_confident(s)) << seed;
+    EXPECT_EQ(0, s.hdlc_frames) << seed;
+  }
+}
+
+TEST(HanDetect, ReclockAtSameBaudIsLossless)
+{
+  const Bytes dsmr = bytes_of(load_data_file("dsmr_telegram.txt"));
+  EXPECT_EQ(dsmr, reclock(dsmr, 115200, 115200));
+}
+
+TEST(HanDetect, WrongBaudIsNotConfident)
+{
+  const Bytes dsmr = bytes_of(load_data_file("dsmr_capture.txt"));
+  const uint32_t bauds[] = {2400, 9600, 19200, 57600};
+  for (uint32_t rx : bauds)
+  {
+    const HanDetectScore s = score(reclock(dsmr, 115200, rx));
+    EXPECT_FALSE(han_detector_confident(s)) << "DSMR at " << rx;
+    EXPECT_GT(han_detector_points(score(dsmr)), han_detector_points(s)) << rx;
+  }
+
+  Bytes hdlc;
+  for (const auto& f : hdlc_corpus()) hdlc.insert(hdlc.end(), f.second.begin(), f.second.end());
+  const uint32_t slow[] = {1200, 4800, 9600, 115200};
+  for (uint32_t rx : slow)
+  {
+    const HanDetectScore s = score(reclock(hdlc, 2400, rx));
+    EXPECT_FALSE(han_detector_confident(s)) << "HDLC at " << rx;
+  }
+}
+
+TEST(HanDetect, InvertedLineIsNotConfident)
+{
+  Bytes hdlc;
+  for (const auto& f : hdlc_corpus()) hdlc.insert(hdlc.end(), f.second.begin(), f.second.end());
+  EXPECT_FALSE(han_detector_confident(score(reclock(hdlc, 2400, 2400, true))));
+  EXPECT_FALSE(han_detector_confident(score(reclock(bytes_of(load_data_file("dsmr_capture.txt")), 115200, 115200, true))));
+}
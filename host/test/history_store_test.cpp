@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include <LittleFS.h>
+#include "history_store.h"
+
+namespace {
+
+const uint32_t kStart = 1772614800UL;  // 2026-03-04 10:00 CET
+
+class HistoryStore : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    setenv("TZ", "CET-1CEST,M3.5.0/2,M10.5.0/3", 1);
+    tzset();
+    char dir[] = "/tmp/hanreader_fsXXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    root_ = dir;
+    host_littlefs_root(dir);
+    history_store_begin();
+  }
+
+  void TearDown() override
+  {
+    const std::string cmd = "rm -rf '" + root_ + "'";
+    if (system(cmd.c_str()) != 0) ADD_FAILURE() << "could not remove " << root_;
+  }
+
+  std::string root_;
+};
+
+// Values that move both ways and cross varint byte boundaries.
+HistRecord minute(uint32_t i)
+{
+  HistRecord r;
+  r.start = kStart + i * 60UL;
+  r.energy_dwh = (i % 7 == 0) ? 0 : 100 + (i * 37) % 900;
+  r.l1_w = static_cast<uint16_t>(200 + (i * 131) % 5000);
+  r.l2_w = static_cast<uint16_t>((i % 3) ? 0 : 65535);
+  r.l3_w = static_cast<uint16_t>(1000 - (i % 1000));
+  r.peak_w = static_cast<uint16_t>(r.l1_w + 300);
+  return r;
+}
+
+std::vector<HistRecord>* g_out = nullptr;
+
+bool collect(const HistRecord& r, void*)
+{
+  g_out->push_back(r);
+  return true;
+}
+
+std::vector<HistRecord> query(HistTier tier, uint32_t from, uint32_t to)
+{
+  std::vector<HistRecord> out;
+  g_out = &out;
+  history_store_query(tier, from, to, collect, nullptr);
+  return out;
+}
+
+void expect_same(const HistRecord& a, const HistRecord& b)
+{
+  EXPECT_EQ(a.start, b.start);
+  EXPECT_EQ(a.energy_dwh, b.energy_dwh) << a.start;
+  EXPECT_EQ(a.l1_w, b.l1_w) << a.start;
+  EXPECT_EQ(a.l2_w, b.l2_w) << a.start;
+  EXPECT_EQ(a.l3_w, b.l3_w) << a.start;
+  EXPECT_EQ(a.peak_w, b.peak_w) << a.start;
+}
+
+}  // namespace
+
+TEST_F(HistoryStore, VarintZigzagRoundTrip)
+{
+  std::vector<HistRecord> in;
+  for (uint32_t i = 0; i < 200; ++i) in.push_back(minute(i));
+  // A long gap (multi-byte start delta) and a big energy jump down.
+  HistRecord late = minute(201);
+  late.start = kStart + 40UL * 86400UL;
+  late.energy_dwh = 4000000;
+  in.push_back(late);
+  HistRecord after = late;
+  after.start += 60;
+  after.energy_dwh = 1;
+  after.l1_w = 0;
+  after.peak_w = 65535;
+  in.push_back(after);
+
+  for (const HistRecord& r : in) history_store_add_minute(r);
+  const std::vector<HistRecord> out = query(HIST_MINUTE, 0, UINT32_MAX);
+  ASSERT_EQ(in.size(), out.size());
+  for (size_t i = 0; i < in.size(); ++i) expect_same(in[i], out[i]);
+
+  // Same again from flash after a reboot.
+  history_store_flush();
+  history_store_begin();
+  const std::vector<HistRecord> back = query(HIST_MINUTE, 0, UINT32_MAX);
+  ASSERT_EQ(in.size(), back.size());
+  for (size_t i = 0; i < in.size(); ++i) expect_same(in[i], back[i]);
+}
+
+TEST_F(HistoryStore, PageRolloverRingWrapAndRetention)
+{
+  // Seven days of minutes: more pages than the 16 minute slots, and well
+  // past the 48 h retention.
+  const uint32_t n = 7 * 1440;
+  for (uint32_t i = 0; i < n; ++i) history_store_add_minute(minute(i));
+  history_store_flush();
+
+  const HistTierStats s = history_store_stats(HIST_MINUTE);
+  EXPECT_GE(s.pages, 2);
+  EXPECT_LE(s.pages, 16);
+  EXPECT_EQ(minute(n - 1).start, s.last_t);
+  // Only pages whose successor starts within retention are kept.
+  EXPECT_GT(s.first_t + 48UL * 3600UL + 1440UL * 60UL, s.last_t);
+  EXPECT_LE(s.first_t + 48UL * 3600UL, s.last_t);
+
+  // One page file per live page; slots were reused, not leaked.
+  int files = 0;
+  for (uint8_t slot = 0; slot < 16; ++slot)
+  {
+    char path[16];
+    snprintf(path, sizeof(path), "/hm%03u.bin", slot);
+    if (LittleFS.exists(path)) ++files;
+  }
+  EXPECT_EQ(s.pages, files);
+
+  // What is left is contiguous and ends at the newest minute.
+  const std::vector<HistRecord> out = query(HIST_MINUTE, 0, UINT32_MAX);
+  ASSERT_FALSE(out.empty());
+  EXPECT_EQ(s.first_t, out.front().start);
+  for (size_t i = 1; i < out.size(); ++i) ASSERT_EQ(out[i - 1].start + 60, out[i].start);
+  expect_same(minute(n - 1), out.back());
+
+  // The hourly tier kept everything.
+  EXPECT_EQ(7u * 24u - 1u, query(HIST_HOUR, 0, UINT32_MAX).size());
+}
+
+TEST_F(HistoryStore, RangeQueryFindsFirstPage)
+{
+  const uint32_t n = 3 * 1440;
+  for (uint32_t i = 0; i < n; ++i) history_store_add_minute(minute(i));
+  ASSERT_GE(history_store_stats(HIST_MINUTE).pages, 3);
+
+  // Window in the middle, across page boundaries.
+  const uint32_t from = minute(1500).start;
+  const uint32_t to = minute(2700).start;
+  const std::vector<HistRecord> out = query(HIST_MINUTE, from, to);
+  ASSERT_EQ(1200u, out.size());
+  expect_same(minute(1500), out.front());
+  expect_same(minute(2699), out.back());
+
+  // Unaligned bounds: start is inclusive, end exclusive.
+  EXPECT_EQ(2u, query(HIST_MINUTE, minute(3000).start - 30, minute(3002).start).size());
+  EXPECT_EQ(1u, query(HIST_MINUTE, minute(n - 1).start, UINT32_MAX).size());
+  EXPECT_TRUE(query(HIST_MINUTE, 0, kStart).empty());
+  EXPECT_TRUE(query(HIST_MINUTE, to, from).empty());
+
+  // Stops when the visitor says so.
+  int seen = 0;
+  history_store_query(HIST_MINUTE, 0, UINT32_MAX, [](const HistRecord&, void* ctx) {
+    return ++*static_cast<int*>(ctx) < 5;
+  }, &seen);
+  EXPECT_EQ(5, seen);
+}
+
+TEST_F(HistoryStore, RollupsSurviveReboot)
+{
+  // 10:00-10:37, then a reboot.
+  uint32_t energy = 0;
+  for (uint32_t i = 0; i < 38; ++i)
+  {
+    history_store_add_minute(minute(i));
+    energy += minute(i).energy_dwh;
+  }
+  history_store_flush();
+  history_store_begin();
+
+  // 10:38-11:05 after the reboot.
+  for (uint32_t i = 38; i < 66; ++i)
+  {
+    history_store_add_minute(minute(i));
+    if (i < 60) energy += minute(i).energy_dwh;
+  }
+
+  const std::vector<HistRecord> hours = query(HIST_HOUR, 0, UINT32_MAX);
+  ASSERT_EQ(1u, hours.size());
+  EXPECT_EQ(kStart, hours[0].start);
+  EXPECT_EQ(energy, hours[0].energy_dwh);
+
+  const std::vector<HistRecord> quarters = query(HIST_QUARTER, 0, UINT32_MAX);
+  ASSERT_EQ(4u, quarters.size());
+  uint32_t q3 = 0;
+  for (uint32_t i = 30; i < 45; ++i) q3 += minute(i).energy_dwh;
+  EXPECT_EQ(kStart + 1800, quarters[2].start);
+  EXPECT_EQ(q3, quarters[2].energy_dwh);
+}
+
+TEST_F(HistoryStore, BucketsEndedWhileDownAreWrittenOnSeed)
+{
+  for (uint32_t i = 0; i < 38; ++i) history_store_add_minute(minute(i));
+  history_store_flush();
+  history_store_begin();
+
+  // Back at 12:10: the 10:30 quarter and the 10:00 hour closed while down.
+  history_store_add_minute(minute(130));
+  const std::vector<HistRecord> hours = query(HIST_HOUR, 0, UINT32_MAX);
+  ASSERT_EQ(1u, hours.size());
+  uint32_t energy = 0;
+  for (uint32_t i = 0; i < 38; ++i) energy += minute(i).energy_dwh;
+  EXPECT_EQ(energy, hours[0].energy_dwh);
+  EXPECT_EQ(3u, query(HIST_QUARTER, 0, UINT32_MAX).size());
+}
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "bench_data.h"
+#include "obis_parser.h"
+
+namespace {
+
+// Bit-by-bit CRC-16/ARC, independent of the parser's table.
+uint16_t crc16_arc(const std::string& data)
+{
+  uint16_t crc = 0;
+  for (unsigned char b : data)
+  {
+    crc ^= b;
+    for (int i = 0; i < 8; ++i) crc = (crc & 1) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : crc >> 1;
+  }
+  return crc;
+}
+
+// Header, body lines and a correct CRC, DSMR 5 style.
+std::string telegram(const std::string& body, bool lowercase = false)
+{
+  const std::string signed_part = "/KFM5KAIFA-METER\r\n\r\n" + body + "!";
+  char crc[8];
+  snprintf(crc, sizeof(crc), lowercase ? "%04x" : "%04X", crc16_arc(signed_part));
+  return signed_part + crc + "\r\n";
+}
+
+struct Fed {
+  int events[OBIS_EXPORT_ENERGY_KWH + 1] = {0};
+  float value[OBIS_EXPORT_ENERGY_KWH + 1] = {0};
+  int64_t milli[OBIS_EXPORT_ENERGY_KWH + 1] = {0};
+  int telegrams = 0;
+  int telegrams_ok = 0;
+};
+
+Fed feed(ObisParser& p, const std::string& bytes)
+{
+  Fed f;
+  for (char c : bytes)
+  {
+    const ObisEvent ev = obis_parser_feed(p, c);
+    if (ev == OBIS_NONE) continue;
+    ++f.events[ev];
+    if (ev == OBIS_END)
+    {
+      ++f.telegrams;
+      if (obis_parser_telegram_ok(p)) ++f.telegrams_ok;
+    }
+    else if (ev >= OBIS_VOLTAGE_L1)
+    {
+      f.value[ev] = obis_parser_value(p);
+      f.milli[ev] = obis_parser_value_milli(p);
+    }
+  }
+  return f;
+}
+
+}  // namespace
+
+TEST(Crc16Arc, CheckValue)
+{
+  EXPECT_EQ(0xBB3D, crc16_arc("123456789"));
+}
+
+TEST(ObisParser, RecordedTelegram)
+{
+  const std::string data = load_data_file("dsmr_telegram.txt");
+  ASSERT_FALSE(data.empty());
+  ObisParser p;
+  obis_parser_reset(p);
+  const Fed f = feed(p, data);
+
+  EXPECT_EQ(1, f.telegrams_ok);
+  EXPECT_STREQ("/ADN9 6534", p.header);
+  EXPECT_FLOAT_EQ(230.1f, f.value[OBIS_VOLTAGE_L1]);
+  EXPECT_FLOAT_EQ(229.8f, f.value[OBIS_VOLTAGE_L2]);
+  EXPECT_FLOAT_EQ(231.0f, f.value[OBIS_VOLTAGE_L3]);
+  EXPECT_FLOAT_EQ(3.6f, f.value[OBIS_CURRENT_L1]);
+  EXPECT_FLOAT_EQ(3.2f, f.value[OBIS_CURRENT_L2]);
+  EXPECT_FLOAT_EQ(3.5f, f.value[OBIS_CURRENT_L3]);
+  EXPECT_FLOAT_EQ(0.812f, f.value[OBIS_POWER_L1_KW]);
+  EXPECT_FLOAT_EQ(0.733f, f.value[OBIS_POWER_L2_KW]);
+  EXPECT_FLOAT_EQ(0.800f, f.value[OBIS_POWER_L3_KW]);
+  EXPECT_FLOAT_EQ(2.345f, f.value[OBIS_IMPORT_POWER_KW]);
+  EXPECT_EQ(1, f.events[OBIS_EXPORT_POWER_KW]);
+  EXPECT_FLOAT_EQ(0.0f, f.value[OBIS_EXPORT_POWER_KW]);
+  EXPECT_EQ(12345678, f.milli[OBIS_IMPORT_ENERGY_KWH]);
+  EXPECT_EQ(12345, f.milli[OBIS_EXPORT_ENERGY_KWH]);
+}
+
+TEST(ObisParser, RecordedCaptureAllTelegramsValid)
+{
+  const std::string data = load_data_file("dsmr_capture.txt");
+  ASSERT_FALSE(data.empty());
+  ObisParser p;
+  obis_parser_reset(p);
+  const Fed f = feed(p, data);
+  EXPECT_EQ(60, f.telegrams);
+  EXPECT_EQ(60, f.telegrams_ok);
+  EXPECT_EQ(60, f.events[OBIS_HEADER]);
+  EXPECT_EQ(60, f.events[OBIS_IMPORT_ENERGY_KWH]);
+}
+
+TEST(ObisParser, CorruptedByteFailsCrc)
+{
+  std::string t = telegram("1-0:1.7.0(01.234*kW)\r\n");
+  t[t.find("01.234")] = '7';
+  ObisParser p;
+  obis_parser_reset(p);
+  const Fed f = feed(p, t);
+  EXPECT_EQ(1, f.telegrams);
+  EXPECT_EQ(0, f.telegrams_ok);
+}
+
+TEST(ObisParser, WrongCrcDigitsFail)
+{
+  std::string t = telegram("1-0:1.7.0(01.234*kW)\r\n");
+  const size_t bang = t.find('!');
+  t[bang + 1] = (t[bang + 1] == '0') ? '1' : '0';
+  ObisParser p;
+  obis_parser_reset(p);
+  EXPECT_EQ(0, feed(p, t).telegrams_ok);
+}
+
+TEST(ObisParser, LowercaseCrcAccepted)
+{
+  ObisParser p;
+  obis_parser_reset(p);
+  EXPECT_EQ(1, feed(p, telegram("1-0:1.7.0(01.234*kW)\r\n", true)).telegrams_ok);
+}
+
+TEST(ObisParser, TruncatedCrcFails)
+{
+  std::string t = telegram("1-0:1.7.0(01.234*kW)\r\n");
+  t.erase(t.find('!') + 3, 2);
+  ObisParser p;
+  obis_parser_reset(p);
+  EXPECT_EQ(0, feed(p, t).telegrams_ok);
+}
+
+TEST(ObisParser, Dsmr2WithoutCrcAccepted)
+{
+  ObisParser p;
+  obis_parser_reset(p);
+  const Fed f = feed(p, "/ISk5\\2MT382-1000\r\n\r\n1-0:1.8.0(00123.456*kWh)\r\n!\r\n");
+  EXPECT_EQ(1, f.telegrams_ok);
+  EXPECT_EQ(123456, f.milli[OBIS_IMPORT_ENERGY_KWH]);
+}
+
+TEST(ObisParser, EndWithoutHeaderNotOk)
+{
+  ObisParser p;
+  obis_parser_reset(p);
+  const Fed f = feed(p, "1-0:1.7.0(01.234*kW)\r\n!\r\n");
+  EXPECT_EQ(1, f.telegrams);
+  EXPECT_EQ(0, f.telegrams_ok);
+}
+
+TEST(ObisParser, GarbageBeforeHeaderIgnored)
+{
+  ObisParser p;
+  obis_parser_reset(p);
+  const Fed f = feed(p, "\x7e\x01garbage)(\r\n" + telegram("1-0:1.7.0(01.234*kW)\r\n"));
+  EXPECT_EQ(1, f.telegrams_ok);
+  EXPECT_FLOAT_EQ(1.234f, f.value[OBIS_IMPORT_POWER_KW]);
+}
+
+TEST(ObisParser, ValueFormats)
+{
+  ObisParser p;
+  obis_parser_reset(p);
+  const Fed f = feed(p, telegram("1-0:21.7.0(-00.250*kW)\r\n"
+                                 "1-0:41.7.0(1,5*kW)\r\n"
+                                 "1-0:32.7.0(230)\r\n"
+                                 "1-0:1.8.0(00012345.6*kWh)\r\n"
+                                 "1-0:2.8.0(1.23456*kWh)\r\n"));
+  EXPECT_EQ(1, f.telegrams_ok);
+  EXPECT_FLOAT_EQ(-0.25f, f.value[OBIS_POWER_L1_KW]);
+  EXPECT_FLOAT_EQ(1.5f, f.value[OBIS_POWER_L2_KW]);
+  EXPECT_FLOAT_EQ(230.0f, f.value[OBIS_VOLTAGE_L1]);
+  EXPECT_EQ(12345600, f.milli[OBIS_IMPORT_ENERGY_KWH]);
+  EXPECT_EQ(1234, f.milli[OBIS_EXPORT_ENERGY_KWH]);  // truncated, not rounded
+}
+
+TEST(ObisParser, UnknownCodesAndEmptyValuesSkipped)
+{
+  ObisParser p;
+  obis_parser_reset(p);
+  const Fed f = feed(p, telegram("0-0:96.1.1(4B384547303034303436333935353037)\r\n"
+                                 "1-0:99.97.0(2)(0-0:96.7.19)(101208152415W)(0000000240*s)\r\n"
+                                 "1-0:1.7.0()\r\n"
+                                 "1-0:2.7.0(00.111*kW)\r\n"));
+  EXPECT_EQ(1, f.telegrams_ok);
+  EXPECT_EQ(0, f.events[OBIS_IMPORT_POWER_KW]);
+  EXPECT_EQ(1, f.events[OBIS_EXPORT_POWER_KW]);
+  EXPECT_FLOAT_EQ(0.111f, f.value[OBIS_EXPORT_POWER_KW]);
+}
+
+TEST(ObisParser, HeaderTruncatedToBuffer)
+{
+  ObisParser p;
+  obis_parser_reset(p);
+  const std::string longHeader = "/" + std::string(100, 'X');
+  feed(p, longHeader + "\r\n");
+  EXPECT_EQ(OBIS_HEADER_MAX - 1, static_cast<int>(strlen(p.header)));
+}
+
+TEST(ObisParser, BackToBackTelegrams)
+{
+  ObisParser p;
+  obis_parser_reset(p);
+  std::string bad = telegram("1-0:1.7.0(01.000*kW)\r\n");
+  bad[bad.find("01.000")] = '9';
+  const Fed f = feed(p, telegram("1-0:1.7.0(01.000*kW)\r\n") + bad + telegram("1-0:1.7.0(03.000*kW)\r\n"));
+  EXPECT_EQ(3, f.telegrams);
+  EXPECT_EQ(2, f.telegrams_ok);
+  EXPECT_FLOAT_EQ(3.0f, f.value[OBIS_IMPORT_POWER_KW]);
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "bench_data.h"
+#include "price_day.h"
+
+namespace {
+
+const uint32_t kFeb8 = 1770505200UL;   // 2026-02-08 00:00 CET
+const uint32_t kFeb9 = 1770591600UL;
+const uint32_t kFeb10 = 1770678000UL;
+const uint32_t kFeb11 = 1770764400UL;
+const float kEurNok = 11.5f;
+
+float nok(float eurMwh)
+{
+  return eurMwh * kEurNok / 1000.0f;
+}
+
+// Feeds the body in small pieces, as the HTTP client hands it over.
+template <typename State, typename Feed>
+void feed_chunked(State& s, const std::string& body, Feed feed)
+{
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(body.data());
+  for (size_t i = 0; i < body.size(); i += 37) feed(s, p + i, std::min<size_t>(37, body.size() - i));
+}
+
+bool entsoe_day(const std::string& doc, uint32_t dayStart, uint32_t dayEnd, PriceDay& day)
+{
+  PriceDayBuilder b;
+  price_day_begin(b, day, dayStart, "NO1");
+  EntsoeDoc s;
+  entsoe_doc_begin(s, b, dayStart, dayEnd, kEurNok);
+  feed_chunked(s, doc, entsoe_doc_feed);
+  return price_day_complete(b);
+}
+
+bool json_day(const std::string& body, uint32_t dayStart, PriceDay& day)
+{
+  PriceDayBuilder b;
+  price_day_begin(b, day, dayStart, "NO1");
+  PriceJsonDay s;
+  price_json_day_begin(s, b);
+  feed_chunked(s, body, price_json_day_feed);
+  return price_day_complete(b);
+}
+
+}  // namespace
+
+TEST(PriceDay, IsoTimestamps)
+{
+  uint32_t t = 0;
+  ASSERT_TRUE(price_iso_to_epoch("2026-02-09T00:00:00+01:00", t));
+  EXPECT_EQ(kFeb9, t);
+  ASSERT_TRUE(price_iso_to_epoch("2026-02-08T23:00Z", t));
+  EXPECT_EQ(kFeb9, t);
+  ASSERT_TRUE(price_iso_to_epoch("2026-03-29T03:00:00+02:00", t));
+  EXPECT_EQ(1774746000UL, t);
+  EXPECT_FALSE(price_iso_to_epoch("2026-02-09 00:00:00+01:00", t));
+  EXPECT_FALSE(price_iso_to_epoch("2026-02-09T00:00", t));
+  EXPECT_FALSE(price_iso_to_epoch("2026-02-09T0x:00Z", t));
+}
+
+TEST(PriceDay, CustomUrlPlaceholders)
+{
+  char url[64];
+  price_url_expand("http://x/{Y}/{M}-{D}_{zone}.json", 2026, 2, 9, "NO5", url, sizeof(url));
+  EXPECT_STREQ("http://x/2026/02-09_NO5.json", url);
+  price_url_expand("{zone}{zone}{X}", 2026, 2, 9, "NO1", url, sizeof(url));
+  EXPECT_STREQ("NO1NO1{X}", url);
+  price_url_expand("http://x/{Y}/{M}", 2026, 12, 1, "NO1", url, 12);
+  EXPECT_STREQ("http://x/20", url);
+}
+
+TEST(PriceDay, RecordedJsonDays)
+{
+  PriceDay day;
+  ASSERT_TRUE(json_day(load_data_file("prices_NO1_hour.json"), kFeb9, day));
+  EXPECT_EQ(3600, day.slot_s);
+  EXPECT_EQ(24, day.count);
+  EXPECT_FLOAT_EQ(0.45f, day.nok_kwh[0]);
+
+  ASSERT_TRUE(json_day(load_data_file("prices_NO1_15m.json"), kFeb9, day));
+  EXPECT_EQ(900, day.slot_s);
+  EXPECT_EQ(96, day.count);
+  EXPECT_FLOAT_EQ(0.45f, day.nok_kwh[0]);
+  EXPECT_FLOAT_EQ(0.695f, day.nok_kwh[1]);
+
+  // Asked for the next day, the entries are before its start.
+  EXPECT_FALSE(json_day(load_data_file("prices_NO1_hour.json"), kFeb10, day));
+}
+
+TEST(PriceDay, EntsoeA03FillsLeftOutPoints)
+{
+  const std::string doc = load_data_file("entsoe_a44_a03.xml");
+  ASSERT_FALSE(doc.empty());
+  PriceDay day;
+  ASSERT_TRUE(entsoe_day(doc, kFeb9, kFeb10, day));
+  EXPECT_EQ(3600, day.slot_s);
+  ASSERT_EQ(24, day.count);
+
+  const float expect[24] = {61.37f, 58.02f, 58.02f, 58.02f, 57.45f, 60.18f, 72.90f, 88.41f,
+                            95.66f, 95.66f, 91.20f, 84.75f, 80.03f, 78.64f, 79.12f, 83.57f,
+                            92.48f, 101.30f, 97.85f, 86.22f, 74.10f, 66.54f, 66.54f, 66.54f};
+  for (uint8_t i = 0; i < 24; ++i) EXPECT_NEAR(nok(expect[i]), day.nok_kwh[i], 1e-5f) << int(i);
+}
+
+TEST(PriceDay, EntsoeMixedResolutionKeepsFirstSeries)
+{
+  const std::string doc = load_data_file("entsoe_a44_mixed.xml");
+  ASSERT_FALSE(doc.empty());
+  PriceDay day;
+  ASSERT_TRUE(entsoe_day(doc, kFeb9, kFeb10, day));
+  EXPECT_EQ(3600, day.slot_s);
+  ASSERT_EQ(24, day.count);
+  for (uint8_t i = 0; i < 24; ++i) EXPECT_NEAR(nok(50.0f + i), day.nok_kwh[i], 1e-5f) << int(i);
+
+  // Quarter-hour series first: that one wins and the hourly one is ignored.
+  const size_t a = doc.find("  <TimeSeries>");
+  const size_t b = doc.find("  <TimeSeries>", a + 1);
+  const size_t end = doc.find("</Publication_MarketDocument>");
+  const std::string swapped = doc.substr(0, a) + doc.substr(b, end - b) + doc.substr(a, b - a) + doc.substr(end);
+  ASSERT_TRUE(entsoe_day(swapped, kFeb9, kFeb10, day));
+  EXPECT_EQ(900, day.slot_s);
+  ASSERT_EQ(96, day.count);
+  for (uint8_t i = 0; i < 96; ++i) EXPECT_NEAR(nok(100.0f + i * 0.5f), day.nok_kwh[i], 1e-5f) << int(i);
+}
+
+TEST(PriceDay, EntsoeClipsToDayWindow)
+{
+  const std::string doc = load_data_file("entsoe_a44_two_days.xml");
+  ASSERT_FALSE(doc.empty());
+  PriceDay day;
+
+  ASSERT_TRUE(entsoe_day(doc, kFeb8, kFeb9, day));
+  ASSERT_EQ(24, day.count);
+  EXPECT_NEAR(nok(30.0f), day.nok_kwh[0], 1e-5f);
+  EXPECT_NEAR(nok(53.0f), day.nok_kwh[23], 1e-5f);
+
+  // The 48-hour period: positions 23-26 repeat 22 across the midnight.
+  ASSERT_TRUE(entsoe_day(doc, kFeb9, kFeb10, day));
+  ASSERT_EQ(24, day.count);
+  EXPECT_NEAR(nok(200.0f), day.nok_kwh[0], 1e-5f);
+  EXPECT_NEAR(nok(221.0f), day.nok_kwh[21], 1e-5f);
+  EXPECT_NEAR(nok(221.0f), day.nok_kwh[22], 1e-5f);
+  EXPECT_NEAR(nok(221.0f), day.nok_kwh[23], 1e-5f);
+
+  // Next day starts on filled points and ends on the period-end fill.
+  ASSERT_TRUE(entsoe_day(doc, kFeb10, kFeb11, day));
+  ASSERT_EQ(24, day.count);
+  EXPECT_NEAR(nok(221.0f), day.nok_kwh[0], 1e-5f);
+  EXPECT_NEAR(nok(221.0f), day.nok_kwh[1], 1e-5f);
+  EXPECT_NEAR(nok(226.0f), day.nok_kwh[2], 1e-5f);
+  EXPECT_NEAR(nok(245.0f), day.nok_kwh[21], 1e-5f);
+  EXPECT_NEAR(nok(245.0f), day.nok_kwh[23], 1e-5f);
+
+  // Nothing in the document for the day after.
+  EXPECT_FALSE(entsoe_day(doc, kFeb11, kFeb11 + 86400UL, day));
+}
+
+TEST(PriceDay, EntsoeTruncatedDocumentIsIncomplete)
+{
+  const std::string doc = load_data_file("entsoe_a44_a03.xml");
+  PriceDay day;
+  EXPECT_FALSE(entsoe_day(doc.substr(0, doc.size() / 2), kFeb9, kFeb10, day));
+}
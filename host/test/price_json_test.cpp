@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "bench_data.h"
+#include "price_json.h"
+
+namespace {
+
+struct Entry {
+  std::string time_start;
+  float nok_per_kwh;
+};
+
+std::vector<Entry> parse(const std::string& body, PriceJsonParser* state = nullptr)
+{
+  PriceJsonParser p;
+  price_json_reset(p);
+  std::vector<Entry> out;
+  for (char c : body)
+  {
+    if (price_json_feed(p, c) == PJSON_ENTRY) out.push_back(Entry{p.time_start, p.nok_per_kwh});
+  }
+  if (state) *state = p;
+  return out;
+}
+
+}  // namespace
+
+TEST(PriceJson, RecordedHourlyPayload)
+{
+  const std::string body = load_data_file("prices_NO1_hour.json");
+  ASSERT_FALSE(body.empty());
+  PriceJsonParser p;
+  const std::vector<Entry> e = parse(body, &p);
+  ASSERT_EQ(24u, e.size());
+  EXPECT_EQ("2026-02-09T00:00:00+01:00", e[0].time_start);
+  EXPECT_FLOAT_EQ(0.45f, e[0].nok_per_kwh);
+  EXPECT_EQ("2026-02-09T01:00:00+01:00", e[1].time_start);
+  EXPECT_FLOAT_EQ(0.695f, e[1].nok_per_kwh);
+  EXPECT_EQ("2026-02-09T23:00:00+01:00", e[23].time_start);
+  EXPECT_EQ(24, p.entries);
+  EXPECT_EQ(body.size(), p.bytes);
+}
+
+TEST(PriceJson, RecordedQuarterHourPayload)
+{
+  const std::vector<Entry> e = parse(load_data_file("prices_NO1_15m.json"));
+  ASSERT_EQ(96u, e.size());
+  EXPECT_EQ("2026-02-09T00:15:00+01:00", e[1].time_start);
+  EXPECT_EQ("2026-02-09T23:45:00+01:00", e[95].time_start);
+}
+
+TEST(PriceJson, PrettyPrintedAndKeyOrder)
+{
+  const std::vector<Entry> e = parse("[\n  {\n    \"time_start\" : \"2026-02-09T13:00:00+01:00\",\n"
+                                     "    \"NOK_per_kWh\" : 1.25 ,\n    \"EXR\": 11.48\n  },\n"
+                                     "  {\"EUR_per_kWh\":0.1,\"NOK_per_kWh\":-0.0123,\"time_start\":\"2026-02-09T14:00:00+01:00\"}\n]");
+  ASSERT_EQ(2u, e.size());
+  EXPECT_FLOAT_EQ(1.25f, e[0].nok_per_kwh);
+  EXPECT_FLOAT_EQ(-0.0123f, e[1].nok_per_kwh);
+  EXPECT_EQ("2026-02-09T14:00:00+01:00", e[1].time_start);
+}
+
+TEST(PriceJson, ExponentAndLastKey)
+{
+  const std::vector<Entry> e = parse("[{\"time_start\":\"2026-02-09T00:00:00+01:00\",\"NOK_per_kWh\":1.5e-1}]");
+  ASSERT_EQ(1u, e.size());
+  EXPECT_FLOAT_EQ(0.15f, e[0].nok_per_kwh);
+}
+
+TEST(PriceJson, IncompleteEntriesSkipped)
+{
+  const std::vector<Entry> e = parse("[{\"time_start\":\"2026-02-09T00:00:00+01:00\"},"
+                                     "{\"NOK_per_kWh\":0.5},"
+                                     "{\"time_start\":\"2026-02-09T02:00:00+01:00\",\"NOK_per_kWh\":null},"
+                                     "{\"time_start\":\"2026-02-09T03:00:00+01:00\",\"NOK_per_kWh\":0.7}]");
+  ASSERT_EQ(1u, e.size());
+  EXPECT_EQ("2026-02-09T03:00:00+01:00", e[0].time_start);
+}
+
+TEST(PriceJson, EscapedStringsDoNotEndValues)
+{
+  const std::vector<Entry> e = parse("[{\"note\":\"a \\\"quoted\\\" }, ] value\",\"time_start\":\"2026-02-09T05:00:00+01:00\","
+                                     "\"NOK_per_kWh\":0.33}]");
+  ASSERT_EQ(1u, e.size());
+  EXPECT_FLOAT_EQ(0.33f, e[0].nok_per_kwh);
+}
+
+TEST(PriceJson, PriceAsStringIgnored)
+{
+  const std::vector<Entry> e = parse("[{\"time_start\":\"2026-02-09T05:00:00+01:00\",\"NOK_per_kWh\":\"0.33\"}]");
+  EXPECT_TRUE(e.empty());
+}
+
+TEST(PriceJson, LongValuesTruncatedToBuffer)
+{
+  const std::string longTime(100, '9');
+  PriceJsonParser p;
+  const std::vector<Entry> e = parse("[{\"time_start\":\"" + longTime + "\",\"NOK_per_kWh\":0.1}]", &p);
+  ASSERT_EQ(1u, e.size());
+  EXPECT_EQ(PJSON_VALUE_MAX - 1, static_cast<int>(e[0].time_start.size()));
+}
+
+TEST(PriceJson, NestedObjectsAreNotEntries)
+{
+  const std::vector<Entry> e = parse("[{\"meta\":{\"time_start\":\"x\",\"NOK_per_kWh\":9},"
+                                     "\"time_start\":\"2026-02-09T06:00:00+01:00\",\"NOK_per_kWh\":0.2}]");
+  ASSERT_EQ(1u, e.size());
+  EXPECT_FLOAT_EQ(0.2f, e[0].nok_per_kwh);
+}
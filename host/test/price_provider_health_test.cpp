@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "price_provider_health.h"
+
+namespace {
+
+std::vector<int> order(const PriceProviderStats* stats)
+{
+  uint8_t ids[PRICE_PROV_COUNT];
+  for (uint8_t i = 0; i < PRICE_PROV_COUNT; ++i) ids[i] = i;
+  price_provider_sort(stats, ids, PRICE_PROV_COUNT);
+  return std::vector<int>(ids, ids + PRICE_PROV_COUNT);
+}
+
+const int H = PRICE_PROV_HVAKOSTER;
+const int E = PRICE_PROV_ENTSOE;
+const int C = PRICE_PROV_CUSTOM;
+
+}  // namespace
+
+TEST(PriceProviderHealth, FailoverAndCooldownOrder)
+{
+  host_advance_ms(60000);  // clear of millis() == 0
+  PriceProviderStats s[PRICE_PROV_COUNT];
+  EXPECT_EQ((std::vector<int>{H, E, C}), order(s));
+
+  // Measured providers go ahead of unmeasured ones, fastest first.
+  price_provider_record(s[C], true, 300, "");
+  price_provider_record(s[H], true, 800, "");
+  EXPECT_EQ((std::vector<int>{C, H, E}), order(s));
+
+  // One failure is not enough to move the fastest back.
+  price_provider_record(s[C], false, 5000, "HTTP 500");
+  EXPECT_FALSE(price_provider_cooling_down(s[C]));
+  EXPECT_EQ((std::vector<int>{C, H, E}), order(s));
+
+  // Two in a row: behind every healthy provider, even unmeasured ones.
+  price_provider_record(s[C], false, 5000, "Connect failed");
+  EXPECT_TRUE(price_provider_cooling_down(s[C]));
+  EXPECT_STREQ("Connect failed", s[C].last_error);
+  EXPECT_EQ((std::vector<int>{H, E, C}), order(s));
+
+  // Both measured ones cooling down: the unmeasured one first, then the
+  // cooling ones still by latency.
+  host_advance_ms(60000);
+  price_provider_record(s[H], false, 5000, "Body truncated");
+  price_provider_record(s[H], false, 5000, "Body truncated");
+  EXPECT_EQ((std::vector<int>{E, C, H}), order(s));
+
+  // C's ten minutes run out first.
+  host_advance_ms(9UL * 60000UL + 1000);
+  EXPECT_FALSE(price_provider_cooling_down(s[C]));
+  EXPECT_TRUE(price_provider_cooling_down(s[H]));
+  EXPECT_EQ((std::vector<int>{C, E, H}), order(s));
+
+  host_advance_ms(60000);
+  EXPECT_EQ((std::vector<int>{C, H, E}), order(s));
+
+  // A success clears the failure run and folds into the smoothed latency.
+  price_provider_record(s[C], true, 700, "");
+  EXPECT_EQ(0, s[C].consecutive_failures);
+  EXPECT_EQ(400u, s[C].avg_ms);
+  EXPECT_STREQ("", s[C].last_error);
+  EXPECT_EQ(2u, s[C].failed);
+  EXPECT_EQ(2u, s[C].ok);
+}
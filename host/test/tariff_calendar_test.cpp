@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include "tariff_calendar.h"
+
+namespace {
+
+// tm_yday of a date, worked out independently of the calendar module.
+int yday(int year, int month, int mday)
+{
+  static const int kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  int n = mday - 1;
+  for (int m = 1; m < month; ++m) n += kDays[m - 1] + (m == 2 && leap ? 1 : 0);
+  return n;
+}
+
+}  // namespace
+
+TEST(TariffCalendar, EasterSundayKnownYears)
+{
+  EXPECT_EQ(yday(2025, 4, 20), calendar_easter_yday(2025));
+  EXPECT_EQ(yday(2038, 4, 25), calendar_easter_yday(2038));
+  EXPECT_EQ(yday(2024, 3, 31), calendar_easter_yday(2024));  // leap year
+  EXPECT_EQ(yday(2000, 4, 23), calendar_easter_yday(2000));  // leap century
+  EXPECT_EQ(yday(2008, 3, 23), calendar_easter_yday(2008));  // leap, early Easter
+  EXPECT_EQ(yday(2011, 4, 24), calendar_easter_yday(2011));
+  EXPECT_EQ(yday(2026, 4, 5), calendar_easter_yday(2026));
+  EXPECT_EQ(yday(2285, 3, 22), calendar_easter_yday(2285));  // earliest possible date
+}
+
+TEST(TariffCalendar, MovableHolidays2025)
+{
+  EXPECT_TRUE(calendar_is_holiday(2025, yday(2025, 4, 13)));   // palmesondag
+  EXPECT_TRUE(calendar_is_holiday(2025, yday(2025, 4, 17)));   // skjaertorsdag
+  EXPECT_TRUE(calendar_is_holiday(2025, yday(2025, 4, 18)));   // langfredag
+  EXPECT_TRUE(calendar_is_holiday(2025, yday(2025, 4, 20)));   // 1. paaskedag
+  EXPECT_TRUE(calendar_is_holiday(2025, yday(2025, 4, 21)));   // 2. paaskedag
+  EXPECT_TRUE(calendar_is_holiday(2025, yday(2025, 5, 29)));   // Kristi himmelfart
+  EXPECT_TRUE(calendar_is_holiday(2025, yday(2025, 6, 8)));    // 1. pinsedag
+  EXPECT_TRUE(calendar_is_holiday(2025, yday(2025, 6, 9)));    // 2. pinsedag
+
+  EXPECT_FALSE(calendar_is_holiday(2025, yday(2025, 4, 16)));
+  EXPECT_FALSE(calendar_is_holiday(2025, yday(2025, 4, 19)));  // paaskeaften is not a public holiday
+  EXPECT_FALSE(calendar_is_holiday(2025, yday(2025, 4, 22)));
+  EXPECT_FALSE(calendar_is_holiday(2025, yday(2025, 5, 28)));
+  EXPECT_FALSE(calendar_is_holiday(2025, yday(2025, 6, 10)));
+}
+
+TEST(TariffCalendar, MovableHolidaysLeapYear)
+{
+  EXPECT_TRUE(calendar_is_holiday(2024, yday(2024, 3, 28)));   // skjaertorsdag
+  EXPECT_TRUE(calendar_is_holiday(2024, yday(2024, 3, 29)));   // langfredag
+  EXPECT_TRUE(calendar_is_holiday(2024, yday(2024, 5, 9)));    // Kristi himmelfart
+  EXPECT_TRUE(calendar_is_holiday(2024, yday(2024, 5, 20)));   // 2. pinsedag
+  EXPECT_FALSE(calendar_is_holiday(2024, yday(2024, 5, 8)));
+}
+
+TEST(TariffCalendar, FixedHolidays)
+{
+  for (int year : {2024, 2025, 2026})
+  {
+    EXPECT_TRUE(calendar_is_holiday(year, yday(year, 1, 1))) << year;
+    EXPECT_TRUE(calendar_is_holiday(year, yday(year, 5, 1))) << year;
+    EXPECT_TRUE(calendar_is_holiday(year, yday(year, 5, 17))) << year;
+    EXPECT_TRUE(calendar_is_holiday(year, yday(year, 12, 25))) << year;
+    EXPECT_TRUE(calendar_is_holiday(year, yday(year, 12, 26))) << year;
+    EXPECT_FALSE(calendar_is_holiday(year, yday(year, 12, 24))) << year;
+    EXPECT_FALSE(calendar_is_holiday(year, yday(year, 12, 31))) << year;
+  }
+}
+
+TEST(TariffCalendar, AlternatingYearsKeepTheirOwnBitmaps)
+{
+  // Two cached years; a third evicts the one with the same parity.
+  EXPECT_TRUE(calendar_is_holiday(2025, yday(2025, 4, 18)));
+  EXPECT_TRUE(calendar_is_holiday(2026, yday(2026, 4, 3)));
+  EXPECT_TRUE(calendar_is_holiday(2027, yday(2027, 3, 26)));
+  EXPECT_FALSE(calendar_is_holiday(2025, yday(2025, 3, 26)));
+  EXPECT_TRUE(calendar_is_holiday(2025, yday(2025, 4, 18)));
+  EXPECT_FALSE(calendar_is_holiday(2025, -1));
+  EXPECT_FALSE(calendar_is_holiday(2025, 366));
+}
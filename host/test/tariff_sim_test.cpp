@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <vector>
+
+#include "config_store.h"
+#include "tariff_engine.h"
+#include "tariff_sim.h"
+
+namespace {
+
+class TariffSim : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    setenv("TZ", "CET-1CEST,M3.5.0/2,M10.5.0/3", 1);
+    tzset();
+  }
+
+  static CompiledTariff compiled(const char* profile, const char* winter = "", const char* bands = "")
+  {
+    DeviceConfig cfg = config_load();
+    cfg.tariff_profile = profile;
+    config_apply_tariff_profile(cfg, true);
+    cfg.tariff_winter_months = winter;
+    cfg.tariff_winter_extra_ore = 10.0f;
+    cfg.tariff_bands = bands;
+    CompiledTariff t;
+    tariff_compile(cfg, t);
+    return t;
+  }
+
+  static uint32_t local_epoch(int year, int mon, int mday, int hour = 0)
+  {
+    tm t = {};
+    t.tm_year = year - 1900;
+    t.tm_mon = mon - 1;
+    t.tm_mday = mday;
+    t.tm_hour = hour;
+    t.tm_isdst = -1;
+    return static_cast<uint32_t>(mktime(&t));
+  }
+
+  // Slots from `from` up to `to`, kWh per slot from fn(local time).
+  template <typename Fn>
+  void load(uint32_t from, uint32_t to, uint16_t slotSeconds, Fn fn)
+  {
+    kwh_.assign(SIM_SLOTS_MAX, 0.0f);
+    hour_.assign(SIM_SLOTS_MAX, 0);
+    cal_.assign(SIM_SLOTS_MAX, 0);
+    locals_.clear();
+    sim_load_init(load_, kwh_.data(), hour_.data(), cal_.data(), SIM_SLOTS_MAX, slotSeconds);
+    for (uint32_t at = from; at < to; at += slotSeconds)
+    {
+      const time_t e = static_cast<time_t>(at);
+      tm local;
+      localtime_r(&e, &local);
+      locals_.push_back(local);
+      ASSERT_TRUE(sim_load_add(load_, at, fn(local), local));
+    }
+    sim_load_finish(load_);
+  }
+
+  SimLoad load_;
+  std::vector<float> kwh_;
+  std::vector<uint8_t> hour_;
+  std::vector<uint8_t> cal_;
+  std::vector<tm> locals_;
+};
+
+}  // namespace
+
+TEST_F(TariffSim, FlatYearChargesTwelveMonths)
+{
+  const CompiledTariff t = compiled("ELVIA_EXAMPLE");
+  load(local_epoch(2025, 1, 1), local_epoch(2026, 1, 1), 3600, [](const tm&) { return 1.0f; });
+
+  ASSERT_EQ(8760, load_.count);
+  ASSERT_EQ(12, load_.months);
+  const SimResult r = tariff_sim_run(load_, t);
+  EXPECT_FLOAT_EQ(8760.0f, r.kwh);
+  EXPECT_NEAR(12.0f, r.months, 1e-4f);
+  for (uint8_t m = 0; m < load_.months; ++m) EXPECT_FLOAT_EQ(1.0f, load_.month_peak_kw[m]);
+  // 1 kW keeps every month in the lowest tier (2 kW: 219 NOK).
+  EXPECT_NEAR(12 * 219.0f * t.vat_factor, r.capacity_nok, 0.05f);
+  EXPECT_NEAR(12 * t.fixed_monthly_nok * t.vat_factor, r.fixed_nok, 0.05f);
+  EXPECT_NEAR(r.energy_nok + r.capacity_nok + r.fixed_nok, r.total_nok, 0.01f);
+}
+
+TEST_F(TariffSim, EnergyMatchesLiveRateLookup)
+{
+  // Winter surcharge, peak bands and holidays all in play.
+  const CompiledTariff t = compiled("TENSIO_EXAMPLE", "1-3,11-12", "07-11:52,17-21:52");
+  load(local_epoch(2025, 1, 1), local_epoch(2026, 1, 1), 3600,
+       [](const tm& l) { return 0.4f + 0.1f * (l.tm_hour % 7) + 0.05f * l.tm_wday; });
+
+  double expected = 0.0;
+  for (uint16_t i = 0; i < load_.count; ++i) expected += kwh_[i] * t.grid_nok_kwh[tariff_rate_index(t, locals_[i])];
+  const SimResult r = tariff_sim_run(load_, t);
+  EXPECT_NEAR(expected, r.energy_nok, expected * 1e-5);
+}
+
+TEST_F(TariffSim, HolidayPricedAsOffday)
+{
+  // Thursday 1 May 2025 (Labour Day) against Thursday 8 May.
+  const CompiledTariff t = compiled("ELVIA_EXAMPLE");
+  ASSERT_NE(t.grid_nok_kwh[TARIFF_DAY_WORK * 24 + 12], t.grid_nok_kwh[TARIFF_DAY_OFF * 24 + 12]);
+  load(local_epoch(2025, 5, 1, 12), local_epoch(2025, 5, 1, 13), 3600, [](const tm&) { return 1.0f; });
+  const float holiday = tariff_sim_run(load_, t).energy_nok;
+  load(local_epoch(2025, 5, 8, 12), local_epoch(2025, 5, 8, 13), 3600, [](const tm&) { return 1.0f; });
+  const float workday = tariff_sim_run(load_, t).energy_nok;
+  EXPECT_FLOAT_EQ(t.grid_nok_kwh[TARIFF_DAY_OFF * 24 + 12], holiday);
+  EXPECT_FLOAT_EQ(t.grid_nok_kwh[TARIFF_DAY_WORK * 24 + 12], workday);
+}
+
+TEST_F(TariffSim, PartialFirstAndLastMonthProRata)
+{
+  const CompiledTariff t = compiled("ELVIA_EXAMPLE");
+  load(local_epoch(2025, 1, 17), local_epoch(2025, 3, 10), 3600, [](const tm&) { return 1.0f; });
+
+  ASSERT_EQ(3, load_.months);
+  EXPECT_NEAR(15.0f / 31.0f, load_.month_share[0], 1e-4f);
+  EXPECT_NEAR(1.0f, load_.month_share[1], 1e-6f);
+  EXPECT_NEAR(9.0f / 31.0f, load_.month_share[2], 1e-4f);
+  const SimResult r = tariff_sim_run(load_, t);
+  EXPECT_NEAR(15.0f / 31.0f + 1.0f + 9.0f / 31.0f, r.months, 1e-4f);
+  EXPECT_NEAR(r.months * t.fixed_monthly_nok * t.vat_factor, r.fixed_nok, 0.01f);
+}
+
+TEST_F(TariffSim, CapacityBasisIsMeanOfThreeHighestDailyMaxima)
+{
+  // Day 3: one 6 kW hour. Day 5: two 5 kW hours (one daily maximum). Day 9: 4 kW.
+  const CompiledTariff t = compiled("ELVIA_EXAMPLE");
+  load(local_epoch(2025, 6, 1), local_epoch(2025, 7, 1), 3600, [](const tm& l) {
+    if (l.tm_mday == 3 && l.tm_hour == 18) return 6.0f;
+    if (l.tm_mday == 5 && (l.tm_hour == 8 || l.tm_hour == 19)) return 5.0f;
+    if (l.tm_mday == 9 && l.tm_hour == 7) return 4.0f;
+    return 1.0f;
+  });
+
+  ASSERT_EQ(1, load_.months);
+  EXPECT_FLOAT_EQ(5.0f, load_.month_peak_kw[0]);
+  const SimResult r = tariff_sim_run(load_, t);
+  EXPECT_NEAR(tariff_capacity_monthly_nok(t, 5.0f) * t.vat_factor, r.capacity_nok, 0.01f);
+  EXPECT_NEAR(1.0f, r.months, 1e-4f);
+}
+
+TEST_F(TariffSim, QuarterHoursSumIntoHourlyPeaks)
+{
+  const CompiledTariff t = compiled("ELVIA_EXAMPLE");
+  load(local_epoch(2025, 6, 1), local_epoch(2025, 6, 4), 900, [](const tm& l) { return l.tm_hour == 18 ? 1.5f : 0.25f; });
+
+  EXPECT_EQ(3 * 96, load_.count);
+  ASSERT_EQ(1, load_.months);
+  EXPECT_FLOAT_EQ(6.0f, load_.month_peak_kw[0]);
+  EXPECT_NEAR(3.0f / 30.0f, load_.month_share[0], 1e-4f);
+  EXPECT_NEAR(3 * (4 * 1.5f + 23 * 4 * 0.25f), tariff_sim_run(load_, t).kwh, 1e-3f);
+}
+
+TEST_F(TariffSim, FullArraysStopLoading)
+{
+  std::vector<float> kwh(4);
+  std::vector<uint8_t> hour(4), cal(4);
+  SimLoad small;
+  sim_load_init(small, kwh.data(), hour.data(), cal.data(), 4, 3600);
+  tm local = {};
+  for (uint32_t i = 0; i < 4; ++i) EXPECT_TRUE(sim_load_add(small, 3600 * (i + 1), 1.0f, local));
+  EXPECT_FALSE(sim_load_add(small, 3600 * 5, 1.0f, local));
+  EXPECT_EQ(4, small.count);
+}
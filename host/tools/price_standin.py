@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""Local stand-in for the hvakosterstrommen.no price API.
+
+Serves <base>/<YYYY>/<MM>-<DD>_<zone>.json for any day, built from the
+recorded payloads in host/data (hourly or 15-minute), with timestamps moved to
+the requested local day (23/25 slots on DST change days). Point a firmware
+build at it with
+
+    -DHANREADER_PRICE_BASE_URL="\"http://<pc-ip>:8080/prices\""
+
+and pick a failure mode to watch the worker's timeouts, backoff and prefetch
+on /status/prices:
+
+    ok         answer normally
+    slow       wait --delay seconds before answering (past the 5 s fetch timeout by default)
+    drip       send the body a few bytes at a time, --delay seconds in total
+    500        answer HTTP 500
+    truncated  announce the full Content-Length, send half the body, close
+    flaky      fail the first --fail-first requests with 500, then answer
+
+Every request is logged with its time, so retry spacing is visible.
+"""
+
+import argparse
+import datetime
+import json
+import os
+import re
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from zoneinfo import ZoneInfo
+
+DATA = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "data")
+OSLO = ZoneInfo("Europe/Oslo")
+PATH_RE = re.compile(r"^/prices/(\d{4})/(\d{2})-(\d{2})_(NO[1-5])\.json$")
+
+
+def load_prices(res):
+    name = "prices_NO1_15m.json" if res == "15m" else "prices_NO1_hour.json"
+    with open(os.path.join(DATA, name), "rb") as f:
+        return [e["NOK_per_kWh"] for e in json.load(f)]
+
+
+def day_payload(prices, slot_min, y, m, d):
+    start = datetime.datetime(y, m, d, tzinfo=OSLO)
+    end = datetime.datetime.combine(start.date() + datetime.timedelta(days=1), datetime.time(), tzinfo=OSLO)
+    utc = start.astimezone(datetime.timezone.utc)
+    stop = end.astimezone(datetime.timezone.utc)
+    step = datetime.timedelta(minutes=slot_min)
+    out = []
+    i = 0
+    while utc < stop:
+        a = utc.astimezone(OSLO)
+        b = (utc + step).astimezone(OSLO)
+        out.append({
+            "NOK_per_kWh": prices[i % len(prices)],
+            "EUR_per_kWh": round(prices[i % len(prices)] / 11.4815, 5),
+            "EXR": 11.4815,
+            "time_start": a.isoformat(),
+            "time_end": b.isoformat(),
+        })
+        utc += step
+        i += 1
+    return json.dumps(out, separators=(",", ":")).encode()
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    args = None
+    prices = None
+    served = 0
+
+    def log_message(self, fmt, *a):
+        sys.stdout.write("%s %s\n" % (datetime.datetime.now().strftime("%H:%M:%S.%f")[:-3], fmt % a))
+        sys.stdout.flush()
+
+    def fail(self, code):
+        body = b'{"error":"stand-in"}'
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        cls = type(self)
+        cls.served += 1
+        match = PATH_RE.match(self.path)
+        if not match:
+            return self.fail(404)
+
+        mode = self.args.mode
+        if mode == "500" or (mode == "flaky" and cls.served <= self.args.fail_first):
+            return self.fail(500)
+
+        y, m, d = (int(g) for g in match.groups()[:3])
+        body = day_payload(self.prices, 15 if self.args.res == "15m" else 60, y, m, d)
+        if mode == "slow":
+            time.sleep(self.args.delay)
+
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+
+        if mode == "truncated":
+            self.wfile.write(body[: len(body) // 2])
+            self.wfile.flush()
+            self.close_connection = True
+            return
+        if mode == "drip":
+            chunk = 64
+            pause = self.args.delay / max(1, len(body) // chunk)
+            for i in range(0, len(body), chunk):
+                self.wfile.write(body[i:i + chunk])
+                self.wfile.flush()
+                time.sleep(pause)
+            return
+        self.wfile.write(body)
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("--port", type=int, default=8080)
+    p.add_argument("--bind", default="0.0.0.0")
+    p.add_argument("--mode", choices=["ok", "slow", "drip", "500", "truncated", "flaky"], default="ok")
+    p.add_argument("--res", choices=["hour", "15m"], default="hour")
+    p.add_argument("--delay", type=float, default=8.0, help="seconds, for slow and drip")
+    p.add_argument("--fail-first", type=int, default=3, help="requests to fail in flaky mode")
+    args = p.parse_args()
+
+    Handler.args = args
+    Handler.prices = load_prices(args.res)
+    server = ThreadingHTTPServer((args.bind, args.port), Handler)
+    print("price stand-in on %s:%d, mode %s, %s slots" % (args.bind, args.port, args.mode, args.res))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,38 @@
+#include "boot_metrics.h"
+
+static const char* kNames[BOOT_EVENT_COUNT] = {
+  "http_ready_ms",
+  "wifi_up_ms",
+  "time_valid_ms",
+  "ota_ready_ms",
+  "first_telegram_ms",
+  "first_http_200_ms",
+};
+
+static volatile uint32_t g_ms[BOOT_EVENT_COUNT] = {0};
+
+void boot_mark(BootEvent ev)
+{
+  if (ev >= BOOT_EVENT_COUNT || g_ms[ev] != 0) return;
+  const uint32_t now = millis();
+  g_ms[ev] = (now == 0) ? 1 : now;
+}
+
+uint32_t boot_ms(BootEvent ev)
+{
+  return (ev < BOOT_EVENT_COUNT) ? g_ms[ev] : 0;
+}
+
+String boot_metrics_json()
+{
+  String out;
+  out.reserve(160);
+  out += "{";
+  for (uint8_t i = 0; i < BOOT_EVENT_COUNT; ++i)
+  {
+    if (i > 0) out += ",";
+    out += "\"" + String(kNames[i]) + "\":" + String(g_ms[i]);
+  }
+  out += "}";
+  return out;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Milliseconds since power-on at which each bring-up milestone was first
+// reached. 0 means not reached yet.
+
+enum BootEvent : uint8_t {
+  BOOT_HTTP_READY = 0,
+  BOOT_WIFI_UP,
+  BOOT_TIME_VALID,
+  BOOT_OTA_READY,
+  BOOT_FIRST_TELEGRAM,
+  BOOT_FIRST_HTTP_200,
+  BOOT_EVENT_COUNT,
+};
+
+// Only the first call per event is kept.
+void boot_mark(BootEvent ev);
+uint32_t boot_ms(BootEvent ev);
+
+// JSON object without a trailing comma, e.g. {"http_ready_ms":180,...}.
+String boot_metrics_json();
@@ -0,0 +1,126 @@
+#include "capacity_guard.h"
+
+static const float LIVE_TAU_MS = 30000.0f;  // smoothing of live power
+static const float CLEAR_RATIO = 0.95f;     // alert clears below 95 % of budget
+
+static CapacityGuardState g_state;
+
+// Highest average this hour may reach before the basis passes limitKw. The
+// hour only counts as today's maximum, which competes with earlier days.
+static float hour_budget_kw(const float top3[3], float limitKw)
+{
+  float sum = 0.0f;
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    if (top3[i] > 0.01f)
+    {
+      sum += top3[i];
+      ++n;
+    }
+  }
+  if (n < 3) return limitKw * (n + 1) - sum;
+  // Full: this hour would replace the smallest, and only matters above it.
+  const float replace = limitKw * 3.0f - top3[0] - top3[1];
+  return (replace > top3[2]) ? replace : top3[2];
+}
+
+void capacity_guard_update(const AccumResult& hour, float liveW, const CapacityPeaks& peaks,
+                           const CompiledTariff& t, uint32_t epoch, uint32_t dtMs)
+{
+  CapacityGuardState& s = g_state;
+  const float liveKw = (isnan(liveW) || liveW < 0.0f) ? 0.0f : liveW / 1000.0f;
+  if (!s.valid)
+  {
+    s.live_kw = liveKw;
+  }
+  else
+  {
+    const float a = (dtMs >= LIVE_TAU_MS) ? 1.0f : dtMs / LIVE_TAU_MS;
+    s.live_kw += (liveKw - s.live_kw) * a;
+  }
+
+  if (hour.start == 0 || epoch < hour.start)
+  {
+    s.valid = false;
+    return;
+  }
+  s.valid = true;
+
+  const uint32_t elapsed = epoch - hour.start;
+  const uint32_t left = (elapsed < 3600UL) ? 3600UL - elapsed : 0;
+  s.hour_start = hour.start;
+  s.seconds_left = static_cast<uint16_t>(left);
+  s.hour_kwh = hour.energy_kwh;
+  s.projected_kw = hour.energy_kwh + s.live_kw * left / 3600.0f;
+
+  // Tier from the current basis, today included.
+  const float mean = capacity_peaks_mean_kw(peaks);
+  const int8_t tier = tariff_capacity_tier(t, mean);
+  const bool capped = tier < 0 || t.tiers[tier].limit_kw < mean;  // already above the largest tier
+  if (capped)
+  {
+    s.tier_limit_kw = NAN;
+    s.budget_kw = NAN;
+    s.remaining_kw = NAN;
+    s.next_step_nok_month = 0.0f;
+    s.alert = false;
+    return;
+  }
+
+  s.tier_limit_kw = t.tiers[tier].limit_kw;
+  s.budget_kw = hour_budget_kw(peaks.top3_kw, s.tier_limit_kw);
+  s.next_step_nok_month = (tier + 1 < t.tier_count) ? t.tiers[tier + 1].monthly_nok - t.tiers[tier].monthly_nok : 0.0f;
+  if (left > 0)
+  {
+    const float r = (s.budget_kw - s.hour_kwh) * 3600.0f / left;
+    s.remaining_kw = (r > 0.0f) ? r : 0.0f;
+  }
+  else
+  {
+    s.remaining_kw = 0.0f;
+  }
+
+  if (!s.alert && s.projected_kw > s.budget_kw)
+  {
+    s.alert = true;
+    s.alert_epoch = epoch;
+    ++s.alerts;
+  }
+  else if (s.alert && s.projected_kw < s.budget_kw * CLEAR_RATIO)
+  {
+    s.alert = false;
+  }
+}
+
+const CapacityGuardState& capacity_guard_state()
+{
+  return g_state;
+}
+
+// NAN is part of the state (no tier, above the largest); JSON has no NaN.
+static String json_num(float v, unsigned char decimals)
+{
+  return isfinite(v) ? String(v, decimals) : String("null");
+}
+
+String capacity_guard_json()
+{
+  const CapacityGuardState& s = g_state;
+  String out = "{";
+  out += "\"valid\":" + String(s.valid ? "true" : "false") + ",";
+  out += "\"alert\":" + String(s.alert ? "true" : "false") + ",";
+  out += "\"hour_start\":" + String(s.hour_start) + ",";
+  out += "\"seconds_left\":" + String(s.seconds_left) + ",";
+  out += "\"hour_kwh\":" + json_num(s.hour_kwh, 3) + ",";
+  out += "\"live_kw\":" + json_num(s.live_kw, 3) + ",";
+  out += "\"projected_kw\":" + json_num(s.projected_kw, 3) + ",";
+  out += "\"tier_limit_kw\":" + json_num(s.tier_limit_kw, 2) + ",";
+  out += "\"budget_kw\":" + json_num(s.budget_kw, 3) + ",";
+  out += "\"remaining_kw\":" + json_num(s.remaining_kw, 3) + ",";
+  out += "\"next_step_nok_month\":" + json_num(s.next_step_nok_month, 2) + ",";
+  out += "\"alert_epoch\":" + String(s.alert_epoch) + ",";
+  out += "\"alerts\":" + String(s.alerts);
+  out += "}";
+  return out;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+#include "capacity_peaks.h"
+#include "energy_accum.h"
+#include "tariff_engine.h"
+
+// Early warning for the capacity charge. Every second the open hour is
+// projected to its end from the energy so far plus smoothed live power,
+// and compared with the largest hourly average that still keeps the
+// month's capacity basis (capacity_peaks.h) within the current tier. O(1)
+// per update.
+
+struct CapacityGuardState {
+  bool valid = false;
+  bool alert = false;
+  uint32_t hour_start = 0;
+  uint16_t seconds_left = 0;
+  float hour_kwh = 0.0f;        // so far this hour
+  float live_kw = 0.0f;         // smoothed
+  float projected_kw = 0.0f;    // hour average if live power holds
+  float tier_limit_kw = NAN;    // tier in force; NAN above the largest
+  float budget_kw = NAN;        // highest hour average that keeps the tier
+  float remaining_kw = NAN;     // average power allowed for the rest of the hour
+  float next_step_nok_month = 0.0f;  // added monthly charge if the tier is exceeded
+  uint32_t alert_epoch = 0;     // when the current alert was raised
+  uint32_t alerts = 0;          // raised since boot
+};
+
+// peaks: the month's daily maxima so far, today's up to the last closed hour.
+void capacity_guard_update(const AccumResult& hour, float liveW, const CapacityPeaks& peaks,
+                           const CompiledTariff& t, uint32_t epoch, uint32_t dtMs);
+
+const CapacityGuardState& capacity_guard_state();
+String capacity_guard_json();
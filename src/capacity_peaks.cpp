@@ -0,0 +1,53 @@
+#include "capacity_peaks.h"
+
+static void insert(float top3[3], float kw)
+{
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    if (kw > top3[i])
+    {
+      const float t = top3[i];
+      top3[i] = kw;
+      kw = t;
+    }
+  }
+}
+
+void capacity_peaks_add_hour(CapacityPeaks& p, float kw)
+{
+  if (kw > p.day_max_kw) p.day_max_kw = kw;
+}
+
+void capacity_peaks_close_day(CapacityPeaks& p)
+{
+  insert(p.top3_kw, p.day_max_kw);
+  p.day_max_kw = 0.0f;
+}
+
+void capacity_peaks_reset(CapacityPeaks& p)
+{
+  p = CapacityPeaks();
+}
+
+void capacity_peaks_top3(const CapacityPeaks& p, float out[3])
+{
+  for (uint8_t i = 0; i < 3; ++i) out[i] = p.top3_kw[i];
+  insert(out, p.day_max_kw);
+}
+
+float capacity_peaks_mean_kw(const CapacityPeaks& p)
+{
+  float top3[3];
+  capacity_peaks_top3(p, top3);
+  float sum = 0.0f;
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    if (top3[i] > 0.01f)
+    {
+      sum += top3[i];
+      ++n;
+    }
+  }
+  return n ? sum / n : 0.0f;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+// Capacity charge basis (kapasitetsledd): the mean of the three highest
+// daily maxima of the hourly average in a month, one per day. Hours feed
+// today's maximum; a closed day competes for the month's top three. Used
+// by the live tariff, the capacity guard and the what-if simulator alike.
+
+struct CapacityPeaks {
+  float day_max_kw = 0.0f;                 // highest hourly average today
+  float top3_kw[3] = {0.0f, 0.0f, 0.0f};   // earlier days' maxima, descending
+};
+
+void capacity_peaks_add_hour(CapacityPeaks& p, float kw);
+void capacity_peaks_close_day(CapacityPeaks& p);
+void capacity_peaks_reset(CapacityPeaks& p);
+
+// The month's top three with today counted, descending (0 = none yet).
+void capacity_peaks_top3(const CapacityPeaks& p, float out[3]);
+
+// Mean of the non-zero entries of capacity_peaks_top3.
+float capacity_peaks_mean_kw(const CapacityPeaks& p);
@@ -22,6 +22,18 @@ static String normalized_zone(const String& in)
   return "NO1";
 }
 
+static String normalized_han_serial(const String& in)
+{
+  if (in == "8N1" || in == "8E1") return in;
+  return "8N1";
+}
+
+static String normalized_han_protocol(const String& in)
+{
+  if (in == "AUTO" || in == "DSMR" || in == "HDLC") return in;
+  return "AUTO";
+}
+
 static String normalized_tariff_profile(const String& in)
 {
   if (in == "ELVIA_EXAMPLE" || in == "BKK_EXAMPLE" || in == "TENSIO_EXAMPLE" || in == "CUSTOM") return in;
@@ -51,34 +63,43 @@ String DeviceConfig::ap_ssid() const
   return String("HANReader-") + chip_suffix4();
 }
 
+static constexpr TariffProfile kTariffProfiles[] = {
+  {"ELVIA_EXAMPLE", 39.0f, 31.0f, 31.0f, 49.0f,
+   {{2, 219}, {5, 299}, {10, 399}, {15, 549}, {20, 699}, {25, 899}, {50, 1499}}},
+  {"BKK_EXAMPLE", 42.0f, 34.0f, 34.0f, 59.0f,
+   {{2, 229}, {5, 309}, {10, 419}, {15, 579}, {20, 739}, {25, 939}, {50, 1549}}},
+  {"TENSIO_EXAMPLE", 37.0f, 29.0f, 29.0f, 45.0f,
+   {{2, 209}, {5, 289}, {10, 389}, {15, 529}, {20, 679}, {25, 879}, {50, 1449}}},
+};
+
+const TariffProfile* config_tariff_profile(const String& name)
+{
+  for (const TariffProfile& p : kTariffProfiles)
+  {
+    if (name == p.name) return &p;
+  }
+  return nullptr;
+}
+
 void config_apply_tariff_profile(DeviceConfig& cfg, bool force)
 {
   if (!force && cfg.tariff_profile == "CUSTOM") return;
 
-  if (cfg.tariff_profile == "ELVIA_EXAMPLE")
-  {
-    cfg.tariff_energy_day_ore = 39.0f;
-    cfg.tariff_energy_night_ore = 31.0f;
-    cfg.tariff_energy_weekend_ore = 31.0f;
-    cfg.tariff_fixed_monthly_nok = 49.0f;
-    cfg.tariff_capacity_tiers = "2:219,5:299,10:399,15:549,20:699,25:899,50:1499";
-  }
-  else if (cfg.tariff_profile == "BKK_EXAMPLE")
-  {
-    cfg.tariff_energy_day_ore = 42.0f;
-    cfg.tariff_energy_night_ore = 34.0f;
-    cfg.tariff_energy_weekend_ore = 34.0f;
-    cfg.tariff_fixed_monthly_nok = 59.0f;
-    cfg.tariff_capacity_tiers = "2:229,5:309,10:419,15:579,20:739,25:939,50:1549";
-  }
-  else if (cfg.tariff_profile == "TENSIO_EXAMPLE")
+  const TariffProfile* p = config_tariff_profile(cfg.tariff_profile);
+  if (!p) return;
+  cfg.tariff_energy_day_ore = p->energy_day_ore;
+  cfg.tariff_energy_night_ore = p->energy_night_ore;
+  cfg.tariff_energy_weekend_ore = p->energy_weekend_ore;
+  cfg.tariff_fixed_monthly_nok = p->fixed_monthly_nok;
+
+  // The admin field stays the editable "kW:NOK,..." text.
+  char buf[TARIFF_PROFILE_TIERS * 16];
+  size_t n = 0;
+  for (uint8_t i = 0; i < TARIFF_PROFILE_TIERS && n < sizeof(buf); ++i)
   {
-    cfg.tariff_energy_day_ore = 37.0f;
-    cfg.tariff_energy_night_ore = 29.0f;
-    cfg.tariff_energy_weekend_ore = 29.0f;
-    cfg.tariff_fixed_monthly_nok = 45.0f;
-    cfg.tariff_capacity_tiers = "2:209,5:289,10:389,15:529,20:679,25:879,50:1449";
+    n += snprintf(buf + n, sizeof(buf) - n, "%s%g:%g", i ? "," : "", p->tiers[i].limit_kw, p->tiers[i].monthly_nok);
   }
+  cfg.tariff_capacity_tiers = buf;
 }
 
 DeviceConfig config_load()
@@ -118,11 +139,18 @@ DeviceConfig config_load()
   cfg.han_tx_pin = prefs.getInt("hantx", 43);
   cfg.han_invert = prefs.getBool("haninv", false);
   cfg.han_baud = prefs.getUInt("hanbaud", 115200);
+  cfg.han_serial = normalized_han_serial(prefs.getString("hanser", "8N1"));
+  cfg.han_protocol = normalized_han_protocol(prefs.getString("hanproto", "AUTO"));
+  cfg.han_autodetect = prefs.getBool("hanauto", true);
 
   cfg.price_zone = normalized_zone(prefs.getString("zone", "NO1"));
   cfg.price_api_enabled = prefs.getBool("papi", true);
   cfg.manual_spot_enabled = prefs.getBool("mspot", false);
   cfg.manual_spot_nok_kwh = prefs.getFloat("mspotv", 1.25f);
+  cfg.price_entsoe_token = prefs.getString("entsoe", "");
+  cfg.price_eur_nok = prefs.getFloat("eurnok", 11.5f);
+  cfg.price_custom_url = prefs.getString("purl", "");
+  cfg.price_custom_unverified = prefs.getBool("purlins", false);
 
   cfg.tariff_profile = normalized_tariff_profile(prefs.getString("tprof", "CUSTOM"));
   cfg.tariff_energy_day_ore = prefs.getFloat("teday", 35.0f);
@@ -137,6 +165,10 @@ DeviceConfig config_load()
   cfg.tariff_include_vat = prefs.getBool("tvaton", true);
   cfg.tariff_vat_percent = prefs.getFloat("tvat", 25.0f);
   cfg.tariff_capacity_tiers = prefs.getString("tcap", "2:199,5:279,10:379,15:519,20:669,25:869,50:1399");
+  cfg.tariff_holidays_off = prefs.getBool("thol", true);
+  cfg.tariff_bands = prefs.getString("tbands", "");
+  cfg.tariff_winter_months = prefs.getString("twin", "");
+  cfg.tariff_winter_extra_ore = prefs.getFloat("twinore", 0.0f);
 
   if (cfg.tariff_day_start_hour < 0) cfg.tariff_day_start_hour = 0;
   if (cfg.tariff_day_start_hour > 23) cfg.tariff_day_start_hour = 23;
@@ -175,11 +207,18 @@ void config_save(const DeviceConfig& cfg)
   prefs.putInt("hantx", cfg.han_tx_pin);
   prefs.putBool("haninv", cfg.han_invert);
   prefs.putUInt("hanbaud", cfg.han_baud);
+  prefs.putString("hanser", normalized_han_serial(cfg.han_serial));
+  prefs.putString("hanproto", normalized_han_protocol(cfg.han_protocol));
+  prefs.putBool("hanauto", cfg.han_autodetect);
 
   prefs.putString("zone", normalized_zone(cfg.price_zone));
   prefs.putBool("papi", cfg.price_api_enabled);
   prefs.putBool("mspot", cfg.manual_spot_enabled);
   prefs.putFloat("mspotv", cfg.manual_spot_nok_kwh);
+  prefs.putString("entsoe", cfg.price_entsoe_token);
+  prefs.putFloat("eurnok", cfg.price_eur_nok);
+  prefs.putString("purl", cfg.price_custom_url);
+  prefs.putBool("purlins", cfg.price_custom_unverified);
 
   prefs.putString("tprof", normalized_tariff_profile(cfg.tariff_profile));
   prefs.putFloat("teday", cfg.tariff_energy_day_ore);
@@ -194,6 +233,10 @@ void config_save(const DeviceConfig& cfg)
   prefs.putBool("tvaton", cfg.tariff_include_vat);
   prefs.putFloat("tvat", cfg.tariff_vat_percent);
   prefs.putString("tcap", cfg.tariff_capacity_tiers);
+  prefs.putBool("thol", cfg.tariff_holidays_off);
+  prefs.putString("tbands", cfg.tariff_bands);
+  prefs.putString("twin", cfg.tariff_winter_months);
+  prefs.putFloat("twinore", cfg.tariff_winter_extra_ore);
 
   prefs.putBool("homey", cfg.homey_enabled);
   prefs.putBool("ha", cfg.ha_enabled);
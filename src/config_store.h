@@ -2,10 +2,18 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include "tariff_core.h"
 
-struct TariffTier {
-  float limit_kw;
-  float monthly_nok;
+// Built-in DSO example, applied over the editable tariff fields.
+static const uint8_t TARIFF_PROFILE_TIERS = 7;
+
+struct TariffProfile {
+  const char* name;
+  float energy_day_ore;
+  float energy_night_ore;
+  float energy_weekend_ore;
+  float fixed_monthly_nok;
+  TariffTier tiers[TARIFF_PROFILE_TIERS];
 };
 
 struct DeviceConfig {
@@ -32,11 +40,18 @@ struct DeviceConfig {
   int han_tx_pin;
   bool han_invert;
   uint32_t han_baud;
+  String han_serial;   // 8N1/8E1
+  String han_protocol; // AUTO/DSMR/HDLC
+  bool han_autodetect;
 
   String price_zone; // NO1..NO5
   bool price_api_enabled;
   bool manual_spot_enabled;
   float manual_spot_nok_kwh;
+  String price_entsoe_token;  // ENTSO-E transparency API token; empty = provider off
+  float price_eur_nok;        // for ENTSO-E EUR/MWh prices
+  String price_custom_url;    // hvakosterstrommen-style JSON, {Y} {M} {D} {zone}
+  bool price_custom_unverified; // allow https to the own URL without a pinned CA
 
   String tariff_profile; // CUSTOM/ELVIA_EXAMPLE/BKK_EXAMPLE/TENSIO_EXAMPLE
   float tariff_energy_day_ore;
@@ -51,6 +66,10 @@ struct DeviceConfig {
   bool tariff_include_vat;
   float tariff_vat_percent;
   String tariff_capacity_tiers; // "2:219,5:299,..."
+  bool tariff_holidays_off;     // public holidays priced as weekend
+  String tariff_bands;          // workday bands over day/night, "07-11:52,17-21:52"
+  String tariff_winter_months;  // "1-3,11-12"
+  float tariff_winter_extra_ore;
 
   bool homey_enabled;
   bool ha_enabled;
@@ -64,3 +83,4 @@ void config_save(const DeviceConfig& cfg);
 void config_factory_reset();
 String config_chip_suffix4();
 void config_apply_tariff_profile(DeviceConfig& cfg, bool force);
+const TariffProfile* config_tariff_profile(const String& name);  // nullptr for CUSTOM
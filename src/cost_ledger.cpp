@@ -0,0 +1,198 @@
+#include "cost_ledger.h"
+#include "time_service.h"
+
+#include <time.h>
+
+static CostLedgerState g_state;
+static float g_capacity_nok = 0.0f;
+static float g_fixed_nok = 0.0f;
+static float g_vat_factor = 1.0f;
+
+static const char* const kPartNames[COST_PART_COUNT] = {"spot", "energy", "elavgift", "enova", "capacity", "fixed", "vat"};
+
+static int64_t to_unok(double nok)
+{
+  return static_cast<int64_t>(llround(nok * 1e6));
+}
+
+// Seconds in the local month containing `start`.
+static uint32_t month_seconds(uint32_t start)
+{
+  static const uint8_t kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  time_t at = static_cast<time_t>(start);
+  tm local;
+  localtime_r(&at, &local);
+  const int y = local.tm_year + 1900;
+  const bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+  return (kDays[local.tm_mon] + (local.tm_mon == 1 && leap ? 1 : 0)) * 86400UL;
+}
+
+// Capacity and fixed fee for `seconds` of the month the window started in.
+static void add_monthly_share(CostWindowState& w, uint32_t seconds)
+{
+  if (w.start == 0 || seconds == 0) return;
+  const double share = static_cast<double>(seconds) / month_seconds(w.start);
+  const double capacity = g_capacity_nok * share;
+  const double fixed = g_fixed_nok * share;
+  w.unok[COST_CAPACITY] += to_unok(capacity);
+  w.unok[COST_FIXED] += to_unok(fixed);
+  w.unok[COST_VAT] += to_unok((capacity + fixed) * (g_vat_factor - 1.0f));
+}
+
+static CostTotals totals(const CostWindowState& w)
+{
+  CostTotals t;
+  t.start = w.start;
+  t.kwh = static_cast<float>(w.energy_mwh / 1e6);
+  int64_t sum = 0;
+  for (uint8_t i = 0; i < COST_PART_COUNT; ++i)
+  {
+    t.part_nok[i] = static_cast<float>(w.unok[i] / 1e6);
+    sum += w.unok[i];
+  }
+  t.total_nok = static_cast<float>(sum / 1e6);
+  t.estimated_kwh = static_cast<float>(w.estimated_mwh / 1e6);
+  t.estimated_nok = static_cast<float>(w.estimated_unok / 1e6);
+  t.unpriced_min = w.unpriced_min;
+  return t;
+}
+
+void cost_ledger_charge(float kwh, float spot_nok_kwh, const CompiledTariff& t, const tm& local)
+{
+  if (isnan(kwh) || kwh == 0.0f) return;
+  const uint8_t idx = tariff_rate_index(t, local);
+  const bool unpriced = isnan(spot_nok_kwh);
+  const double spot = unpriced ? 0.0 : static_cast<double>(kwh) * spot_nok_kwh;
+  const double energy = static_cast<double>(kwh) * t.energy_nok_kwh[idx];
+  const double elavgift = static_cast<double>(kwh) * t.elavgift_nok_kwh;
+  const double enova = static_cast<double>(kwh) * t.enova_nok_kwh;
+
+  int64_t parts[COST_PART_COUNT] = {0};
+  parts[COST_SPOT] = to_unok(spot);
+  parts[COST_ENERGY] = to_unok(energy);
+  parts[COST_ELAVGIFT] = to_unok(elavgift);
+  parts[COST_ENOVA] = to_unok(enova);
+  parts[COST_VAT] = to_unok((spot + energy + elavgift + enova) * (t.vat_factor - 1.0f));
+  const int64_t mwh = static_cast<int64_t>(llround(kwh * 1e6));
+
+  for (uint8_t s = 0; s < COST_SPAN_COUNT; ++s)
+  {
+    CostWindowState& w = g_state.open[s];
+    w.energy_mwh += mwh;
+    for (uint8_t i = 0; i < COST_PART_COUNT; ++i) w.unok[i] += parts[i];
+    if (unpriced) ++w.unpriced_min;
+  }
+}
+
+bool cost_ledger_charge_estimated(float kwh)
+{
+  if (isnan(kwh) || kwh == 0.0f) return true;
+  // The open month holds metered parts only (capacity and fixed are added
+  // when it is read or closed), so its ratio is the average energy rate.
+  // Earlier estimates were charged at that rate and do not shift it.
+  const CostWindowState& month = g_state.open[COST_MONTH];
+  if (month.energy_mwh <= 0) return false;
+
+  const int64_t mwh = static_cast<int64_t>(llround(kwh * 1e6));
+  const double scale = static_cast<double>(mwh) / month.energy_mwh;
+  int64_t parts[COST_PART_COUNT] = {0};
+  int64_t sum = 0;
+  for (uint8_t i = 0; i < COST_PART_COUNT; ++i)
+  {
+    parts[i] = static_cast<int64_t>(llround(month.unok[i] * scale));
+    sum += parts[i];
+  }
+
+  for (uint8_t s = 0; s < COST_SPAN_COUNT; ++s)
+  {
+    CostWindowState& w = g_state.open[s];
+    w.energy_mwh += mwh;
+    w.estimated_mwh += mwh;
+    w.estimated_unok += sum;
+    for (uint8_t i = 0; i < COST_PART_COUNT; ++i) w.unok[i] += parts[i];
+  }
+  return true;
+}
+
+void cost_ledger_set_monthly(float capacity_nok, float fixed_nok, float vat_factor)
+{
+  g_capacity_nok = isnan(capacity_nok) ? 0.0f : capacity_nok;
+  g_fixed_nok = fixed_nok;
+  g_vat_factor = vat_factor;
+}
+
+CostTotals cost_ledger_current(CostSpan span)
+{
+  if (span >= COST_SPAN_COUNT) return CostTotals();
+  CostWindowState w = g_state.open[span];
+  const TimeNow& now = time_now();
+  if (now.valid && w.start != 0 && static_cast<uint32_t>(now.epoch) > w.start)
+  {
+    add_monthly_share(w, static_cast<uint32_t>(now.epoch) - w.start);
+  }
+  return totals(w);
+}
+
+CostTotals cost_ledger_last(CostSpan span)
+{
+  if (span >= COST_SPAN_COUNT) return CostTotals();
+  return totals(g_state.last[span]);
+}
+
+void cost_ledger_close(CostSpan span, uint32_t nextStart)
+{
+  if (span >= COST_SPAN_COUNT) return;
+  CostWindowState& w = g_state.open[span];
+  if (w.start != 0 && nextStart > w.start) add_monthly_share(w, nextStart - w.start);
+  g_state.last[span] = w;
+  w = CostWindowState();
+  w.start = nextStart;
+}
+
+void cost_ledger_set_start(CostSpan span, uint32_t start)
+{
+  if (span < COST_SPAN_COUNT) g_state.open[span].start = start;
+}
+
+void cost_ledger_export(CostLedgerState& out)
+{
+  out = g_state;
+}
+
+void cost_ledger_import(const CostLedgerState& in)
+{
+  g_state = in;
+}
+
+const char* cost_part_name(CostPart part)
+{
+  return (part < COST_PART_COUNT) ? kPartNames[part] : "?";
+}
+
+static String totals_json(const CostTotals& t)
+{
+  String out = "{";
+  out += "\"start\":" + String(t.start) + ",";
+  out += "\"kwh\":" + String(t.kwh, 3) + ",";
+  out += "\"total_nok\":" + String(t.total_nok, 2) + ",";
+  out += "\"estimated_kwh\":" + String(t.estimated_kwh, 3) + ",";
+  out += "\"estimated_nok\":" + String(t.estimated_nok, 2) + ",";
+  out += "\"unpriced_min\":" + String(t.unpriced_min);
+  for (uint8_t i = 0; i < COST_PART_COUNT; ++i)
+  {
+    out += ",\"" + String(kPartNames[i]) + "\":" + String(t.part_nok[i], 2);
+  }
+  out += "}";
+  return out;
+}
+
+String cost_ledger_json()
+{
+  String out = "{";
+  out += "\"day\":" + totals_json(cost_ledger_current(COST_DAY)) + ",";
+  out += "\"month\":" + totals_json(cost_ledger_current(COST_MONTH)) + ",";
+  out += "\"last_day\":" + totals_json(cost_ledger_last(COST_DAY)) + ",";
+  out += "\"last_month\":" + totals_json(cost_ledger_last(COST_MONTH));
+  out += "}";
+  return out;
+}
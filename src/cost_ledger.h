@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>
+#include "tariff_engine.h"
+
+// What the energy actually cost. Each closed minute is charged at the spot
+// and grid price that were in force during it, split by component, into
+// running day and month windows (64-bit integer micro-NOK). Capacity and
+// the fixed fee are monthly amounts; they are added pro rata for the time
+// a window covers, at the capacity step in force when it is read or closed.
+// Charging and closing are O(1); nothing rescans history.
+//
+// Register corrections (energy the meter counted but integration missed,
+// e.g. while the device was down) have no minute to be priced in. They are
+// charged at the month's average rate so far and reported as estimated.
+// Minutes without a spot price are charged grid parts only and counted.
+
+enum CostSpan : uint8_t {
+  COST_DAY = 0,
+  COST_MONTH,
+  COST_SPAN_COUNT,
+};
+
+enum CostPart : uint8_t {
+  COST_SPOT = 0,
+  COST_ENERGY,     // DSO energy charge (energiledd)
+  COST_ELAVGIFT,
+  COST_ENOVA,
+  COST_CAPACITY,   // kapasitetsledd
+  COST_FIXED,      // fastledd
+  COST_VAT,
+  COST_PART_COUNT,
+};
+
+struct CostWindowState {
+  uint32_t start = 0;
+  int64_t energy_mwh = 0;               // charged import, mWh
+  int64_t unok[COST_PART_COUNT] = {0};  // micro-NOK; capacity/fixed only once closed
+  int64_t estimated_mwh = 0;            // corrections, included in energy_mwh
+  int64_t estimated_unok = 0;           // their share of unok
+  uint32_t unpriced_min = 0;            // intervals charged without a spot price
+};
+
+struct CostLedgerState {
+  CostWindowState open[COST_SPAN_COUNT];
+  CostWindowState last[COST_SPAN_COUNT];
+};
+
+struct CostTotals {
+  uint32_t start = 0;
+  float kwh = 0.0f;
+  float total_nok = 0.0f;
+  float part_nok[COST_PART_COUNT] = {0.0f};
+  float estimated_kwh = 0.0f;
+  float estimated_nok = 0.0f;
+  uint32_t unpriced_min = 0;
+};
+
+// Charges one closed interval that started at local time `local`. A NaN spot
+// price charges the grid parts only and counts the interval as unpriced.
+void cost_ledger_charge(float kwh, float spot_nok_kwh, const CompiledTariff& t, const tm& local);
+
+// Charges a register correction (may be negative) at the open month's average
+// rate per part. Returns false, charging nothing, while the month has no
+// energy to take a rate from.
+bool cost_ledger_charge_estimated(float kwh);
+
+// Monthly amounts used for the pro-rata parts; set on each tariff update.
+void cost_ledger_set_monthly(float capacity_nok, float fixed_nok, float vat_factor);
+
+CostTotals cost_ledger_current(CostSpan span);
+CostTotals cost_ledger_last(CostSpan span);
+
+// Closes the open window (adding its capacity/fixed share) and starts the next.
+void cost_ledger_close(CostSpan span, uint32_t nextStart);
+void cost_ledger_set_start(CostSpan span, uint32_t start);
+
+void cost_ledger_export(CostLedgerState& out);
+void cost_ledger_import(const CostLedgerState& in);
+
+const char* cost_part_name(CostPart part);
+String cost_ledger_json();
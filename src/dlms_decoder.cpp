@@ -0,0 +1,427 @@
+#include "dlms_decoder.h"
+
+static const uint8_t HDLC_FLAG = 0x7E;
+
+// CRC-16/X.25 (HDLC FCS), reflected poly 0x8408.
+static const uint16_t kFcsTable[256] = {
+  0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF,
+  0x8C48, 0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7,
+  0x1081, 0x0108, 0x3393, 0x221A, 0x56A5, 0x472C, 0x75B7, 0x643E,
+  0x9CC9, 0x8D40, 0xBFDB, 0xAE52, 0xDAED, 0xCB64, 0xF9FF, 0xE876,
+  0x2102, 0x308B, 0x0210, 0x1399, 0x6726, 0x76AF, 0x4434, 0x55BD,
+  0xAD4A, 0xBCC3, 0x8E58, 0x9FD1, 0xEB6E, 0xFAE7, 0xC87C, 0xD9F5,
+  0x3183, 0x200A, 0x1291, 0x0318, 0x77A7, 0x662E, 0x54B5, 0x453C,
+  0xBDCB, 0xAC42, 0x9ED9, 0x8F50, 0xFBEF, 0xEA66, 0xD8FD, 0xC974,
+  0x4204, 0x538D, 0x6116, 0x709F, 0x0420, 0x15A9, 0x2732, 0x36BB,
+  0xCE4C, 0xDFC5, 0xED5E, 0xFCD7, 0x8868, 0x99E1, 0xAB7A, 0xBAF3,
+  0x5285, 0x430C, 0x7197, 0x601E, 0x14A1, 0x0528, 0x37B3, 0x263A,
+  0xDECD, 0xCF44, 0xFDDF, 0xEC56, 0x98E9, 0x8960, 0xBBFB, 0xAA72,
+  0x6306, 0x728F, 0x4014, 0x519D, 0x2522, 0x34AB, 0x0630, 0x17B9,
+  0xEF4E, 0xFEC7, 0xCC5C, 0xDDD5, 0xA96A, 0xB8E3, 0x8A78, 0x9BF1,
+  0x7387, 0x620E, 0x5095, 0x411C, 0x35A3, 0x242A, 0x16B1, 0x0738,
+  0xFFCF, 0xEE46, 0xDCDD, 0xCD54, 0xB9EB, 0xA862, 0x9AF9, 0x8B70,
+  0x8408, 0x9581, 0xA71A, 0xB693, 0xC22C, 0xD3A5, 0xE13E, 0xF0B7,
+  0x0840, 0x19C9, 0x2B52, 0x3ADB, 0x4E64, 0x5FED, 0x6D76, 0x7CFF,
+  0x9489, 0x8500, 0xB79B, 0xA612, 0xD2AD, 0xC324, 0xF1BF, 0xE036,
+  0x18C1, 0x0948, 0x3BD3, 0x2A5A, 0x5EE5, 0x4F6C, 0x7DF7, 0x6C7E,
+  0xA50A, 0xB483, 0x8618, 0x9791, 0xE32E, 0xF2A7, 0xC03C, 0xD1B5,
+  0x2942, 0x38CB, 0x0A50, 0x1BD9, 0x6F66, 0x7EEF, 0x4C74, 0x5DFD,
+  0xB58B, 0xA402, 0x9699, 0x8710, 0xF3AF, 0xE226, 0xD0BD, 0xC134,
+  0x39C3, 0x284A, 0x1AD1, 0x0B58, 0x7FE7, 0x6E6E, 0x5CF5, 0x4D7C,
+  0xC60C, 0xD785, 0xE51E, 0xF497, 0x8028, 0x91A1, 0xA33A, 0xB2B3,
+  0x4A44, 0x5BCD, 0x6956, 0x78DF, 0x0C60, 0x1DE9, 0x2F72, 0x3EFB,
+  0xD68D, 0xC704, 0xF59F, 0xE416, 0x90A9, 0x8120, 0xB3BB, 0xA232,
+  0x5AC5, 0x4B4C, 0x79D7, 0x685E, 0x1CE1, 0x0D68, 0x3FF3, 0x2E7A,
+  0xE70E, 0xF687, 0xC41C, 0xD595, 0xA12A, 0xB0A3, 0x8238, 0x93B1,
+  0x6B46, 0x7ACF, 0x4854, 0x59DD, 0x2D62, 0x3CEB, 0x0E70, 0x1FF9,
+  0xF78F, 0xE606, 0xD49D, 0xC514, 0xB1AB, 0xA022, 0x92B9, 0x8330,
+  0x7BC7, 0x6A4E, 0x58D5, 0x495C, 0x3DE3, 0x2C6A, 0x1EF1, 0x0F78,
+};
+
+struct DlmsMap {
+  uint8_t a, c, d, e;
+  ObisEvent field;
+  int8_t scaler; // used when the meter sends no scaler/unit structure
+  bool kilo;     // W -> kW, Wh -> kWh
+};
+
+static const DlmsMap kObisMap[] = {
+  {1, 32, 7, 0, OBIS_VOLTAGE_L1, 0, false},
+  {1, 52, 7, 0, OBIS_VOLTAGE_L2, 0, false},
+  {1, 72, 7, 0, OBIS_VOLTAGE_L3, 0, false},
+  {1, 31, 7, 0, OBIS_CURRENT_L1, -2, false},
+  {1, 51, 7, 0, OBIS_CURRENT_L2, -2, false},
+  {1, 71, 7, 0, OBIS_CURRENT_L3, -2, false},
+  {1, 21, 7, 0, OBIS_POWER_L1_KW, 0, true},
+  {1, 41, 7, 0, OBIS_POWER_L2_KW, 0, true},
+  {1, 61, 7, 0, OBIS_POWER_L3_KW, 0, true},
+  {1, 1, 7, 0, OBIS_IMPORT_POWER_KW, 0, true},
+  {1, 2, 7, 0, OBIS_EXPORT_POWER_KW, 0, true},
+  {1, 1, 8, 0, OBIS_IMPORT_ENERGY_KWH, 1, true},
+  {1, 2, 8, 0, OBIS_EXPORT_ENERGY_KWH, 1, true},
+  {0, 96, 1, 0, OBIS_HEADER, 0, false},
+  {1, 0, 0, 5, OBIS_HEADER, 0, false},
+};
+
+// Kaifa sends bare values without OBIS codes; position depends on list size.
+static const DlmsMap kKaifaList1[] = {
+  {0, 0, 0, 0, OBIS_IMPORT_POWER_KW, 0, true},
+};
+
+static const DlmsMap kKaifa1Phase[] = {
+  {0, 0, 0, 0, OBIS_IMPORT_POWER_KW, 0, true},
+  {0, 0, 0, 0, OBIS_EXPORT_POWER_KW, 0, true},
+  {0, 0, 0, 0, OBIS_NONE, 0, false},
+  {0, 0, 0, 0, OBIS_NONE, 0, false},
+  {0, 0, 0, 0, OBIS_CURRENT_L1, -3, false},
+  {0, 0, 0, 0, OBIS_VOLTAGE_L1, -1, false},
+  {0, 0, 0, 0, OBIS_IMPORT_ENERGY_KWH, 0, true},
+  {0, 0, 0, 0, OBIS_EXPORT_ENERGY_KWH, 0, true},
+};
+
+static const DlmsMap kKaifa3Phase[] = {
+  {0, 0, 0, 0, OBIS_IMPORT_POWER_KW, 0, true},
+  {0, 0, 0, 0, OBIS_EXPORT_POWER_KW, 0, true},
+  {0, 0, 0, 0, OBIS_NONE, 0, false},
+  {0, 0, 0, 0, OBIS_NONE, 0, false},
+  {0, 0, 0, 0, OBIS_CURRENT_L1, -3, false},
+  {0, 0, 0, 0, OBIS_CURRENT_L2, -3, false},
+  {0, 0, 0, 0, OBIS_CURRENT_L3, -3, false},
+  {0, 0, 0, 0, OBIS_VOLTAGE_L1, -1, false},
+  {0, 0, 0, 0, OBIS_VOLTAGE_L2, -1, false},
+  {0, 0, 0, 0, OBIS_VOLTAGE_L3, -1, false},
+  {0, 0, 0, 0, OBIS_IMPORT_ENERGY_KWH, 0, true},
+  {0, 0, 0, 0, OBIS_EXPORT_ENERGY_KWH, 0, true},
+};
+
+// 3-phase meters on IT grids (two current transformers) leave out I2.
+static const DlmsMap kKaifa3PhaseIT[] = {
+  {0, 0, 0, 0, OBIS_IMPORT_POWER_KW, 0, true},
+  {0, 0, 0, 0, OBIS_EXPORT_POWER_KW, 0, true},
+  {0, 0, 0, 0, OBIS_NONE, 0, false},
+  {0, 0, 0, 0, OBIS_NONE, 0, false},
+  {0, 0, 0, 0, OBIS_CURRENT_L1, -3, false},
+  {0, 0, 0, 0, OBIS_CURRENT_L3, -3, false},
+  {0, 0, 0, 0, OBIS_VOLTAGE_L1, -1, false},
+  {0, 0, 0, 0, OBIS_VOLTAGE_L2, -1, false},
+  {0, 0, 0, 0, OBIS_VOLTAGE_L3, -1, false},
+  {0, 0, 0, 0, OBIS_IMPORT_ENERGY_KWH, 0, true},
+  {0, 0, 0, 0, OBIS_EXPORT_ENERGY_KWH, 0, true},
+};
+
+static const float kPow10[] = {1e-4f, 1e-3f, 1e-2f, 1e-1f, 1.0f, 1e1f, 1e2f, 1e3f, 1e4f};
+
+uint16_t hdlc_crc16(const uint8_t* data, size_t len)
+{
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; ++i) crc = static_cast<uint16_t>((crc >> 8) ^ kFcsTable[(crc ^ data[i]) & 0xFF]);
+  return static_cast<uint16_t>(crc ^ 0xFFFF);
+}
+
+static bool crc_matches(const uint8_t* data, size_t len)
+{
+  const uint16_t stored = static_cast<uint16_t>(data[len] | (data[len + 1] << 8));
+  return hdlc_crc16(data, len) == stored;
+}
+
+static uint16_t skip_address(const uint8_t* buf, uint16_t i, uint16_t end)
+{
+  for (int n = 0; n < 4 && i < end; ++n)
+  {
+    if (buf[i++] & 0x01) return i;
+  }
+  return 0;
+}
+
+static bool validate_frame(HdlcDecoder& d)
+{
+  const uint16_t fcs_at = static_cast<uint16_t>(d.len - 2);
+  if (!crc_matches(d.buf, fcs_at)) return false;
+
+  uint16_t i = skip_address(d.buf, 2, fcs_at);
+  if (i == 0) return false;
+  i = skip_address(d.buf, i, fcs_at);
+  if (i == 0) return false;
+  ++i; // control
+
+  if (i + 2 > fcs_at) return false;
+  if (i + 2 == fcs_at)
+  {
+    d.info = fcs_at;
+    return true;
+  }
+  if (!crc_matches(d.buf, i)) return false;
+  d.info = static_cast<uint16_t>(i + 2);
+  return true;
+}
+
+void hdlc_decoder_reset(HdlcDecoder& d)
+{
+  d.len = 0;
+  d.expected = 0;
+  d.info = 0;
+  d.frame_len = 0;
+  d.in_frame = false;
+}
+
+bool hdlc_decoder_feed(HdlcDecoder& d, uint8_t b)
+{
+  if (!d.in_frame)
+  {
+    if (b == HDLC_FLAG)
+    {
+      d.in_frame = true;
+      d.len = 0;
+      d.expected = 0;
+    }
+    return false;
+  }
+
+  if (d.len == 0 && b == HDLC_FLAG) return false;
+
+  if (d.expected > 0 && d.len == d.expected)
+  {
+    // Closing flag; it may double as the opening flag of the next frame.
+    const bool ok = (b == HDLC_FLAG) && validate_frame(d);
+    if (ok) ++d.frames_ok;
+    else ++d.frames_bad;
+    d.frame_len = ok ? d.len : 0;
+    d.in_frame = (b == HDLC_FLAG);
+    d.len = 0;
+    d.expected = 0;
+    return ok;
+  }
+
+  d.buf[d.len++] = b;
+
+  if (d.len == 2)
+  {
+    const uint16_t n = static_cast<uint16_t>(((d.buf[0] & 0x07) << 8) | d.buf[1]);
+    if ((d.buf[0] & 0xF0) != 0xA0 || n < 7 || n > HDLC_MAX_FRAME)
+    {
+      ++d.frames_bad;
+      d.in_frame = (b == HDLC_FLAG);
+      d.len = 0;
+      return false;
+    }
+    d.expected = n;
+  }
+  return false;
+}
+
+static bool read_ber_length(const uint8_t*& p, const uint8_t* end, uint16_t& out)
+{
+  if (p >= end) return false;
+  uint8_t b = *p++;
+  if (b < 0x80)
+  {
+    out = b;
+    return true;
+  }
+  const uint8_t n = b & 0x7F;
+  if (n == 0 || n > 2 || p + n > end) return false;
+  out = 0;
+  for (uint8_t i = 0; i < n; ++i) out = static_cast<uint16_t>((out << 8) | *p++);
+  return true;
+}
+
+static int8_t numeric_width(uint8_t tag)
+{
+  switch (tag)
+  {
+    case 0x0F: case 0x11: case 0x16: return 1; // int8, uint8, enum
+    case 0x10: case 0x12: return 2;             // int16, uint16
+    case 0x05: case 0x06: return 4;             // int32, uint32
+    case 0x14: case 0x15: return 8;             // int64, uint64
+    default: return 0;
+  }
+}
+
+static int64_t read_numeric(uint8_t tag, const uint8_t* p, int8_t width)
+{
+  uint64_t u = 0;
+  for (int8_t i = 0; i < width; ++i) u = (u << 8) | p[i];
+  const bool is_signed = (tag == 0x0F || tag == 0x10 || tag == 0x05 || tag == 0x14);
+  if (!is_signed || width == 8) return static_cast<int64_t>(u);
+  const uint64_t sign = 1ULL << (width * 8 - 1);
+  return (u & sign) ? static_cast<int64_t>(u) - static_cast<int64_t>(sign << 1) : static_cast<int64_t>(u);
+}
+
+static const DlmsMap* lookup_obis(const uint8_t* o)
+{
+  for (size_t i = 0; i < sizeof(kObisMap) / sizeof(kObisMap[0]); ++i)
+  {
+    const DlmsMap& m = kObisMap[i];
+    if (m.a == o[0] && m.c == o[2] && m.d == o[3] && m.e == o[4]) return &m;
+  }
+  return nullptr;
+}
+
+static float scaled(int64_t raw, int8_t scaler, bool kilo)
+{
+  if (scaler < -4) scaler = -4;
+  if (scaler > 4) scaler = 4;
+  float v = static_cast<float>(raw) * kPow10[scaler + 4];
+  return kilo ? v / 1000.0f : v;
+}
+
+static int64_t scaled_milli(int64_t raw, int8_t scaler, bool kilo)
+{
+  int8_t e = static_cast<int8_t>(scaler + (kilo ? 0 : 3));
+  for (; e > 0; --e) raw *= 10;
+  for (; e < 0; ++e) raw /= 10;
+  return raw;
+}
+
+static const DlmsMap* kaifa_layout(uint16_t count, uint8_t& size)
+{
+  if (count == 1)
+  {
+    size = sizeof(kKaifaList1) / sizeof(kKaifaList1[0]);
+    return kKaifaList1;
+  }
+  if (count == 9 || count == 14)
+  {
+    size = sizeof(kKaifa1Phase) / sizeof(kKaifa1Phase[0]);
+    return kKaifa1Phase;
+  }
+  if (count == 13 || count == 18)
+  {
+    size = sizeof(kKaifa3Phase) / sizeof(kKaifa3Phase[0]);
+    return kKaifa3Phase;
+  }
+  if (count == 12 || count == 17)
+  {
+    size = sizeof(kKaifa3PhaseIT) / sizeof(kKaifa3PhaseIT[0]);
+    return kKaifa3PhaseIT;
+  }
+  size = 0;
+  return nullptr;
+}
+
+uint8_t dlms_decode_frame(const HdlcDecoder& d, DlmsValue* out)
+{
+  if (d.frame_len < 4 || d.info >= d.frame_len - 2) return 0;
+
+  const uint8_t* p = d.buf + d.info;
+  const uint8_t* end = d.buf + d.frame_len - 2;
+
+  if (end - p >= 3 && p[0] == 0xE6 && p[1] == 0xE7 && p[2] == 0x00) p += 3;
+
+  // data-notification: tag, long-invoke-id-and-priority, optional date-time
+  if (end - p < 6 || p[0] != 0x0F) return 0;
+  p += 5;
+  if (*p == 0x09)
+  {
+    if (end - p < 2 || end - p < 2 + p[1]) return 0;
+    p += 2 + p[1];
+  }
+  else if (*p == 0x0C && end - p >= 13) p += 13; // length-prefixed date-time without tag
+  else if (*p == 0x00) ++p;
+
+  uint8_t n = 0;
+  int32_t top_count = -1;
+  const DlmsMap* pending = nullptr;
+  bool pending_set = false;
+  bool seen_obis = false;
+  uint8_t num_index = 0;
+  uint8_t str_index = 0;
+  uint8_t layout_size = 0;
+  const DlmsMap* layout = nullptr;
+
+  while (p < end && n < DLMS_MAX_VALUES)
+  {
+    const uint8_t tag = *p++;
+    uint16_t len = 0;
+
+    if (tag == 0x01 || tag == 0x02)
+    {
+      if (!read_ber_length(p, end, len)) break;
+      if (top_count < 0)
+      {
+        top_count = len;
+        layout = kaifa_layout(len, layout_size);
+      }
+      continue;
+    }
+
+    if (tag == 0x09 || tag == 0x0A)
+    {
+      if (!read_ber_length(p, end, len) || p + len > end) break;
+      const uint8_t* data = p;
+      p += len;
+
+      if (tag == 0x09 && len == 6)
+      {
+        pending = lookup_obis(data);
+        pending_set = true;
+        seen_obis = true;
+        continue;
+      }
+
+      const bool is_header = pending_set ? (pending && pending->field == OBIS_HEADER)
+                                         : (!seen_obis && layout && top_count >= 9 && str_index == 1);
+      if (is_header)
+      {
+        out[n].field = OBIS_HEADER;
+        out[n].text = reinterpret_cast<const char*>(data);
+        out[n].text_len = static_cast<uint8_t>(len > 255 ? 255 : len);
+        ++n;
+      }
+      ++str_index;
+      pending_set = false;
+      continue;
+    }
+
+    const int8_t width = numeric_width(tag);
+    if (width > 0)
+    {
+      if (p + width > end) break;
+      const int64_t raw = read_numeric(tag, p, width);
+      p += width;
+
+      const DlmsMap* m = nullptr;
+      int8_t scaler = 0;
+      if (seen_obis)
+      {
+        if (!pending_set) continue;
+        m = pending;
+        pending_set = false;
+        if (!m) continue;
+        scaler = m->scaler;
+        // Aidon style: value followed by structure{int8 scaler, enum unit}.
+        if (end - p >= 6 && p[0] == 0x02 && p[1] == 0x02 && p[2] == 0x0F && p[4] == 0x16)
+        {
+          scaler = static_cast<int8_t>(p[3]);
+          p += 6;
+        }
+      }
+      else
+      {
+        if (!layout || num_index >= layout_size)
+        {
+          ++num_index;
+          continue;
+        }
+        m = &layout[num_index++];
+        scaler = m->scaler;
+      }
+
+      if (m->field == OBIS_NONE || m->field == OBIS_HEADER) continue;
+      out[n].field = m->field;
+      out[n].value = scaled(raw, scaler, m->kilo);
+      out[n].milli = scaled_milli(raw, scaler, m->kilo);
+      out[n].text = nullptr;
+      out[n].text_len = 0;
+      ++n;
+      continue;
+    }
+
+    if (tag == 0x00) continue;
+    if (tag == 0x03 || tag == 0x0D) p += 1;
+    else if (tag == 0x19) p += 12;
+    else break;
+  }
+
+  return n;
+}
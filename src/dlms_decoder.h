@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "obis_parser.h"
+
+// Streaming HDLC framer + DLMS/COSEM push-list decoder for binary HAN ports
+// (Aidon, Kaifa, Kamstrup). Values come out as the same ObisEvent fields the
+// ASCII parser produces, scaled to the ASCII units (V, A, kW, kWh).
+
+static const uint16_t HDLC_MAX_FRAME = 1024;
+static const uint8_t DLMS_MAX_VALUES = 24;
+
+struct HdlcDecoder {
+  uint16_t len = 0;
+  uint16_t expected = 0;
+  uint16_t info = 0;
+  uint16_t frame_len = 0;
+  bool in_frame = false;
+  uint32_t frames_ok = 0;
+  uint32_t frames_bad = 0;
+  uint8_t buf[HDLC_MAX_FRAME];
+};
+
+struct DlmsValue {
+  ObisEvent field = OBIS_NONE;
+  float value = 0.0f;
+  int64_t milli = 0;          // value * 1000, exact (kWh registers in Wh)
+  const char* text = nullptr; // points into the frame buffer, OBIS_HEADER only
+  uint8_t text_len = 0;
+};
+
+void hdlc_decoder_reset(HdlcDecoder& d);
+
+// Feeds one byte. Returns true when a complete frame with valid HCS and FCS
+// sits in d.buf; it stays valid until the next call.
+bool hdlc_decoder_feed(HdlcDecoder& d, uint8_t b);
+
+// Decodes the push list in the last complete frame. Returns the number of
+// values written to out (at most DLMS_MAX_VALUES).
+uint8_t dlms_decode_frame(const HdlcDecoder& d, DlmsValue* out);
+
+uint16_t hdlc_crc16(const uint8_t* data, size_t len);
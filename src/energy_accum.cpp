@@ -0,0 +1,247 @@
+#include "energy_accum.h"
+
+static const int64_t kMjPerWh = 3600000LL;
+static const int64_t kMaxRegisterStepWh = 1000000LL;  // 1 MWh; beyond that, re-anchor
+
+struct AccumTotals {
+  int64_t import_mj = 0;
+  int64_t export_mj = 0;
+  int64_t phase_mj[3] = {0, 0, 0};
+  int64_t span_ms = 0;
+  int64_t corr_mj[2] = {0, 0};  // register corrections, import and export
+};
+
+struct AccumWindow {
+  uint32_t start = 0;
+  AccumTotals base;
+  float peak_w = 0.0f;   // closed minutes only; the open minute is g_minute_peak
+};
+
+static AccumTotals g_totals;
+static float g_minute_peak = 0.0f;
+static AccumWindow g_windows[ACC_PERIOD_COUNT];
+static AccumResult g_last[ACC_PERIOD_COUNT];
+
+static int64_t g_register_wh[2] = {-1, -1};
+static int64_t g_pending_mj[2] = {0, 0};
+static AccumRegisterStats g_reg_stats;
+
+// Register corrections can cover any stretch of time since the previous
+// reading (a power-off gap, a stale link), so they only count in the windows
+// long enough to hold it; minute, quarter and hour keep integrated power only.
+static bool books_corrections(uint8_t p)
+{
+  return p >= ACC_DAY;
+}
+
+static int64_t whole_w(float w)
+{
+  return static_cast<int64_t>(w + 0.5f);
+}
+
+void accum_sample(float importW, float exportW, float l1W, float l2W, float l3W, uint32_t dtMs)
+{
+  const int64_t dt = dtMs;
+  const int64_t imp = whole_w(importW) * dt;
+  const int64_t exp = whole_w(exportW) * dt;
+  g_totals.import_mj += imp;
+  g_totals.export_mj += exp;
+  g_totals.phase_mj[0] += whole_w(l1W) * dt;
+  g_totals.phase_mj[1] += whole_w(l2W) * dt;
+  g_totals.phase_mj[2] += whole_w(l3W) * dt;
+  g_totals.span_ms += dt;
+  g_pending_mj[0] += imp;
+  g_pending_mj[1] += exp;
+  if (importW > g_minute_peak) g_minute_peak = importW;
+}
+
+// Books one register reading; returns the correction in mJ.
+static int64_t anchor(uint8_t k, int64_t wh, int64_t& total)
+{
+  const int64_t prev = g_register_wh[k];
+  g_register_wh[k] = wh;
+  const int64_t pending = g_pending_mj[k];
+  g_pending_mj[k] = 0;
+
+  if (prev < 0 || wh < prev || wh - prev > kMaxRegisterStepWh)
+  {
+    ++g_reg_stats.anchors;
+    return 0;
+  }
+  const int64_t correction = (wh - prev) * kMjPerWh - pending;
+  total += correction;
+  return correction;
+}
+
+float accum_register(int64_t importWh, int64_t exportWh)
+{
+  int64_t correction = 0;
+  if (importWh >= 0)
+  {
+    correction = anchor(0, importWh, g_totals.corr_mj[0]);
+    ++g_reg_stats.readings;
+    g_reg_stats.last_correction_wh = static_cast<float>(correction) / kMjPerWh;
+    g_reg_stats.correction_wh += g_reg_stats.last_correction_wh;
+  }
+  if (exportWh >= 0) anchor(1, exportWh, g_totals.corr_mj[1]);
+  return static_cast<float>(correction) / kMjPerWh;
+}
+
+AccumRegisterStats accum_register_stats()
+{
+  AccumRegisterStats s = g_reg_stats;
+  s.import_wh = g_register_wh[0];
+  s.export_wh = g_register_wh[1];
+  return s;
+}
+
+AccumAnchor accum_anchor_save()
+{
+  AccumAnchor a;
+  for (int k = 0; k < 2; ++k)
+  {
+    a.register_wh[k] = g_register_wh[k];
+    a.pending_mj[k] = g_pending_mj[k];
+  }
+  return a;
+}
+
+void accum_anchor_restore(const AccumAnchor& a)
+{
+  for (int k = 0; k < 2; ++k)
+  {
+    g_register_wh[k] = a.register_wh[k];
+    g_pending_mj[k] = a.pending_mj[k];
+  }
+}
+
+static float to_kwh(int64_t mj)
+{
+  return static_cast<float>(static_cast<double>(mj) / (kMjPerWh * 1000.0));
+}
+
+static int64_t window_mj(uint8_t p, uint8_t k)
+{
+  const AccumTotals& b = g_windows[p].base;
+  int64_t mj = (k == 0) ? g_totals.import_mj - b.import_mj : g_totals.export_mj - b.export_mj;
+  if (books_corrections(p)) mj += g_totals.corr_mj[k] - b.corr_mj[k];
+  return mj;
+}
+
+static AccumResult result_for(uint8_t p)
+{
+  const AccumWindow& w = g_windows[p];
+  AccumResult r;
+  r.start = w.start;
+  const int64_t span = g_totals.span_ms - w.base.span_ms;
+  const int64_t imp = window_mj(p, 0);
+  r.span_s = static_cast<float>(span) / 1000.0f;
+  r.energy_kwh = to_kwh(imp);
+  r.export_kwh = to_kwh(window_mj(p, 1));
+  if (span > 100)
+  {
+    r.avg_w = static_cast<float>(static_cast<double>(imp) / span);
+    for (int i = 0; i < 3; ++i)
+    {
+      r.phase_avg_w[i] = static_cast<float>(static_cast<double>(g_totals.phase_mj[i] - w.base.phase_mj[i]) / span);
+    }
+  }
+  r.peak_w = (g_minute_peak > w.peak_w) ? g_minute_peak : w.peak_w;
+  return r;
+}
+
+AccumResult accum_current(AccumPeriod p)
+{
+  if (p >= ACC_PERIOD_COUNT) return AccumResult();
+  return result_for(p);
+}
+
+AccumResult accum_close(AccumPeriod p, uint32_t nextStart)
+{
+  if (p >= ACC_PERIOD_COUNT) return AccumResult();
+  AccumWindow& w = g_windows[p];
+  const AccumResult r = result_for(p);
+
+  if (p == ACC_MINUTE)
+  {
+    // The minute peak moves into every longer window that is still open.
+    for (uint8_t i = ACC_MINUTE + 1; i < ACC_PERIOD_COUNT; ++i)
+    {
+      if (r.peak_w > g_windows[i].peak_w) g_windows[i].peak_w = r.peak_w;
+    }
+    g_minute_peak = 0.0f;
+  }
+
+  w.start = nextStart;
+  w.base = g_totals;
+  w.peak_w = 0.0f;
+  g_last[p] = r;
+  return r;
+}
+
+void accum_set_start(AccumPeriod p, uint32_t start)
+{
+  if (p < ACC_PERIOD_COUNT) g_windows[p].start = start;
+}
+
+uint32_t accum_start(AccumPeriod p)
+{
+  return (p < ACC_PERIOD_COUNT) ? g_windows[p].start : 0;
+}
+
+AccumResult accum_last(AccumPeriod p)
+{
+  return (p < ACC_PERIOD_COUNT) ? g_last[p] : AccumResult();
+}
+
+void accum_export(AccumState& out)
+{
+  for (uint8_t i = 0; i < ACC_PERIOD_COUNT; ++i)
+  {
+    const AccumWindow& w = g_windows[i];
+    AccumWindowState& s = out.windows[i];
+    s.start = w.start;
+    s.peak_w = w.peak_w;
+    s.import_mj = window_mj(i, 0);
+    s.export_mj = window_mj(i, 1);
+    for (int k = 0; k < 3; ++k) s.phase_mj[k] = g_totals.phase_mj[k] - w.base.phase_mj[k];
+    s.span_ms = g_totals.span_ms - w.base.span_ms;
+  }
+  out.minute_peak_w = g_minute_peak;
+  for (int k = 0; k < 2; ++k)
+  {
+    out.register_wh[k] = g_register_wh[k];
+    out.pending_mj[k] = g_pending_mj[k];
+  }
+}
+
+void accum_import(const AccumState& in)
+{
+  // Running totals restart at zero; each window's base is set so that it
+  // reads back exactly what was exported. The register anchor carries over,
+  // so the first reading after boot also books what was metered while down.
+  g_totals = AccumTotals();
+  for (uint8_t i = 0; i < ACC_PERIOD_COUNT; ++i)
+  {
+    const AccumWindowState& s = in.windows[i];
+    AccumWindow& w = g_windows[i];
+    w.start = s.start;
+    w.peak_w = s.peak_w;
+    w.base.import_mj = -s.import_mj;
+    w.base.export_mj = -s.export_mj;
+    for (int k = 0; k < 3; ++k) w.base.phase_mj[k] = -s.phase_mj[k];
+    w.base.span_ms = -s.span_ms;
+  }
+  g_minute_peak = in.minute_peak_w;
+  for (int k = 0; k < 2; ++k)
+  {
+    g_register_wh[k] = in.register_wh[k];
+    g_pending_mj[k] = in.pending_mj[k];
+  }
+}
+
+float accum_energy_kwh(AccumPeriod p)
+{
+  if (p >= ACC_PERIOD_COUNT) return 0.0f;
+  return to_kwh(window_mj(p, 0));
+}
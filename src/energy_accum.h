@@ -0,0 +1,102 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Aligned energy accumulators. Samples update one set of running totals;
+// each window only remembers the totals at its start, so closing a window
+// is a subtraction regardless of how many samples it saw. Peaks are kept
+// per minute and folded into the longer windows when a minute closes.
+//
+// Totals are 64-bit integers in mJ (W x ms) and ms, so nothing drifts no
+// matter how long a window stays open. When the meter sends its energy
+// registers (1-0:1.8.0 / 2.8.0), power integration only fills the time
+// between two readings: each new reading books the difference between the
+// register delta and what was integrated into the open day, month and year.
+// Minute, quarter and hour stay on integrated power, so a correction that
+// covers a gap does not show up as one hour's average (capacity peaks).
+
+enum AccumPeriod : uint8_t {
+  ACC_MINUTE = 0,
+  ACC_QUARTER,
+  ACC_HOUR,
+  ACC_DAY,
+  ACC_MONTH,
+  ACC_YEAR,
+  ACC_PERIOD_COUNT,
+};
+
+struct AccumResult {
+  uint32_t start = 0;         // epoch; 0 while the clock was not yet valid
+  float span_s = 0.0f;        // seconds actually integrated
+  float energy_kwh = 0.0f;
+  float export_kwh = 0.0f;
+  float avg_w = 0.0f;
+  float phase_avg_w[3] = {0.0f, 0.0f, 0.0f};
+  float peak_w = 0.0f;
+};
+
+// Open-window contents, for checkpoints.
+struct AccumWindowState {
+  uint32_t start = 0;
+  float peak_w = 0.0f;
+  int64_t import_mj = 0;
+  int64_t export_mj = 0;
+  int64_t phase_mj[3] = {0, 0, 0};
+  int64_t span_ms = 0;
+};
+
+struct AccumState {
+  AccumWindowState windows[ACC_PERIOD_COUNT];
+  float minute_peak_w = 0.0f;
+  int64_t register_wh[2] = {-1, -1};  // import, export; -1 = no anchor
+  int64_t pending_mj[2] = {0, 0};     // integrated since that reading
+};
+
+struct AccumRegisterStats {
+  int64_t import_wh = -1;
+  int64_t export_wh = -1;
+  uint32_t readings = 0;
+  uint32_t anchors = 0;             // first reading, meter swap or implausible jump
+  float last_correction_wh = 0.0f;  // import; register delta minus integration
+  float correction_wh = 0.0f;       // sum since boot
+};
+
+// One integration step; powers in W (clamped at 0 by the caller).
+void accum_sample(float importW, float exportW, float l1W, float l2W, float l3W, uint32_t dtMs);
+
+// New register reading in Wh (-1 when the list did not carry it). Returns the
+// import correction booked into the open day, month and year, in Wh.
+float accum_register(int64_t importWh, int64_t exportWh);
+
+AccumRegisterStats accum_register_stats();
+
+// Register anchor: the last reading and what was integrated since. Saved
+// before readings that are not the live meter's (a capture replay) and put
+// back afterwards, so the next live reading books against the real one.
+struct AccumAnchor {
+  int64_t register_wh[2] = {-1, -1};
+  int64_t pending_mj[2] = {0, 0};
+};
+
+AccumAnchor accum_anchor_save();
+void accum_anchor_restore(const AccumAnchor& a);
+
+// Open window so far.
+AccumResult accum_current(AccumPeriod p);
+
+// Closes the open window, starts the next at nextStart and returns the closed one.
+AccumResult accum_close(AccumPeriod p, uint32_t nextStart);
+
+// Sets the start of an open window without resetting it (clock became valid).
+void accum_set_start(AccumPeriod p, uint32_t start);
+
+uint32_t accum_start(AccumPeriod p);
+
+// Last closed window (zeros until the first close).
+AccumResult accum_last(AccumPeriod p);
+
+// Energy of the open window only; cheaper than accum_current().
+float accum_energy_kwh(AccumPeriod p);
+
+void accum_export(AccumState& out);
+void accum_import(const AccumState& in);
@@ -0,0 +1,140 @@
+#include "energy_checkpoint.h"
+
+#include <Preferences.h>
+
+static const uint32_t kMagic = 0x4B435048;  // "HPCK"
+static const uint16_t kVersion = 5;
+
+// Up to 4 saves in a burst, refilled one per 10 minutes: at most ~6/h
+// sustained, a few KB of NVS per hour.
+static const uint8_t BUDGET_MAX = 4;
+static const uint32_t BUDGET_REFILL_MS = 10UL * 60UL * 1000UL;
+
+struct Slot {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  EnergyCheckpoint ck;
+  uint32_t crc;
+};
+
+static Preferences prefs;
+static CheckpointCollectFn g_collect = nullptr;
+static uint32_t g_seq = 0;
+static uint8_t g_budget = BUDGET_MAX;
+static uint32_t g_refill_ms = 0;
+static CheckpointStats g_stats;
+
+static const char* slot_key(uint32_t seq)
+{
+  return (seq & 1) ? "ck1" : "ck0";
+}
+
+static uint32_t crc32(const uint8_t* data, size_t len)
+{
+  uint32_t crc = 0xFFFFFFFFUL;
+  for (size_t i = 0; i < len; ++i)
+  {
+    crc ^= data[i];
+    for (int b = 0; b < 8; ++b) crc = (crc >> 1) ^ (0xEDB88320UL & (0U - (crc & 1U)));
+  }
+  return ~crc;
+}
+
+static bool read_slot(const char* key, Slot& s)
+{
+  if (prefs.getBytesLength(key) != sizeof(Slot)) return false;
+  if (prefs.getBytes(key, &s, sizeof(Slot)) != sizeof(Slot)) return false;
+  if (s.magic != kMagic || s.version != kVersion || s.size != sizeof(EnergyCheckpoint)) return false;
+  return crc32(reinterpret_cast<const uint8_t*>(&s), offsetof(Slot, crc)) == s.crc;
+}
+
+bool energy_checkpoint_begin(CheckpointCollectFn collect, EnergyCheckpoint& out)
+{
+  g_collect = collect;
+  g_refill_ms = millis();
+  prefs.begin("hanckpt", false);
+
+  Slot a;
+  Slot b;
+  const bool okA = read_slot("ck0", a);
+  const bool okB = read_slot("ck1", b);
+  if (!okA && !okB) return false;
+
+  const Slot& best = (okA && (!okB || a.ck.seq > b.ck.seq)) ? a : b;
+  out = best.ck;
+  g_seq = best.ck.seq;
+  g_stats.restored = true;
+  g_stats.restored_seq = g_seq;
+  return true;
+}
+
+bool energy_checkpoint_save(bool force)
+{
+  if (!g_collect) return false;
+
+  const uint32_t now = millis();
+  while (g_budget < BUDGET_MAX && now - g_refill_ms >= BUDGET_REFILL_MS)
+  {
+    ++g_budget;
+    g_refill_ms += BUDGET_REFILL_MS;
+  }
+  if (g_budget >= BUDGET_MAX) g_refill_ms = now;
+
+  if (!force)
+  {
+    if (g_budget == 0)
+    {
+      ++g_stats.skipped;
+      return false;
+    }
+    --g_budget;
+  }
+
+  Slot s{};
+  s.magic = kMagic;
+  s.version = kVersion;
+  s.size = sizeof(EnergyCheckpoint);
+  g_collect(s.ck);
+  s.ck.seq = g_seq + 1;
+  s.crc = crc32(reinterpret_cast<const uint8_t*>(&s), offsetof(Slot, crc));
+
+  // The other slot keeps the previous checkpoint until this one is complete.
+  if (prefs.putBytes(slot_key(s.ck.seq), &s, sizeof(s)) != sizeof(s)) return false;
+
+  g_seq = s.ck.seq;
+  ++g_stats.writes;
+  if (force) ++g_stats.forced;
+  g_stats.bytes += sizeof(s);
+  g_stats.last_ms = now;
+  return true;
+}
+
+void energy_checkpoint_note_reconciled(float kwh)
+{
+  g_stats.reconciled_kwh += kwh;
+}
+
+CheckpointStats energy_checkpoint_stats()
+{
+  return g_stats;
+}
+
+String energy_checkpoint_json()
+{
+  const float hours = millis() / 3600000.0f;
+  const float perHour = (hours > 0.01f) ? g_stats.writes / hours : 0.0f;
+  String out = "{";
+  out += "\"restored\":" + String(g_stats.restored ? "true" : "false") + ",";
+  out += "\"seq\":" + String(g_seq) + ",";
+  out += "\"writes\":" + String(g_stats.writes) + ",";
+  out += "\"forced\":" + String(g_stats.forced) + ",";
+  out += "\"skipped\":" + String(g_stats.skipped) + ",";
+  out += "\"bytes\":" + String(g_stats.bytes) + ",";
+  out += "\"writes_per_hour\":" + String(perHour, 2) + ",";
+  out += "\"bytes_per_hour\":" + String((hours > 0.01f) ? g_stats.bytes / hours : 0.0f, 0) + ",";
+  out += "\"budget\":" + String(g_budget) + ",";
+  out += "\"reconciled_kwh\":" + String(g_stats.reconciled_kwh, 3);
+  out += "}";
+  return out;
+}
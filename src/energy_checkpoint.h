@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Arduino.h>
+#include "energy_accum.h"
+#include "capacity_peaks.h"
+#include "cost_ledger.h"
+
+// Crash-safe copy of the energy state in NVS. Two slots are written
+// alternately; each carries a sequence number and CRC32, so a torn write
+// only loses the newest checkpoint. Routine saves draw from a token
+// bucket to cap flash wear; forced saves (reboot, OTA) always go through.
+
+struct EnergyCheckpoint {
+  uint32_t seq = 0;
+  uint32_t saved_epoch = 0;          // 0 if the clock was not valid
+  AccumState accum;
+  CapacityPeaks capacity;
+  CostLedgerState cost;
+};
+
+struct CheckpointStats {
+  bool restored = false;
+  uint32_t restored_seq = 0;
+  uint32_t writes = 0;
+  uint32_t forced = 0;
+  uint32_t skipped = 0;              // routine saves refused by the budget
+  uint32_t bytes = 0;
+  uint32_t last_ms = 0;
+  float reconciled_kwh = 0.0f;       // gap energy credited from the register
+};
+
+typedef void (*CheckpointCollectFn)(EnergyCheckpoint& ck);
+
+// Loads the newest valid slot into out. Returns false when none is valid.
+bool energy_checkpoint_begin(CheckpointCollectFn collect, EnergyCheckpoint& out);
+
+// Saves when the budget allows (or always, if forced). Returns true if written.
+bool energy_checkpoint_save(bool force);
+
+void energy_checkpoint_note_reconciled(float kwh);
+
+CheckpointStats energy_checkpoint_stats();
+String energy_checkpoint_json();
@@ -0,0 +1,185 @@
+#include "han_autodetect.h"
+#include "han_reader.h"
+
+struct HanCandidate {
+  uint32_t baud;
+  const char* serial;
+  bool invert;
+};
+
+// Most common Norwegian meters first: Aidon/Kaifa, Kamstrup, then DSMR P1.
+static const HanCandidate kCandidates[] = {
+  {2400, "8E1", false},
+  {2400, "8N1", false},
+  {115200, "8N1", false},
+  {9600, "8N1", false},
+  {2400, "8E1", true},
+  {2400, "8N1", true},
+  {115200, "8N1", true},
+  {9600, "8N1", true},
+};
+static const uint8_t kCandidateCount = sizeof(kCandidates) / sizeof(kCandidates[0]);
+
+static const uint32_t WINDOW_MS = 3000UL;
+static const uint32_t WINDOW_EXTENDED_MS = 11000UL;
+static const uint32_t FIRST_ATTEMPT_MS = 15000UL;
+static const uint32_t RETRY_MS = 600000UL;
+
+static HanDetector detector;
+static volatile bool g_active = false;
+static volatile bool g_reset_pending = false;
+static bool g_start_requested = false;
+static uint8_t g_candidate = 0;
+static uint32_t g_window_start = 0;
+static uint32_t g_last_attempt = 0;
+static bool g_attempted = false;
+static uint32_t g_line_errors_base = 0;
+
+static int32_t g_best_points = 0;
+static HanDetectScore g_found_score;
+static int8_t g_best = -1;
+static HanAutodetectStatus g_status;
+
+static void apply_candidate(DeviceConfig& cfg, const HanCandidate& c)
+{
+  cfg.han_baud = c.baud;
+  cfg.han_serial = c.serial;
+  cfg.han_invert = c.invert;
+}
+
+static bool start_candidate(const DeviceConfig& cfg, uint8_t idx)
+{
+  DeviceConfig probe = cfg;
+  apply_candidate(probe, kCandidates[idx]);
+  probe.han_protocol = "AUTO";
+
+  g_active = false;
+  if (!han_reader_begin(probe))
+  {
+    // The ingest task did not take the reset; a score from this window would
+    // mix candidates. Give up on the run and put the saved setting back.
+    g_status.running = false;
+    g_last_attempt = millis();
+    strlcpy(g_status.result, "RESET TIMEOUT", sizeof(g_status.result));
+    han_reader_begin(cfg);
+    return false;
+  }
+  // The ingest task owns the detector; it resets it before the next feed.
+  g_reset_pending = true;
+  g_line_errors_base = han_uart_source().line_errors();
+  g_window_start = millis();
+  g_candidate = idx;
+  g_status.candidate = idx;
+  g_active = true;
+  return true;
+}
+
+static void finish(DeviceConfig& cfg, bool found)
+{
+  g_active = false;
+  g_status.running = false;
+  g_status.found = found;
+  g_last_attempt = millis();
+
+  if (found)
+  {
+    const HanCandidate& c = kCandidates[g_best];
+    apply_candidate(cfg, c);
+    cfg.han_protocol = han_detector_protocol(g_found_score);
+    snprintf(g_status.result, sizeof(g_status.result), "%lu %s%s %s",
+             static_cast<unsigned long>(c.baud), c.serial, c.invert ? " inv" : "", cfg.han_protocol.c_str());
+    config_save(cfg);
+  }
+  else if (g_best >= 0)
+  {
+    const HanCandidate& c = kCandidates[g_best];
+    snprintf(g_status.result, sizeof(g_status.result), "NO MATCH (best %lu %s%s)",
+             static_cast<unsigned long>(c.baud), c.serial, c.invert ? " inv" : "");
+  }
+  else
+  {
+    strlcpy(g_status.result, "NO MATCH", sizeof(g_status.result));
+  }
+  han_reader_begin(cfg);
+}
+
+void han_autodetect_start()
+{
+  g_start_requested = true;
+}
+
+bool han_autodetect_tick(DeviceConfig& cfg, bool haveTelegrams)
+{
+  const uint32_t now = millis();
+
+  if (!g_status.running)
+  {
+    const bool due = cfg.han_autodetect && !haveTelegrams &&
+                     (g_attempted ? (now - g_last_attempt > RETRY_MS) : (now > FIRST_ATTEMPT_MS));
+    if (!g_start_requested && !(cfg.han_enabled && due)) return false;
+
+    g_start_requested = false;
+    g_attempted = true;
+    g_best = -1;
+    g_best_points = 0;
+    g_status.running = true;
+    g_status.found = false;
+    g_status.candidates = kCandidateCount;
+    g_status.result[0] = '\0';
+    start_candidate(cfg, 0);
+    return false;
+  }
+
+  HanDetectScore s = g_reset_pending ? HanDetectScore() : detector.score;
+  s.line_errors = static_cast<uint16_t>(han_uart_source().line_errors() - g_line_errors_base);
+  const int32_t points = han_detector_points(s);
+
+  if (han_detector_confident(s))
+  {
+    g_best = static_cast<int8_t>(g_candidate);
+    g_found_score = s;
+    finish(cfg, true);
+    return true;
+  }
+
+  // Some structure but no complete frame yet: give slow pushers (Kamstrup
+  // every 10 s) time before moving on.
+  const uint32_t window = (points > 0) ? WINDOW_EXTENDED_MS : WINDOW_MS;
+  if (now - g_window_start < window) return false;
+
+  if (points > g_best_points)
+  {
+    g_best_points = points;
+    g_best = static_cast<int8_t>(g_candidate);
+  }
+
+  if (g_candidate + 1 < kCandidateCount)
+  {
+    start_candidate(cfg, static_cast<uint8_t>(g_candidate + 1));
+    return false;
+  }
+
+  finish(cfg, false);
+  return false;
+}
+
+HanAutodetectStatus han_autodetect_status()
+{
+  return g_status;
+}
+
+bool han_autodetect_active()
+{
+  return g_active;
+}
+
+void han_autodetect_ingest(const uint8_t* data, size_t len)
+{
+  if (!g_active) return;
+  if (g_reset_pending)
+  {
+    han_detector_reset(detector);
+    g_reset_pending = false;
+  }
+  han_detector_feed(detector, data, len);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config_store.h"
+#include "han_detect.h"
+
+struct HanAutodetectStatus {
+  bool running = false;
+  bool found = false;
+  uint8_t candidate = 0;
+  uint8_t candidates = 0;
+  char result[40] = "";
+};
+
+// Cycles candidate UART settings, stops at the first confident match and
+// saves it to cfg. Runs by itself when cfg.han_autodetect is set and no
+// telegram has arrived yet; han_autodetect_start() forces a run.
+void han_autodetect_start();
+bool han_autodetect_tick(DeviceConfig& cfg, bool haveTelegrams);
+HanAutodetectStatus han_autodetect_status();
+
+// Ingest task hook.
+bool han_autodetect_active();
+void han_autodetect_ingest(const uint8_t* data, size_t len);
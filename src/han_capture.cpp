@@ -0,0 +1,191 @@
+#include "han_capture.h"
+
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static File g_file;
+static volatile bool g_want = false;
+static volatile bool g_active = false;
+static uint32_t g_last_ms = 0;
+static volatile uint32_t g_bytes = 0;
+static volatile uint32_t g_records = 0;
+
+static uint8_t g_buf[1024];
+static size_t g_buf_len = 0;
+
+static HanReplaySource replaySource;
+
+HanReplaySource& han_replay_source()
+{
+  return replaySource;
+}
+
+static bool read_varint(File& f, uint32_t& out)
+{
+  out = 0;
+  for (int shift = 0; shift < 35; shift += 7)
+  {
+    const int b = f.read();
+    if (b < 0) return false;
+    out |= static_cast<uint32_t>(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+static void flush_buffer()
+{
+  if (g_buf_len == 0 || !g_file) return;
+  g_file.write(g_buf, g_buf_len);
+  g_buf_len = 0;
+}
+
+void han_capture_request(bool on)
+{
+  g_want = on;
+}
+
+HanCaptureStatus han_capture_status()
+{
+  HanCaptureStatus s;
+  s.active = g_active;
+  s.replaying = replaySource.running();
+  s.file_bytes = g_bytes;
+  s.records = g_records;
+  s.replay_speed = replaySource.speed();
+  return s;
+}
+
+void han_capture_service()
+{
+  if (g_want == g_active) return;
+
+  if (g_want)
+  {
+    g_file = LittleFS.open(HAN_CAPTURE_PATH, FILE_WRITE);
+    if (!g_file)
+    {
+      g_want = false;
+      return;
+    }
+    g_file.write(HAN_CAPTURE_MAGIC, sizeof(HAN_CAPTURE_MAGIC));
+    g_bytes = sizeof(HAN_CAPTURE_MAGIC);
+    g_records = 0;
+    g_buf_len = 0;
+    g_last_ms = millis();
+    g_active = true;
+    return;
+  }
+
+  flush_buffer();
+  g_file.close();
+  g_active = false;
+}
+
+void han_capture_append(const uint8_t* data, size_t len)
+{
+  if (!g_active || len == 0) return;
+
+  if (g_bytes + len + HAN_CAPTURE_HEAD_MAX > HAN_CAPTURE_MAX_BYTES)
+  {
+    g_want = false;
+    han_capture_service();
+    return;
+  }
+
+  const uint32_t now = millis();
+  uint8_t head[HAN_CAPTURE_HEAD_MAX];
+  const size_t h = han_capture_put_head(head, now - g_last_ms, static_cast<uint32_t>(len));
+  g_last_ms = now;
+
+  if (g_buf_len + h + len > sizeof(g_buf)) flush_buffer();
+  if (h + len > sizeof(g_buf))
+  {
+    g_file.write(head, h);
+    g_file.write(data, len);
+  }
+  else
+  {
+    memcpy(g_buf + g_buf_len, head, h);
+    memcpy(g_buf + g_buf_len + h, data, len);
+    g_buf_len += h + len;
+  }
+  g_bytes += h + len;
+  ++g_records;
+}
+
+void HanReplaySource::begin(const DeviceConfig&)
+{
+  end();
+  stop_ = false;
+  done_ = false;
+  TaskHandle_t handle = nullptr;
+  xTaskCreatePinnedToCore(task_entry, "han_replay", 4096, this, 4, &handle, 0);
+  task_ = handle;
+}
+
+void HanReplaySource::end()
+{
+  if (!task_) return;
+  stop_ = true;
+  while (task_) vTaskDelay(pdMS_TO_TICKS(5));
+}
+
+void HanReplaySource::task_entry(void* arg)
+{
+  HanReplaySource* self = static_cast<HanReplaySource*>(arg);
+  self->run();
+  // Stopped from outside means a new source is already on its way in.
+  if (!self->stop_) self->done_ = true;
+  self->task_ = nullptr;
+  vTaskDelete(nullptr);
+}
+
+void HanReplaySource::run()
+{
+  File f = LittleFS.open(HAN_CAPTURE_PATH, FILE_READ);
+  if (!f) return;
+
+  uint8_t magic[sizeof(HAN_CAPTURE_MAGIC)];
+  if (f.read(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, HAN_CAPTURE_MAGIC, sizeof(magic)) != 0)
+  {
+    f.close();
+    return;
+  }
+
+  uint8_t chunk[256];
+  uint32_t dt = 0;
+  uint32_t len = 0;
+  while (!stop_ && read_varint(f, dt) && read_varint(f, len))
+  {
+    uint32_t waitMs = (speed_ > 0) ? dt / speed_ : 0;
+    while (waitMs > 0 && !stop_)
+    {
+      const uint32_t step = (waitMs > 50) ? 50 : waitMs;
+      vTaskDelay(pdMS_TO_TICKS(step));
+      waitMs -= step;
+    }
+
+    while (len > 0 && !stop_)
+    {
+      const size_t want = (len < sizeof(chunk)) ? len : sizeof(chunk);
+      const size_t got = f.read(chunk, want);
+      if (got == 0)
+      {
+        len = 0;
+        break;
+      }
+      len -= got;
+
+      // Back-pressure instead of drops: wait for the parser to catch up.
+      size_t off = 0;
+      while (off < got && !stop_)
+      {
+        off += han_ingest_offer(chunk + off, got - off);
+        if (off < got) vTaskDelay(1);
+      }
+    }
+  }
+  f.close();
+}
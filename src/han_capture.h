@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+#include "han_source.h"
+#include "han_capture_format.h"
+
+// Raw HAN capture in LittleFS, append-only, in the HANC format.
+
+static const char* const HAN_CAPTURE_PATH = "/han_capture.bin";
+static const uint32_t HAN_CAPTURE_MAX_BYTES = 512UL * 1024UL;
+
+struct HanCaptureStatus {
+  bool active = false;
+  bool replaying = false;
+  uint32_t file_bytes = 0;
+  uint32_t records = 0;
+  uint16_t replay_speed = 1;
+};
+
+// Requests are picked up by the ingest task, which owns the file while capturing.
+void han_capture_request(bool on);
+HanCaptureStatus han_capture_status();
+
+// Ingest task hooks.
+void han_capture_service();
+void han_capture_append(const uint8_t* data, size_t len);
+
+// Replays HAN_CAPTURE_PATH into the ingest ring at speed x real time
+// (0 = as fast as the parser keeps up). Reports finished() once the file
+// has run out, so the reader can go back to the UART.
+class HanReplaySource : public HanByteSource {
+ public:
+  void begin(const DeviceConfig& cfg) override;
+  void end() override;
+  const char* name() const override { return "replay"; }
+
+  void set_speed(uint16_t speed) { speed_ = speed; }
+  uint16_t speed() const { return speed_; }
+  bool running() const { return task_ != nullptr; }
+  bool finished() const override { return done_; }
+
+ private:
+  static void task_entry(void* arg);
+  void run();
+
+  uint16_t speed_ = 1;
+  volatile bool stop_ = false;
+  volatile bool done_ = false;
+  TaskHandle_t volatile task_ = nullptr;
+};
+
+HanReplaySource& han_replay_source();
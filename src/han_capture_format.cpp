@@ -0,0 +1,59 @@
+#include "han_capture_format.h"
+
+size_t han_capture_put_varint(uint8_t* out, uint32_t v)
+{
+  size_t n = 0;
+  while (v >= 0x80)
+  {
+    out[n++] = static_cast<uint8_t>(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(v);
+  return n;
+}
+
+size_t han_capture_put_head(uint8_t* out, uint32_t dtMs, uint32_t len)
+{
+  const size_t n = han_capture_put_varint(out, dtMs);
+  return n + han_capture_put_varint(out + n, len);
+}
+
+static bool get_varint(HanCaptureReader& r, uint32_t& out)
+{
+  out = 0;
+  for (int shift = 0; shift < 35; shift += 7)
+  {
+    if (r.pos >= r.len) return false;
+    const uint8_t b = r.buf[r.pos++];
+    out |= static_cast<uint32_t>(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+bool han_capture_reader_open(HanCaptureReader& r, const uint8_t* buf, size_t len)
+{
+  r.buf = buf;
+  r.len = len;
+  r.pos = 0;
+  if (len < sizeof(HAN_CAPTURE_MAGIC) || memcmp(buf, HAN_CAPTURE_MAGIC, sizeof(HAN_CAPTURE_MAGIC)) != 0) return false;
+  r.pos = sizeof(HAN_CAPTURE_MAGIC);
+  return true;
+}
+
+bool han_capture_reader_next(HanCaptureReader& r, HanCaptureRecord& rec)
+{
+  const size_t start = r.pos;
+  uint32_t dt = 0;
+  uint32_t len = 0;
+  if (!get_varint(r, dt) || !get_varint(r, len) || len > r.len - r.pos)
+  {
+    r.pos = start;
+    return false;
+  }
+  rec.dt_ms = dt;
+  rec.len = len;
+  rec.data = r.buf + r.pos;
+  r.pos += len;
+  return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+// HANC capture format: "HANC" + version byte, then records of
+// varint(ms since previous record), varint(length), raw bytes. The device
+// writes and streams it from LittleFS; the reader below walks a capture held
+// in memory (host tests, tools).
+
+static const uint8_t HAN_CAPTURE_MAGIC[5] = {'H', 'A', 'N', 'C', 1};
+static const size_t HAN_CAPTURE_HEAD_MAX = 10;  // two 32-bit varints
+
+size_t han_capture_put_varint(uint8_t* out, uint32_t v);
+
+// Record head (delay and length) into out; at most HAN_CAPTURE_HEAD_MAX bytes.
+size_t han_capture_put_head(uint8_t* out, uint32_t dtMs, uint32_t len);
+
+struct HanCaptureRecord {
+  uint32_t dt_ms = 0;
+  const uint8_t* data = nullptr;
+  uint32_t len = 0;
+};
+
+struct HanCaptureReader {
+  const uint8_t* buf = nullptr;
+  size_t len = 0;
+  size_t pos = 0;
+};
+
+// False when the buffer does not start with the magic and version.
+bool han_capture_reader_open(HanCaptureReader& r, const uint8_t* buf, size_t len);
+
+// Next complete record; false at the end or at a truncated last record
+// (a capture cut off by a reboot).
+bool han_capture_reader_next(HanCaptureReader& r, HanCaptureRecord& rec);
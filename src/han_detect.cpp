@@ -0,0 +1,84 @@
+#include "han_detect.h"
+
+void han_detector_reset(HanDetector& d)
+{
+  obis_parser_reset(d.obis);
+  hdlc_decoder_reset(d.hdlc);
+  d.score = HanDetectScore();
+  d.prev = 0;
+  d.fields = 0;
+  d.plain_fields = 0;
+}
+
+static void end_telegram(HanDetector& d)
+{
+  if (!obis_parser_telegram_ok(d.obis))
+  {
+    ++d.score.bad_frames;
+    return;
+  }
+  ++d.score.dsmr_telegrams;
+  if (d.obis.crc_digits == 4)
+  {
+    ++d.score.dsmr_crc_ok;
+    return;
+  }
+  // Without a CRC a garbled stream can still look like a telegram; a second
+  // one with the same fields is what a real meter sends.
+  if (d.fields != 0 && d.fields == d.plain_fields) ++d.score.dsmr_plain_repeats;
+  d.plain_fields = d.fields;
+}
+
+void han_detector_feed(HanDetector& d, const uint8_t* data, size_t len)
+{
+  DlmsValue values[DLMS_MAX_VALUES];
+  for (size_t i = 0; i < len; ++i)
+  {
+    const uint8_t b = data[i];
+
+    const uint32_t badBefore = d.hdlc.frames_bad;
+    if (hdlc_decoder_feed(d.hdlc, b) && dlms_decode_frame(d.hdlc, values) > 0) ++d.score.hdlc_frames;
+    if (d.hdlc.frames_bad != badBefore) ++d.score.bad_frames;
+    if (d.prev == 0x7E && (b & 0xF8) == 0xA0) ++d.score.hdlc_starts;
+    d.prev = b;
+
+    const ObisEvent ev = obis_parser_feed(d.obis, static_cast<char>(b));
+    if (ev == OBIS_HEADER)
+    {
+      d.fields = 0;
+    }
+    else if (ev == OBIS_END)
+    {
+      end_telegram(d);
+    }
+    else if (ev >= OBIS_VOLTAGE_L1)
+    {
+      ++d.score.dsmr_values;
+      d.fields |= static_cast<uint16_t>(1u << ev);
+    }
+  }
+  d.score.bytes += static_cast<uint32_t>(len);
+}
+
+int32_t han_detector_points(const HanDetectScore& s)
+{
+  int32_t p = 0;
+  p += 100 * static_cast<int32_t>(s.hdlc_frames + s.dsmr_telegrams);
+  p += 10 * static_cast<int32_t>(s.dsmr_values);
+  p += 5 * static_cast<int32_t>(s.hdlc_starts);
+  p -= 2 * static_cast<int32_t>(s.bad_frames);
+  p -= static_cast<int32_t>(s.line_errors);
+  return p;
+}
+
+bool han_detector_confident(const HanDetectScore& s)
+{
+  return s.hdlc_frames > 0 || s.dsmr_crc_ok > 0 || s.dsmr_plain_repeats > 0;
+}
+
+const char* han_detector_protocol(const HanDetectScore& s)
+{
+  if (s.hdlc_frames > 0 && s.hdlc_frames >= s.dsmr_telegrams) return "HDLC";
+  if (s.dsmr_telegrams > 0) return "DSMR";
+  return "AUTO";
+}
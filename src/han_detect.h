@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "obis_parser.h"
+#include "dlms_decoder.h"
+
+// Scoring of raw HAN bytes captured under one baud/parity/invert setting.
+// Pure byte logic, so recorded streams can be scored off-device too.
+
+struct HanDetectScore {
+  uint32_t bytes = 0;
+  uint16_t hdlc_frames = 0;      // valid HCS/FCS and a decodable push list
+  uint16_t hdlc_starts = 0;      // flag followed by a type-3 frame format byte
+  uint16_t dsmr_telegrams = 0;   // complete telegram with valid (or no) CRC
+  uint16_t dsmr_crc_ok = 0;      // of those, with a CRC that matched
+  uint16_t dsmr_plain_repeats = 0;  // CRC-less telegram with the same known fields as the one before
+  uint16_t dsmr_values = 0;      // OBIS lines that parsed to a known field
+  uint16_t bad_frames = 0;
+  uint16_t line_errors = 0;      // UART framing/parity errors, filled by the driver
+};
+
+struct HanDetector {
+  ObisParser obis;
+  HdlcDecoder hdlc;
+  HanDetectScore score;
+  uint8_t prev = 0;
+  uint16_t fields = 0;        // known OBIS fields in the open telegram, bit per ObisEvent
+  uint16_t plain_fields = 0;  // same for the last CRC-less telegram
+};
+
+void han_detector_reset(HanDetector& d);
+void han_detector_feed(HanDetector& d, const uint8_t* data, size_t len);
+int32_t han_detector_points(const HanDetectScore& s);
+
+// Enough to save a setting: one CRC-checked HDLC frame or DSMR telegram, or
+// two CRC-less DSMR telegrams in a row carrying the same known fields.
+bool han_detector_confident(const HanDetectScore& s);
+const char* han_detector_protocol(const HanDetectScore& s);
@@ -1,90 +1,307 @@
 #include "han_reader.h"
+#include "obis_parser.h"
+#include "dlms_decoder.h"
+#include "spsc_ring.h"
+#include "han_capture.h"
+#include "han_autodetect.h"
+#include "perf_stats.h"
 
-static HardwareSerial HanSerial(1);
-static String lineBuf;
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#ifndef HANREADER_INGEST_CORE
+#define HANREADER_INGEST_CORE 0
+#endif
+
+static SpscRing<4096> ring;
+static TaskHandle_t g_task = nullptr;
+static HanByteSource* g_source = nullptr;
+
+static ObisParser parser;
+static HdlcDecoder hdlc;
+static bool g_use_dsmr = true;
+static bool g_use_hdlc = true;
+static volatile bool g_reset_parsers = false;
+static SemaphoreHandle_t g_reset_done = nullptr;
+
+static const uint32_t RESET_ACK_TIMEOUT_MS = 500UL;
+
+static HanReading g_readings[2];
+static uint8_t g_front = 0;
+static uint32_t g_seq = 0;
+static uint32_t g_source_seq = 0;  // last reading published by the previous source
+static bool g_dsmr_open = false;
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void (*g_on_publish)() = nullptr;
+
+static HanIngestStats g_stats;
 static const char* g_last_error = "NO DATA";
 
-static float parse_obis_value(const String& line)
+static HanReading& scratch()
 {
-  const int open = line.indexOf('(');
-  const int close = line.indexOf('*', open + 1);
-  if (open < 0) return NAN;
-  const int end = (close > open) ? close : line.indexOf(')', open + 1);
-  if (end <= open) return NAN;
+  return g_readings[g_front ^ 1];
+}
 
-  String num = line.substring(open + 1, end);
-  num.trim();
-  num.replace(',', '.');
-  return num.toFloat();
+static void begin_scratch()
+{
+  // Lists that carry only a subset (e.g. list 1) keep the other fields.
+  // The exact registers do not carry over: a reading means a fresh value.
+  scratch() = g_readings[g_front];
+  scratch().import_wh_total = -1;
+  scratch().export_wh_total = -1;
 }
 
-static void parse_line(HanSnapshot& s, const String& line)
+static void publish()
 {
-  if (line.startsWith("/"))
+  portENTER_CRITICAL(&g_mux);
+  g_front ^= 1;
+  ++g_seq;
+  portEXIT_CRITICAL(&g_mux);
+  ++g_stats.frames_ok;
+  g_last_error = "OK";
+  if (g_on_publish) g_on_publish();
+}
+
+static void reject(const char* why)
+{
+  ++g_stats.frames_dropped;
+  g_last_error = why;
+}
+
+static void apply_value(HanReading& r, ObisEvent ev, float v, int64_t milli)
+{
+  switch (ev)
   {
-    s.meter_id = line;
-    return;
+    case OBIS_VOLTAGE_L1: r.voltage_v[0] = v; break;
+    case OBIS_VOLTAGE_L2: r.voltage_v[1] = v; break;
+    case OBIS_VOLTAGE_L3: r.voltage_v[2] = v; break;
+    case OBIS_CURRENT_L1: r.current_a[0] = v; break;
+    case OBIS_CURRENT_L2: r.current_a[1] = v; break;
+    case OBIS_CURRENT_L3: r.current_a[2] = v; break;
+    case OBIS_POWER_L1_KW: r.phase_power_w[0] = v * 1000.0f; break;
+    case OBIS_POWER_L2_KW: r.phase_power_w[1] = v * 1000.0f; break;
+    case OBIS_POWER_L3_KW: r.phase_power_w[2] = v * 1000.0f; break;
+    case OBIS_IMPORT_POWER_KW: r.import_power_w = v * 1000.0f; break;
+    case OBIS_EXPORT_POWER_KW: r.export_power_w = v * 1000.0f; break;
+    case OBIS_IMPORT_ENERGY_KWH:
+      r.import_energy_kwh_total = v;
+      r.import_wh_total = milli;
+      break;
+    case OBIS_EXPORT_ENERGY_KWH:
+      r.export_energy_kwh_total = v;
+      r.export_wh_total = milli;
+      break;
+    default: break;
   }
+}
 
-  if (line.startsWith("1-0:32.7.0")) s.voltage_v[0] = parse_obis_value(line);
-  else if (line.startsWith("1-0:52.7.0")) s.voltage_v[1] = parse_obis_value(line);
-  else if (line.startsWith("1-0:72.7.0")) s.voltage_v[2] = parse_obis_value(line);
-  else if (line.startsWith("1-0:31.7.0")) s.current_a[0] = parse_obis_value(line);
-  else if (line.startsWith("1-0:51.7.0")) s.current_a[1] = parse_obis_value(line);
-  else if (line.startsWith("1-0:71.7.0")) s.current_a[2] = parse_obis_value(line);
-  else if (line.startsWith("1-0:21.7.0")) s.phase_power_w[0] = parse_obis_value(line) * 1000.0f;
-  else if (line.startsWith("1-0:41.7.0")) s.phase_power_w[1] = parse_obis_value(line) * 1000.0f;
-  else if (line.startsWith("1-0:61.7.0")) s.phase_power_w[2] = parse_obis_value(line) * 1000.0f;
-  else if (line.startsWith("1-0:1.7.0")) s.import_power_w = parse_obis_value(line) * 1000.0f;
-  else if (line.startsWith("1-0:2.7.0")) s.export_power_w = parse_obis_value(line) * 1000.0f;
-  else if (line.startsWith("1-0:1.8.0")) s.import_energy_kwh_total = parse_obis_value(line);
-  else if (line.startsWith("1-0:2.8.0")) s.export_energy_kwh_total = parse_obis_value(line);
+static void apply_meter_id(HanReading& r, const char* text, uint8_t len)
+{
+  if (len >= sizeof(r.meter_id)) len = sizeof(r.meter_id) - 1;
+  memcpy(r.meter_id, text, len);
+  r.meter_id[len] = '\0';
 }
 
-void han_reader_begin(const DeviceConfig& cfg)
+static void feed_hdlc(uint8_t b)
 {
-  lineBuf.reserve(160);
-  HanSerial.begin(cfg.han_baud, SERIAL_8N1, cfg.han_rx_pin, cfg.han_tx_pin, cfg.han_invert);
+  const uint32_t badBefore = hdlc.frames_bad;
+  const bool complete = hdlc_decoder_feed(hdlc, b);
+  if (hdlc.frames_bad != badBefore) reject("HDLC FCS ERROR");
+  if (!complete) return;
+
+  DlmsValue values[DLMS_MAX_VALUES];
+  const uint8_t count = dlms_decode_frame(hdlc, values);
+  if (count == 0) return reject("DLMS LIST UNKNOWN");
+
+  begin_scratch();
+  HanReading& r = scratch();
+  for (uint8_t k = 0; k < count; ++k)
+  {
+    if (values[k].field == OBIS_HEADER) apply_meter_id(r, values[k].text, values[k].text_len);
+    else apply_value(r, values[k].field, values[k].value, values[k].milli);
+  }
+  publish();
+}
+
+static void feed_dsmr(char c)
+{
+  const ObisEvent ev = obis_parser_feed(parser, c);
+  if (ev == OBIS_NONE) return;
+
+  if (ev == OBIS_HEADER)
+  {
+    begin_scratch();
+    apply_meter_id(scratch(), parser.header, parser.header_len);
+    g_dsmr_open = true;
+    return;
+  }
+
+  if (ev == OBIS_END)
+  {
+    const bool ok = g_dsmr_open && obis_parser_telegram_ok(parser);
+    g_dsmr_open = false;
+    if (ok) publish();
+    else reject("TELEGRAM CRC/INCOMPLETE");
+    return;
+  }
+
+  if (g_dsmr_open) apply_value(scratch(), ev, obis_parser_value(parser), obis_parser_value_milli(parser));
 }
 
-bool han_reader_poll(HanSnapshot& snapshot)
+// Runs on the consumer side only: the ring's tail belongs to this task.
+static bool apply_reset()
 {
-  bool gotNew = false;
+  if (!g_reset_parsers) return false;
+  ring.clear();
+  obis_parser_reset(parser);
+  hdlc_decoder_reset(hdlc);
+  g_dsmr_open = false;
+  g_reset_parsers = false;
+  if (g_reset_done) xSemaphoreGive(g_reset_done);
+  return true;
+}
 
-  while (HanSerial.available() > 0)
+static void ingest_task(void*)
+{
+  uint8_t chunk[128];
+  for (;;)
   {
-    char c = static_cast<char>(HanSerial.read());
-    if (c == '\r') continue;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(250));
+    apply_reset();
+
+    han_capture_service();
+    const bool capture = (g_source == &han_uart_source());
 
-    if (c == '\n')
+    size_t n;
+    while (!apply_reset() && (n = ring.pop(chunk, sizeof(chunk))) > 0)
     {
-      String line = lineBuf;
-      lineBuf = "";
-      line.trim();
-      if (line.length() == 0) continue;
-
-      parse_line(snapshot, line);
-      if (line == "!") gotNew = true;
-      continue;
-    }
+      if (capture) han_capture_append(chunk, n);
+      han_autodetect_ingest(chunk, n);
 
-    if (lineBuf.length() < 220) lineBuf += c;
+      PerfScope perf(PERF_HAN_PARSE, static_cast<uint32_t>(n));
+      for (size_t i = 0; i < n; ++i)
+      {
+        if (g_use_hdlc) feed_hdlc(chunk[i]);
+        if (g_use_dsmr) feed_dsmr(static_cast<char>(chunk[i]));
+      }
+    }
   }
+}
+
+size_t han_ingest_offer(const uint8_t* data, size_t len)
+{
+  const size_t accepted = ring.push(data, len);
+  g_stats.bytes_rx += accepted;
 
-  if (!isnan(snapshot.import_power_w))
+  const uint32_t used = ring.used();
+  if (used > g_stats.ring_high_water) g_stats.ring_high_water = used;
+
+  if (g_task) xTaskNotifyGive(g_task);
+  return accepted;
+}
+
+size_t han_ingest_push(const uint8_t* data, size_t len)
+{
+  const size_t accepted = han_ingest_offer(data, len);
+  g_stats.bytes_dropped += len - accepted;
+  return accepted;
+}
+
+bool han_reader_begin(const DeviceConfig& cfg, HanByteSource* source)
+{
+  if (g_source) g_source->end();
+  g_source = nullptr;
+
+  // Bytes still queued from the previous setting must not reach the new
+  // one (they would skew an autodetect candidate's score). The old source
+  // is stopped, so the ingest task can drop them before the new one starts.
+  if (!g_task)
   {
-    g_last_error = "OK";
-    return true;
+    g_reset_done = xSemaphoreCreateBinary();
+    g_reset_parsers = true;
+    apply_reset();
+    xSemaphoreTake(g_reset_done, 0);
+    xTaskCreatePinnedToCore(ingest_task, "han_ingest", 4096, nullptr, 5, &g_task, HANREADER_INGEST_CORE);
   }
-
-  if (gotNew)
+  else
   {
-    g_last_error = "TELEGRAM INCOMPLETE";
-    return false;
+    xSemaphoreTake(g_reset_done, 0);
+    g_reset_parsers = true;
+    xTaskNotifyGive(g_task);
+    if (xSemaphoreTake(g_reset_done, pdMS_TO_TICKS(RESET_ACK_TIMEOUT_MS)) != pdTRUE)
+    {
+      g_last_error = "HAN RESET TIMEOUT";
+      return false;
+    }
   }
 
+  g_use_dsmr = cfg.han_protocol != "HDLC";
+  g_use_hdlc = cfg.han_protocol != "DSMR";
   g_last_error = "NO HAN TELEGRAM";
-  return false;
+
+  // A reading the old source published but nobody fetched yet must not be
+  // taken for one of the new source (replayed registers as live ones), and
+  // lists with a subset of fields must not inherit its values.
+  portENTER_CRITICAL(&g_mux);
+  g_source_seq = g_seq;
+  g_readings[g_front] = HanReading();
+  portEXIT_CRITICAL(&g_mux);
+
+  g_source = source ? source : &han_uart_source();
+  g_source->begin(cfg);
+  return true;
+}
+
+bool han_reader_running()
+{
+  return g_source != nullptr && !g_source->finished();
+}
+
+bool han_reader_replaying()
+{
+  return g_source != nullptr && g_source != &han_uart_source();
+}
+
+bool han_reader_fetch(uint32_t& seq, HanSnapshot& s)
+{
+  HanReading r;
+  portENTER_CRITICAL(&g_mux);
+  const uint32_t current = g_seq;
+  const bool fresh = current != seq && current != g_source_seq;
+  if (fresh) r = g_readings[g_front];
+  portEXIT_CRITICAL(&g_mux);
+
+  seq = current;
+  if (!fresh) return false;
+
+  for (int i = 0; i < 3; ++i)
+  {
+    s.voltage_v[i] = r.voltage_v[i];
+    s.current_a[i] = r.current_a[i];
+    s.phase_power_w[i] = r.phase_power_w[i];
+  }
+  s.import_power_w = r.import_power_w;
+  s.export_power_w = r.export_power_w;
+  s.import_energy_kwh_total = r.import_energy_kwh_total;
+  s.export_energy_kwh_total = r.export_energy_kwh_total;
+  s.import_wh_total = r.import_wh_total;
+  s.export_wh_total = r.export_wh_total;
+  memcpy(s.meter_id, r.meter_id, sizeof(s.meter_id));
+  return true;
+}
+
+void han_reader_on_publish(void (*fn)())
+{
+  g_on_publish = fn;
+}
+
+HanIngestStats han_reader_stats()
+{
+  HanIngestStats s = g_stats;
+  s.uart_overflows = han_uart_source().overflows();
+  return s;
 }
 
 const char* han_reader_last_error()
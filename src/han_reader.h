@@ -3,7 +3,41 @@
 #include <Arduino.h>
 #include "han_types.h"
 #include "config_store.h"
+#include "han_source.h"
 
-void han_reader_begin(const DeviceConfig& cfg);
-bool han_reader_poll(HanSnapshot& snapshot);
+struct HanIngestStats {
+  uint32_t bytes_rx = 0;
+  uint32_t bytes_dropped = 0;   // ring full
+  uint32_t frames_ok = 0;
+  uint32_t frames_dropped = 0;  // CRC/FCS failures and incomplete telegrams
+  uint32_t uart_overflows = 0;  // driver FIFO/buffer overflow events
+  uint32_t ring_high_water = 0;
+};
+
+// Starts (or restarts) ingestion. Bytes from the source land in a lock-free
+// ring and are parsed by a dedicated task on the core not running loop().
+// Passing nullptr uses the HAN UART. Returns false, with the reader stopped
+// and han_reader_last_error() set, when the ingest task does not acknowledge
+// the parser reset in time.
+bool han_reader_begin(const DeviceConfig& cfg, HanByteSource* source = nullptr);
+
+// False after a failed han_reader_begin() or once a replay has run out of
+// capture, until the next han_reader_begin().
+bool han_reader_running();
+
+// True while a source other than the meter UART (a capture replay) feeds
+// the parsers. Its readings are for display and diagnostics only.
+bool han_reader_replaying();
+
+// Copies the latest published reading into s when it is newer than seq.
+// Telegrams are parsed into a scratch buffer and only swapped in once
+// complete and CRC-valid, so s never sees half a telegram. Readings
+// published before the last han_reader_begin() are skipped.
+bool han_reader_fetch(uint32_t& seq, HanSnapshot& s);
+
+// Called on the ingest task right after a new reading is published. Keep it
+// to flag-setting; the scheduler in loop() does the actual work.
+void han_reader_on_publish(void (*fn)());
+
+HanIngestStats han_reader_stats();
 const char* han_reader_last_error();
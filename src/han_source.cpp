@@ -0,0 +1,48 @@
+#include "han_source.h"
+
+static HardwareSerial HanSerial(1);
+static HanUartSource uartSource;
+
+HanUartSource& han_uart_source()
+{
+  return uartSource;
+}
+
+void HanUartSource::begin(const DeviceConfig& cfg)
+{
+  if (started_) end();
+
+  // Large driver buffer so an ePaper refresh or TLS handshake on the other
+  // core can never overflow the hardware FIFO.
+  HanSerial.setRxBufferSize(2048);
+  const uint32_t serialCfg = (cfg.han_serial == "8E1") ? SERIAL_8E1 : SERIAL_8N1;
+  HanSerial.begin(cfg.han_baud, serialCfg, cfg.han_rx_pin, cfg.han_tx_pin, cfg.han_invert);
+
+  // Runs in the UART driver's event task, not in loop().
+  HanSerial.onReceive([this]() { drain(); }, false);
+  HanSerial.onReceiveError([this](hardwareSerial_error_t err) {
+    if (err == UART_FIFO_OVF_ERROR || err == UART_BUFFER_FULL_ERROR) ++overflows_;
+    else if (err == UART_FRAME_ERROR || err == UART_PARITY_ERROR || err == UART_BREAK_ERROR) ++line_errors_;
+  });
+  started_ = true;
+}
+
+void HanUartSource::end()
+{
+  if (!started_) return;
+  HanSerial.onReceive(nullptr);
+  HanSerial.onReceiveError(nullptr);
+  HanSerial.end();
+  started_ = false;
+}
+
+void HanUartSource::drain()
+{
+  uint8_t chunk[128];
+  while (HanSerial.available() > 0)
+  {
+    const size_t n = HanSerial.read(chunk, sizeof(chunk));
+    if (n == 0) break;
+    han_ingest_push(chunk, n);
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config_store.h"
+
+// Producer side of HAN ingestion. A source delivers raw meter bytes by calling
+// han_ingest_push() from a single context of its choosing (UART event task,
+// replay task, host test loop), at whatever rate it likes.
+class HanByteSource {
+ public:
+  virtual ~HanByteSource() {}
+  virtual void begin(const DeviceConfig& cfg) = 0;
+  virtual void end() = 0;
+  virtual const char* name() const = 0;
+  // True once a finite source (a capture replay) has delivered everything.
+  virtual bool finished() const { return false; }
+};
+
+// Returns the number of bytes accepted; the rest are counted as dropped.
+size_t han_ingest_push(const uint8_t* data, size_t len);
+
+// Like han_ingest_push, but the caller retries what did not fit (no drop count).
+size_t han_ingest_offer(const uint8_t* data, size_t len);
+
+class HanUartSource : public HanByteSource {
+ public:
+  void begin(const DeviceConfig& cfg) override;
+  void end() override;
+  const char* name() const override { return "uart"; }
+
+  uint32_t overflows() const { return overflows_; }
+  uint32_t line_errors() const { return line_errors_; }
+
+ private:
+  void drain();
+
+  bool started_ = false;
+  volatile uint32_t overflows_ = 0;
+  volatile uint32_t line_errors_ = 0;
+};
+
+HanUartSource& han_uart_source();
@@ -2,6 +2,22 @@
 
 #include <Arduino.h>
 
+// Meter values from one complete, validated telegram or HDLC frame.
+struct HanReading {
+  float voltage_v[3] = {NAN, NAN, NAN};
+  float current_a[3] = {NAN, NAN, NAN};
+  float phase_power_w[3] = {NAN, NAN, NAN};
+
+  float import_power_w = NAN;
+  float export_power_w = NAN;
+  float import_energy_kwh_total = NAN;
+  float export_energy_kwh_total = NAN;
+  int64_t import_wh_total = -1;  // exact registers; -1 when not in this list
+  int64_t export_wh_total = -1;
+
+  char meter_id[48] = "N/A";
+};
+
 struct HanSnapshot {
   float voltage_v[3] = {NAN, NAN, NAN};
   float current_a[3] = {NAN, NAN, NAN};
@@ -11,10 +27,14 @@ struct HanSnapshot {
   float export_power_w = NAN;
   float import_energy_kwh_total = NAN;
   float export_energy_kwh_total = NAN;
+  int64_t import_wh_total = -1;
+  int64_t export_wh_total = -1;
 
   float day_energy_kwh = 0.0f;
   float month_energy_kwh = 0.0f;
   float year_energy_kwh = 0.0f;
+  float day_cost_nok = NAN;
+  float month_cost_nok = NAN;
 
   float price_spot_nok_kwh = NAN;
   float price_total_nok_kwh = NAN;
@@ -22,13 +42,13 @@ struct HanSnapshot {
   float selected_capacity_step_kw = NAN;
   float selected_capacity_step_nok_month = NAN;
 
-  String meter_id = "N/A";
-  String source = "HAN";
-  String wifi_status = "NO";
-  String ip_suffix = "";
-  String data_time = "--:--";
-  String refresh_time = "--:--";
-  String zone = "NO1";
+  char meter_id[48] = "N/A";
+  char source[8] = "HAN";
+  char wifi_status[4] = "NO";
+  char ip_suffix[8] = "";
+  char data_time[6] = "--:--";
+  char refresh_time[6] = "--:--";
+  char zone[4] = "NO1";
   bool stale = true;
 };
 
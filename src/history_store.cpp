@@ -0,0 +1,490 @@
+#include "history_store.h"
+
+#include <LittleFS.h>
+#include <time.h>
+
+static const uint16_t PAGE_SIZE = 4096;
+static const uint8_t PAGE_HEADER = 16;
+static const uint8_t RECORD_MAX = 28;  // gap + 5 zigzag varints, worst case
+static const uint8_t kMagic[4] = {'H', 'S', 'T', 1};
+
+struct TierSpec {
+  char id;
+  const char* name;
+  uint32_t period_s;
+  uint32_t retention_s;  // 0 = keep until the slots run out
+  uint8_t slots;
+};
+
+static const TierSpec kTiers[HIST_TIER_COUNT] = {
+  {'m', "min", 60UL, 48UL * 3600UL, 16},
+  {'q', "15m", 900UL, 90UL * 86400UL, 48},
+  {'h', "hour", 3600UL, 3UL * 366UL * 86400UL, 128},
+  {'d', "day", 86400UL, 0, 64},
+};
+
+struct PageInfo {
+  uint32_t seq = 0;
+  uint32_t first_t = 0;
+  uint8_t slot = 0;
+};
+
+struct Tier {
+  PageInfo pages[128];
+  uint8_t count = 0;        // pages[count - 1] is the one in RAM
+
+  uint8_t page[PAGE_SIZE];
+  uint16_t len = 0;
+  uint16_t flushed = 0;
+  HistRecord last;          // delta base for the next record in this page
+  bool has_last = false;
+};
+
+struct Rollup {
+  bool open = false;
+  uint32_t start = 0;
+  uint32_t minutes = 0;
+  uint32_t energy_dwh = 0;
+  uint32_t l1_sum = 0;
+  uint32_t l2_sum = 0;
+  uint32_t l3_sum = 0;
+  uint16_t peak_w = 0;
+};
+
+static Tier g_tiers[HIST_TIER_COUNT];
+static Rollup g_roll[HIST_TIER_COUNT];  // index by tier; HIST_MINUTE unused
+static bool g_seeded = false;
+static uint8_t g_scratch[PAGE_SIZE];
+
+static size_t put_varint(uint8_t* out, uint32_t v)
+{
+  size_t n = 0;
+  while (v >= 0x80)
+  {
+    out[n++] = static_cast<uint8_t>(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(v);
+  return n;
+}
+
+static bool get_varint(const uint8_t*& p, const uint8_t* end, uint32_t& out)
+{
+  out = 0;
+  for (int shift = 0; shift < 35 && p < end; shift += 7)
+  {
+    const uint8_t b = *p++;
+    out |= static_cast<uint32_t>(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+static uint32_t zigzag(int32_t v)
+{
+  return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v)
+{
+  return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+static void put_u32(uint8_t* p, uint32_t v)
+{
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+  p[2] = static_cast<uint8_t>(v >> 16);
+  p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void page_path(HistTier tier, uint8_t slot, char out[16])
+{
+  snprintf(out, 16, "/h%c%03u.bin", kTiers[tier].id, slot);
+}
+
+// Record layout: varint(minutes since previous start), then zigzag deltas of
+// energy, l1, l2, l3 and peak against the previous record in the page.
+static size_t encode_record(const HistRecord& prev, const HistRecord& r, uint8_t* out)
+{
+  size_t n = put_varint(out, (r.start - prev.start) / 60UL);
+  n += put_varint(out + n, zigzag(static_cast<int32_t>(r.energy_dwh - prev.energy_dwh)));
+  n += put_varint(out + n, zigzag(static_cast<int32_t>(r.l1_w) - prev.l1_w));
+  n += put_varint(out + n, zigzag(static_cast<int32_t>(r.l2_w) - prev.l2_w));
+  n += put_varint(out + n, zigzag(static_cast<int32_t>(r.l3_w) - prev.l3_w));
+  n += put_varint(out + n, zigzag(static_cast<int32_t>(r.peak_w) - prev.peak_w));
+  return n;
+}
+
+static bool decode_record(const uint8_t*& p, const uint8_t* end, HistRecord& r)
+{
+  uint32_t v[6];
+  for (int i = 0; i < 6; ++i)
+  {
+    if (!get_varint(p, end, v[i])) return false;
+  }
+  r.start += v[0] * 60UL;
+  r.energy_dwh += static_cast<uint32_t>(unzigzag(v[1]));
+  r.l1_w = static_cast<uint16_t>(r.l1_w + unzigzag(v[2]));
+  r.l2_w = static_cast<uint16_t>(r.l2_w + unzigzag(v[3]));
+  r.l3_w = static_cast<uint16_t>(r.l3_w + unzigzag(v[4]));
+  r.peak_w = static_cast<uint16_t>(r.peak_w + unzigzag(v[5]));
+  return true;
+}
+
+// Walks a page image; the first record is encoded against {first_t, 0...}.
+static bool visit_page(const uint8_t* buf, size_t len, uint32_t from, uint32_t to, HistVisitor fn, void* ctx, HistRecord* lastOut)
+{
+  if (len < PAGE_HEADER) return true;
+  HistRecord r;
+  r.start = get_u32(buf + 8);
+  const uint8_t* p = buf + PAGE_HEADER;
+  const uint8_t* end = buf + len;
+  bool any = false;
+  while (p < end && decode_record(p, end, r))
+  {
+    any = true;
+    if (r.start >= to) return false;
+    if (fn && r.start >= from && !fn(r, ctx)) return false;
+  }
+  if (lastOut && any) *lastOut = r;
+  return true;
+}
+
+static size_t load_page(HistTier tier, uint8_t slot, uint8_t* buf)
+{
+  char path[16];
+  page_path(tier, slot, path);
+  File f = LittleFS.open(path, FILE_READ);
+  if (!f) return 0;
+  const size_t n = f.read(buf, PAGE_SIZE);
+  f.close();
+  if (n < PAGE_HEADER || memcmp(buf, kMagic, sizeof(kMagic)) != 0 || buf[4] != tier) return 0;
+  return n;
+}
+
+static void flush_tier(HistTier tier)
+{
+  Tier& t = g_tiers[tier];
+  if (t.count == 0 || t.flushed >= t.len) return;
+
+  char path[16];
+  page_path(tier, t.pages[t.count - 1].slot, path);
+  File f = LittleFS.open(path, t.flushed == 0 ? FILE_WRITE : FILE_APPEND);
+  if (!f) return;
+  f.write(t.page + t.flushed, t.len - t.flushed);
+  f.close();
+  t.flushed = t.len;
+}
+
+static void drop_oldest(HistTier tier)
+{
+  Tier& t = g_tiers[tier];
+  if (t.count == 0) return;
+  char path[16];
+  page_path(tier, t.pages[0].slot, path);
+  LittleFS.remove(path);
+  for (uint8_t i = 1; i < t.count; ++i) t.pages[i - 1] = t.pages[i];
+  --t.count;
+}
+
+static void start_page(HistTier tier, uint32_t firstT)
+{
+  Tier& t = g_tiers[tier];
+  const TierSpec& spec = kTiers[tier];
+  flush_tier(tier);
+
+  // Old pages go when the ring is full or their records passed retention;
+  // a page ends where the next one starts.
+  while (t.count >= spec.slots) drop_oldest(tier);
+  while (spec.retention_s > 0 && t.count >= 2 && t.pages[1].first_t + spec.retention_s < firstT) drop_oldest(tier);
+
+  PageInfo info;
+  info.seq = (t.count > 0) ? t.pages[t.count - 1].seq + 1 : 1;
+  info.first_t = firstT;
+  info.slot = static_cast<uint8_t>(info.seq % spec.slots);
+  t.pages[t.count++] = info;
+
+  memset(t.page, 0, PAGE_HEADER);
+  memcpy(t.page, kMagic, sizeof(kMagic));
+  t.page[4] = tier;
+  put_u32(t.page + 8, firstT);
+  put_u32(t.page + 12, info.seq);
+  t.len = PAGE_HEADER;
+  t.flushed = 0;
+  t.last = HistRecord();
+  t.last.start = firstT;
+  t.has_last = false;
+}
+
+static void append(HistTier tier, const HistRecord& r)
+{
+  Tier& t = g_tiers[tier];
+  if (t.has_last && r.start <= t.last.start) return;  // clock went back
+
+  if (t.count == 0 || t.len + RECORD_MAX > PAGE_SIZE) start_page(tier, r.start);
+  t.len += encode_record(t.last, r, t.page + t.len);
+  t.last = r;
+  t.has_last = true;
+}
+
+static uint32_t day_start(uint32_t epoch)
+{
+  time_t e = static_cast<time_t>(epoch);
+  tm t;
+  localtime_r(&e, &t);
+  t.tm_hour = 0;
+  t.tm_min = 0;
+  t.tm_sec = 0;
+  t.tm_isdst = -1;
+  return static_cast<uint32_t>(mktime(&t));
+}
+
+static uint32_t bucket_start(HistTier tier, uint32_t start)
+{
+  if (tier == HIST_DAY) return day_start(start);
+  return start - (start % kTiers[tier].period_s);
+}
+
+static uint32_t bucket_end(HistTier tier, uint32_t bucketStart)
+{
+  // Local days are 23-25 h; 25 h past midnight is always inside the next day.
+  if (tier == HIST_DAY) return day_start(bucketStart + 25UL * 3600UL);
+  return bucketStart + kTiers[tier].period_s;
+}
+
+static void close_rollup(HistTier tier)
+{
+  Rollup& b = g_roll[tier];
+  if (!b.open || b.minutes == 0) return;
+  HistRecord r;
+  r.start = b.start;
+  r.energy_dwh = b.energy_dwh;
+  r.l1_w = static_cast<uint16_t>(b.l1_sum / b.minutes);
+  r.l2_w = static_cast<uint16_t>(b.l2_sum / b.minutes);
+  r.l3_w = static_cast<uint16_t>(b.l3_sum / b.minutes);
+  r.peak_w = b.peak_w;
+  append(tier, r);
+  b = Rollup();
+}
+
+// Returns true when a bucket was closed.
+static bool fold(HistTier tier, const HistRecord& m)
+{
+  Rollup& b = g_roll[tier];
+  const uint32_t start = bucket_start(tier, m.start);
+  bool closed = false;
+  if (b.open && b.start != start)
+  {
+    close_rollup(tier);
+    closed = true;
+  }
+  if (!b.open)
+  {
+    b.open = true;
+    b.start = start;
+  }
+  ++b.minutes;
+  b.energy_dwh += m.energy_dwh;
+  b.l1_sum += m.l1_w;
+  b.l2_sum += m.l2_w;
+  b.l3_sum += m.l3_w;
+  if (m.peak_w > b.peak_w) b.peak_w = m.peak_w;
+  return closed;
+}
+
+struct SeedCtx {
+  HistTier tier;
+};
+
+static bool seed_visit(const HistRecord& r, void* ctx)
+{
+  fold(static_cast<SeedCtx*>(ctx)->tier, r);
+  return true;
+}
+
+// After a reboot, rebuild open buckets from the minute tier, starting after
+// the last record each tier already has. Buckets that ended while the device
+// was down get written now.
+static void seed_rollups(uint32_t upTo)
+{
+  const Tier& minutes = g_tiers[HIST_MINUTE];
+  if (minutes.count == 0) return;
+  const uint32_t oldest = minutes.pages[0].first_t;
+
+  for (uint8_t i = HIST_QUARTER; i < HIST_TIER_COUNT; ++i)
+  {
+    const HistTier tier = static_cast<HistTier>(i);
+    const Tier& t = g_tiers[tier];
+    uint32_t from = oldest;
+    if (t.has_last) from = bucket_end(tier, t.last.start);
+    SeedCtx ctx{tier};
+    history_store_query(HIST_MINUTE, from, upTo, seed_visit, &ctx);
+  }
+}
+
+static void load_tier(HistTier tier)
+{
+  Tier& t = g_tiers[tier];
+  t.count = 0;
+  t.len = 0;
+  t.flushed = 0;
+  t.has_last = false;
+
+  for (uint8_t slot = 0; slot < kTiers[tier].slots; ++slot)
+  {
+    char path[16];
+    page_path(tier, slot, path);
+    if (!LittleFS.exists(path)) continue;
+    File f = LittleFS.open(path, FILE_READ);
+    if (!f) continue;
+    uint8_t head[PAGE_HEADER];
+    const size_t n = f.read(head, sizeof(head));
+    f.close();
+    if (n != sizeof(head) || memcmp(head, kMagic, sizeof(kMagic)) != 0 || head[4] != tier) continue;
+
+    PageInfo info;
+    info.first_t = get_u32(head + 8);
+    info.seq = get_u32(head + 12);
+    info.slot = slot;
+
+    // Insert ordered by sequence number.
+    uint8_t at = t.count;
+    while (at > 0 && t.pages[at - 1].seq > info.seq)
+    {
+      t.pages[at] = t.pages[at - 1];
+      --at;
+    }
+    t.pages[at] = info;
+    ++t.count;
+  }
+
+  if (t.count == 0) return;
+
+  // Continue the newest page: its image goes back into RAM.
+  const PageInfo& tail = t.pages[t.count - 1];
+  const size_t len = load_page(tier, tail.slot, t.page);
+  if (len == 0)
+  {
+    --t.count;
+    return;
+  }
+  t.len = static_cast<uint16_t>(len);
+  t.flushed = t.len;
+  t.last = HistRecord();
+  t.last.start = tail.first_t;
+  HistRecord last;
+  t.has_last = false;
+  visit_page(t.page, t.len, 0, UINT32_MAX, nullptr, nullptr, &last);
+  if (t.len > PAGE_HEADER)
+  {
+    t.last = last;
+    t.has_last = true;
+  }
+}
+
+void history_store_begin()
+{
+  for (uint8_t i = 0; i < HIST_TIER_COUNT; ++i)
+  {
+    load_tier(static_cast<HistTier>(i));
+    g_roll[i] = Rollup();
+  }
+  g_seeded = false;
+}
+
+void history_store_add_minute(const HistRecord& r)
+{
+  if (!g_seeded)
+  {
+    seed_rollups(r.start);
+    g_seeded = true;
+  }
+
+  append(HIST_MINUTE, r);
+
+  bool closed = false;
+  for (uint8_t i = HIST_QUARTER; i < HIST_TIER_COUNT; ++i) closed |= fold(static_cast<HistTier>(i), r);
+
+  // Minute records reach flash at least every quarter hour.
+  if (closed) history_store_flush();
+}
+
+void history_store_flush()
+{
+  for (uint8_t i = 0; i < HIST_TIER_COUNT; ++i) flush_tier(static_cast<HistTier>(i));
+}
+
+void history_store_query(HistTier tier, uint32_t from, uint32_t to, HistVisitor fn, void* ctx)
+{
+  if (tier >= HIST_TIER_COUNT || from >= to) return;
+  const Tier& t = g_tiers[tier];
+  if (t.count == 0) return;
+
+  // Last page starting at or before `from`.
+  uint8_t lo = 0;
+  uint8_t hi = t.count;
+  while (hi - lo > 1)
+  {
+    const uint8_t mid = static_cast<uint8_t>((lo + hi) / 2);
+    if (t.pages[mid].first_t <= from) lo = mid;
+    else hi = mid;
+  }
+
+  for (uint8_t i = lo; i < t.count; ++i)
+  {
+    if (t.pages[i].first_t >= to) return;
+    const bool inRam = (i == t.count - 1);
+    const uint8_t* buf = inRam ? t.page : g_scratch;
+    const size_t len = inRam ? t.len : load_page(tier, t.pages[i].slot, g_scratch);
+    if (!visit_page(buf, len, from, to, fn, ctx, nullptr)) return;
+  }
+}
+
+HistTierStats history_store_stats(HistTier tier)
+{
+  HistTierStats s;
+  if (tier >= HIST_TIER_COUNT) return s;
+  const Tier& t = g_tiers[tier];
+  s.pages = t.count;
+  if (t.count > 0) s.first_t = t.pages[0].first_t;
+  if (t.has_last) s.last_t = t.last.start;
+  s.pending_bytes = static_cast<uint16_t>(t.len - t.flushed);
+  return s;
+}
+
+uint32_t history_tier_period(HistTier tier)
+{
+  return (tier < HIST_TIER_COUNT) ? kTiers[tier].period_s : 0;
+}
+
+const char* history_tier_name(HistTier tier)
+{
+  return (tier < HIST_TIER_COUNT) ? kTiers[tier].name : "";
+}
+
+bool history_tier_from_name(const String& name, HistTier& out)
+{
+  for (uint8_t i = 0; i < HIST_TIER_COUNT; ++i)
+  {
+    if (name == kTiers[i].name)
+    {
+      out = static_cast<HistTier>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+float history_record_avg_w(const HistRecord& r, HistTier tier)
+{
+  const uint32_t span = bucket_end(tier, r.start) - r.start;
+  if (span == 0) return 0.0f;
+  return (static_cast<float>(r.energy_dwh) * 360.0f) / static_cast<float>(span);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Consumption history in LittleFS at four resolutions. Each tier is a ring of
+// fixed-size page files ("/h<tier><slot>.bin"); records inside a page are
+// varint/zigzag deltas against the previous record. The page being filled is
+// kept in RAM and appended to flash in batches. Page start times are indexed
+// in RAM so a range query binary-searches to its first page.
+//
+// Callers feed closed minutes; the store rolls them up into 15-minute, hourly
+// and daily records itself.
+
+enum HistTier : uint8_t {
+  HIST_MINUTE = 0,
+  HIST_QUARTER,
+  HIST_HOUR,
+  HIST_DAY,
+  HIST_TIER_COUNT,
+};
+
+struct HistRecord {
+  uint32_t start = 0;       // epoch seconds, minute aligned
+  uint32_t energy_dwh = 0;  // imported energy, 0.1 Wh
+  uint16_t l1_w = 0;        // average per-phase import
+  uint16_t l2_w = 0;
+  uint16_t l3_w = 0;
+  uint16_t peak_w = 0;      // highest import sample in the interval
+};
+
+struct HistTierStats {
+  uint16_t pages = 0;
+  uint32_t first_t = 0;
+  uint32_t last_t = 0;
+  uint16_t pending_bytes = 0;  // in RAM, not yet on flash
+};
+
+// Return false to stop the query.
+typedef bool (*HistVisitor)(const HistRecord& r, void* ctx);
+
+void history_store_begin();
+
+// Appends a closed minute and closes any 15-min/hour/day bucket it ends.
+void history_store_add_minute(const HistRecord& r);
+
+// Writes pending page bytes of every tier.
+void history_store_flush();
+
+// Visits records with from <= start < to, oldest first.
+void history_store_query(HistTier tier, uint32_t from, uint32_t to, HistVisitor fn, void* ctx);
+
+HistTierStats history_store_stats(HistTier tier);
+uint32_t history_tier_period(HistTier tier);  // nominal; days vary with DST
+const char* history_tier_name(HistTier tier);
+bool history_tier_from_name(const String& name, HistTier& out);
+
+// Average total import over the record, in W.
+float history_record_avg_w(const HistRecord& r, HistTier tier);
@@ -1,16 +1,41 @@
 #include "homey_http.h"
+#include "han_reader.h"
+#include "han_capture.h"
+#include "han_autodetect.h"
+#include "perf_stats.h"
+#include "scheduler.h"
+#include "boot_metrics.h"
+#include "history_store.h"
+#include "time_service.h"
+#include "energy_accum.h"
+#include "energy_checkpoint.h"
+#include "cost_ledger.h"
+#include "price_engine.h"
+#include "price_planner.h"
+#include "tariff_engine.h"
+#include "tariff_sim_report.h"
+#include "capacity_guard.h"
 
 #include <WiFi.h>
 #include <WebServer.h>
+#include <LittleFS.h>
 
 static DeviceConfig* g_cfg = nullptr;
-static HanSnapshot g_data;
-static HourBar g_bars[24];
+static const HanSnapshot kNoData;
+static const HourBar kNoBars[24];
+static const HanSnapshot* g_data = &kNoData;
+static const HourBar* g_bars = kNoBars;
 static float g_top3_kw = 0.0f;
 static bool g_refresh_requested = false;
 
 static WebServer server(80);
 
+static void send_ok(const char* type, const String& body)
+{
+  boot_mark(BOOT_FIRST_HTTP_200);
+  server.send(200, type, body);
+}
+
 static bool auth_admin()
 {
   if (!g_cfg) return false;
@@ -37,21 +62,69 @@ static void send_json_unauthorized()
   server.send(401, "application/json", "{\"ok\":false,\"error\":\"unauthorized\"}");
 }
 
+static String accum_json(const AccumResult& r)
+{
+  String out = "{";
+  out += "\"start\":" + String(r.start) + ",";
+  out += "\"seconds\":" + String(r.span_s, 0) + ",";
+  out += "\"kwh\":" + String(r.energy_kwh, 4) + ",";
+  out += "\"export_kwh\":" + String(r.export_kwh, 4) + ",";
+  out += "\"avg_w\":" + String(r.avg_w, 1) + ",";
+  out += "\"l1_w\":" + String(r.phase_avg_w[0], 1) + ",";
+  out += "\"l2_w\":" + String(r.phase_avg_w[1], 1) + ",";
+  out += "\"l3_w\":" + String(r.phase_avg_w[2], 1) + ",";
+  out += "\"peak_w\":" + String(r.peak_w, 1);
+  out += "}";
+  return out;
+}
+
+static String register_json()
+{
+  const AccumRegisterStats s = accum_register_stats();
+  String out = "{";
+  out += "\"import_wh\":" + String(static_cast<long>(s.import_wh)) + ",";
+  out += "\"export_wh\":" + String(static_cast<long>(s.export_wh)) + ",";
+  out += "\"readings\":" + String(s.readings) + ",";
+  out += "\"anchors\":" + String(s.anchors) + ",";
+  out += "\"last_correction_wh\":" + String(s.last_correction_wh, 1) + ",";
+  out += "\"correction_wh\":" + String(s.correction_wh, 1);
+  out += "}";
+  return out;
+}
+
 static String status_json()
 {
+  PerfScope perf(PERF_STATUS_JSON);
   String out;
-  out.reserve(1800);
+  out.reserve(3800);
 
   out += "{";
   out += "\"ok\":true,";
-  out += "\"source\":\"" + g_data.source + "\",";
-  out += "\"zone\":\"" + g_data.zone + "\",";
-  out += "\"stale\":" + String(g_data.stale ? "true" : "false") + ",";
-  out += "\"data_time\":\"" + g_data.data_time + "\",";
-  out += "\"refresh_time\":\"" + g_data.refresh_time + "\",";
-  out += "\"wifi\":\"" + g_data.wifi_status + "\",";
-  out += "\"ip_suffix\":\"" + g_data.ip_suffix + "\",";
-  out += "\"meter_id\":\"" + g_data.meter_id + "\",";
+  out += "\"source\":\"" + String(g_data->source) + "\",";
+  out += "\"zone\":\"" + String(g_data->zone) + "\",";
+  out += "\"stale\":" + String(g_data->stale ? "true" : "false") + ",";
+  out += "\"data_time\":\"" + String(g_data->data_time) + "\",";
+  out += "\"refresh_time\":\"" + String(g_data->refresh_time) + "\",";
+  out += "\"wifi\":\"" + String(g_data->wifi_status) + "\",";
+  out += "\"ip_suffix\":\"" + String(g_data->ip_suffix) + "\",";
+  out += "\"meter_id\":\"" + String(g_data->meter_id) + "\",";
+
+  const HanIngestStats han = han_reader_stats();
+  out += "\"han\":{";
+  out += "\"state\":\"" + String(han_reader_last_error()) + "\",";
+  out += "\"bytes_rx\":" + String(han.bytes_rx) + ",";
+  out += "\"bytes_dropped\":" + String(han.bytes_dropped) + ",";
+  out += "\"frames_ok\":" + String(han.frames_ok) + ",";
+  out += "\"frames_dropped\":" + String(han.frames_dropped) + ",";
+  out += "\"uart_overflows\":" + String(han.uart_overflows) + ",";
+  out += "\"ring_high_water\":" + String(han.ring_high_water);
+  out += "},";
+  out += "\"boot\":" + boot_metrics_json() + ",";
+  out += "\"quarter\":" + accum_json(accum_current(ACC_QUARTER)) + ",";
+  out += "\"last_quarter\":" + accum_json(accum_last(ACC_QUARTER)) + ",";
+  out += "\"hour\":" + accum_json(accum_current(ACC_HOUR)) + ",";
+  out += "\"checkpoint\":" + energy_checkpoint_json() + ",";
+  out += "\"register\":" + register_json() + ",";
 
   out += "\"phase\":[";
   for (int i = 0; i < 3; ++i)
@@ -59,35 +132,40 @@ static String status_json()
     if (i > 0) out += ",";
     out += "{";
     out += "\"id\":" + String(i + 1) + ",";
-    out += "\"voltage_v\":" + String(g_data.voltage_v[i], 1) + ",";
-    out += "\"current_a\":" + String(g_data.current_a[i], 2) + ",";
-    out += "\"power_w\":" + String(g_data.phase_power_w[i], 1);
+    out += "\"voltage_v\":" + String(g_data->voltage_v[i], 1) + ",";
+    out += "\"current_a\":" + String(g_data->current_a[i], 2) + ",";
+    out += "\"power_w\":" + String(g_data->phase_power_w[i], 1);
     out += "}";
   }
   out += "],";
 
   out += "\"power\":{";
-  out += "\"import_w\":" + String(g_data.import_power_w, 1) + ",";
-  out += "\"export_w\":" + String(g_data.export_power_w, 1) + ",";
-  out += "\"import_energy_total_kwh\":" + String(g_data.import_energy_kwh_total, 3) + ",";
-  out += "\"export_energy_total_kwh\":" + String(g_data.export_energy_kwh_total, 3);
+  out += "\"import_w\":" + String(g_data->import_power_w, 1) + ",";
+  out += "\"export_w\":" + String(g_data->export_power_w, 1) + ",";
+  out += "\"import_energy_total_kwh\":" + String(g_data->import_energy_kwh_total, 3) + ",";
+  out += "\"export_energy_total_kwh\":" + String(g_data->export_energy_kwh_total, 3);
   out += "},";
 
   out += "\"energy\":{";
-  out += "\"day_kwh\":" + String(g_data.day_energy_kwh, 3) + ",";
-  out += "\"month_kwh\":" + String(g_data.month_energy_kwh, 3) + ",";
-  out += "\"year_kwh\":" + String(g_data.year_energy_kwh, 3);
+  out += "\"day_kwh\":" + String(g_data->day_energy_kwh, 3) + ",";
+  out += "\"month_kwh\":" + String(g_data->month_energy_kwh, 3) + ",";
+  out += "\"year_kwh\":" + String(g_data->year_energy_kwh, 3);
   out += "},";
+  out += "\"cost\":" + cost_ledger_json() + ",";
+  out += "\"capacity_guard\":" + capacity_guard_json() + ",";
 
   out += "\"price\":{";
-  out += "\"spot_nok_kwh\":" + String(g_data.price_spot_nok_kwh, 4) + ",";
-  out += "\"grid_nok_kwh\":" + String(g_data.price_grid_nok_kwh, 4) + ",";
-  out += "\"total_nok_kwh\":" + String(g_data.price_total_nok_kwh, 4) + ",";
+  out += "\"spot_nok_kwh\":" + String(g_data->price_spot_nok_kwh, 4) + ",";
+  out += "\"grid_nok_kwh\":" + String(g_data->price_grid_nok_kwh, 4) + ",";
+  out += "\"total_nok_kwh\":" + String(g_data->price_total_nok_kwh, 4) + ",";
   out += "\"capacity_top3_kw\":" + String(g_top3_kw, 3) + ",";
-  out += "\"capacity_step_nok_month\":" + String(g_data.selected_capacity_step_nok_month, 2);
+  out += "\"capacity_step_nok_month\":" + String(g_data->selected_capacity_step_nok_month, 2) + ",";
+  const TimeNow& now = time_now();
+  out += "\"tariff_day\":\"" + String(now.valid ? tariff_day_type_name(tariff_day_type(tariff_active(), now.local)) : "") + "\"";
   out += "}";
 
   out += "}";
+  perf.set_units(out.length());
   return out;
 }
 
@@ -96,6 +174,7 @@ static String history_json(int limit)
   if (limit < 1) limit = 1;
   if (limit > 24) limit = 24;
 
+  PerfScope perf(PERF_HISTORY_JSON);
   String out = "{\"ok\":true,\"hours\":[";
   for (int i = 24 - limit; i < 24; ++i)
   {
@@ -110,6 +189,69 @@ static String history_json(int limit)
     out += "}";
   }
   out += "]}";
+  perf.set_units(out.length());
+  return out;
+}
+
+struct HistJsonCtx {
+  String* out;
+  HistTier tier;
+  int left;
+  bool first;
+};
+
+static bool hist_record_json(const HistRecord& r, void* ctx)
+{
+  HistJsonCtx& c = *static_cast<HistJsonCtx*>(ctx);
+  String& out = *c.out;
+  if (!c.first) out += ",";
+  c.first = false;
+  out += "{";
+  out += "\"start\":" + String(r.start) + ",";
+  out += "\"kwh\":" + String(r.energy_dwh / 10000.0f, 4) + ",";
+  out += "\"avg_w\":" + String(history_record_avg_w(r, c.tier), 1) + ",";
+  out += "\"l1_w\":" + String(r.l1_w) + ",";
+  out += "\"l2_w\":" + String(r.l2_w) + ",";
+  out += "\"l3_w\":" + String(r.l3_w) + ",";
+  out += "\"peak_w\":" + String(r.peak_w);
+  out += "}";
+  return --c.left > 0;
+}
+
+// Stored history at one resolution. Without `from`, returns the last `limit`
+// intervals before `to` (default now).
+static String history_store_json(HistTier tier, int limit, uint32_t from, uint32_t to)
+{
+  if (limit < 1) limit = 1;
+  if (limit > 288) limit = 288;
+  if (to == 0) to = time_valid() ? static_cast<uint32_t>(time_now().epoch) + 1 : UINT32_MAX;
+  if (from == 0)
+  {
+    const uint32_t span = history_tier_period(tier) * static_cast<uint32_t>(limit);
+    from = (to > span) ? to - span : 0;
+  }
+
+  PerfScope perf(PERF_HISTORY_JSON);
+  String out;
+  out.reserve(96 + limit * 110);
+  out += "{\"ok\":true,\"res\":\"" + String(history_tier_name(tier)) + "\",";
+  out += "\"from\":" + String(from) + ",\"to\":" + String(to) + ",\"records\":[";
+  HistJsonCtx ctx{&out, tier, limit, true};
+  history_store_query(tier, from, to, hist_record_json, &ctx);
+  out += "],\"tiers\":{";
+  for (uint8_t i = 0; i < HIST_TIER_COUNT; ++i)
+  {
+    const HistTierStats st = history_store_stats(static_cast<HistTier>(i));
+    if (i > 0) out += ",";
+    out += "\"" + String(history_tier_name(static_cast<HistTier>(i))) + "\":{";
+    out += "\"pages\":" + String(st.pages) + ",";
+    out += "\"first\":" + String(st.first_t) + ",";
+    out += "\"last\":" + String(st.last_t) + ",";
+    out += "\"pending_bytes\":" + String(st.pending_bytes);
+    out += "}";
+  }
+  out += "}}";
+  perf.set_units(out.length());
   return out;
 }
 
@@ -132,32 +274,52 @@ static String html_page(const String& body)
 
 static void handle_health()
 {
-  server.send(200, "application/json", "{\"ok\":true,\"service\":\"han-reader\"}");
+  send_ok("application/json", "{\"ok\":true,\"service\":\"han-reader\"}");
 }
 
 static void handle_status_main()
 {
   if (!auth_token(g_cfg->api_token)) return send_json_unauthorized();
-  server.send(200, "application/json", status_json());
+  send_ok("application/json", status_json());
 }
 
 static void handle_status_homey()
 {
   if (!g_cfg->homey_enabled || !auth_token(g_cfg->homey_api_token)) return send_json_unauthorized();
-  server.send(200, "application/json", status_json());
+  send_ok("application/json", status_json());
+}
+
+// Small enough for Homey to poll every few seconds.
+static void handle_capacity_homey()
+{
+  if (!g_cfg->homey_enabled || !auth_token(g_cfg->homey_api_token)) return send_json_unauthorized();
+  send_ok("application/json", "{\"ok\":true,\"capacity_guard\":" + capacity_guard_json() + "}");
 }
 
 static void handle_status_ha()
 {
   if (!g_cfg->ha_enabled || !auth_token(g_cfg->ha_api_token)) return send_json_unauthorized();
-  server.send(200, "application/json", status_json());
+  send_ok("application/json", status_json());
 }
 
 static void handle_history()
 {
   if (!auth_token(g_cfg->api_token)) return send_json_unauthorized();
   int limit = server.hasArg("limit") ? server.arg("limit").toInt() : 24;
-  server.send(200, "application/json", history_json(limit));
+  if (server.hasArg("res"))
+  {
+    HistTier tier;
+    if (!history_tier_from_name(server.arg("res"), tier))
+    {
+      server.send(400, "application/json", "{\"ok\":false,\"error\":\"res must be min, 15m, hour or day\"}");
+      return;
+    }
+    const uint32_t from = server.hasArg("from") ? static_cast<uint32_t>(server.arg("from").toInt()) : 0;
+    const uint32_t to = server.hasArg("to") ? static_cast<uint32_t>(server.arg("to").toInt()) : 0;
+    send_ok("application/json", history_store_json(tier, limit, from, to));
+    return;
+  }
+  send_ok("application/json", history_json(limit));
 }
 
 static void handle_public()
@@ -167,29 +329,29 @@ static void handle_public()
   b += "<h1>HAN Reader</h1>";
   b += "<div class='card'>";
   b += "<p><b>Import na:</b> ";
-  b += String(g_data.import_power_w, 0);
+  b += String(g_data->import_power_w, 0);
   b += " W | <b>Pris:</b> ";
-  b += String(g_data.price_total_nok_kwh, 2);
+  b += String(g_data->price_total_nok_kwh, 2);
   b += " NOK/kWh</p>";
   b += "<p><b>Dag:</b> ";
-  b += String(g_data.day_energy_kwh, 2);
+  b += String(g_data->day_energy_kwh, 2);
   b += " kWh | <b>Mnd:</b> ";
-  b += String(g_data.month_energy_kwh, 1);
+  b += String(g_data->month_energy_kwh, 1);
   b += " kWh | <b>Ar:</b> ";
-  b += String(g_data.year_energy_kwh, 0);
+  b += String(g_data->year_energy_kwh, 0);
   b += " kWh</p></div>";
 
   b += "<div class='card'><h3>Faser</h3><div class='g'>";
   for (int i = 0; i < 3; ++i)
   {
-    b += "<div><b>L" + String(i + 1) + "</b><br>A: " + String(g_data.current_a[i], 2) + "<br>W: " + String(g_data.phase_power_w[i], 0) + "</div>";
+    b += "<div><b>L" + String(i + 1) + "</b><br>A: " + String(g_data->current_a[i], 2) + "<br>W: " + String(g_data->phase_power_w[i], 0) + "</div>";
   }
   b += "</div></div>";
 
   b += "<div class='card'><p>API: <code>/status</code> (Bearer), Homey: <code>/homey/status</code>, HA: <code>/ha/status</code></p>";
   b += "<p><a href='/admin'>Admin</a></p></div>";
 
-  server.send(200, "text/html", html_page(b));
+  send_ok("text/html", html_page(b));
 }
 
 static bool parse_bool_arg(const String& v)
@@ -197,17 +359,77 @@ static bool parse_bool_arg(const String& v)
   return (v == "1" || v == "on" || v == "true" || v == "TRUE");
 }
 
+static void handle_perf()
+{
+  if (!auth_token(g_cfg->api_token)) return send_json_unauthorized();
+  send_ok("application/json", perf_json());
+  if (server.hasArg("reset") && parse_bool_arg(server.arg("reset"))) perf_reset();
+}
+
+static void handle_sched()
+{
+  if (!auth_token(g_cfg->api_token)) return send_json_unauthorized();
+  send_ok("application/json", sched_json());
+}
+
+static void handle_prices()
+{
+  if (!auth_token(g_cfg->api_token)) return send_json_unauthorized();
+  send_ok("application/json", price_engine_json(*g_cfg));
+}
+
+static void handle_plan()
+{
+  if (!auth_token(g_cfg->api_token)) return send_json_unauthorized();
+  if (!time_valid())
+  {
+    server.send(503, "application/json", "{\"ok\":false,\"error\":\"time not set\"}");
+    return;
+  }
+  PlanQuery q;
+  const String res = server.hasArg("res") ? server.arg("res") : String("hour");
+  q.slot_s = (res == "15m") ? 900 : (res == "hour") ? 3600 : 0;
+  const long minutes = server.hasArg("minutes") ? server.arg("minutes").toInt() : 60;
+  const long slots = (minutes > 0 && q.slot_s > 0) ? (minutes * 60 + q.slot_s - 1) / q.slot_s : 0;
+  q.slots = (slots > 0 && slots <= PLAN_SLOTS_MAX) ? static_cast<uint16_t>(slots) : 0;
+  q.from = server.hasArg("from") ? static_cast<uint32_t>(server.arg("from").toInt()) : 0;
+  if (q.from == 0) q.from = static_cast<uint32_t>(time_now().epoch);
+  q.deadline = server.hasArg("by") ? static_cast<uint32_t>(server.arg("by").toInt()) : 0;
+
+  const String body = price_plan_json(*g_cfg, g_top3_kw, q);
+  if (body.startsWith("{\"ok\":false")) server.send(400, "application/json", body);
+  else send_ok("application/json", body);
+}
+
+static void handle_tariff_sim()
+{
+  if (!auth_token(g_cfg->api_token)) return send_json_unauthorized();
+  HistTier tier = HIST_HOUR;
+  if (server.hasArg("res") && (!history_tier_from_name(server.arg("res"), tier) || (tier != HIST_HOUR && tier != HIST_QUARTER)))
+  {
+    server.send(400, "application/json", "{\"ok\":false,\"error\":\"res must be 15m or hour\"}");
+    return;
+  }
+  long days = server.hasArg("days") ? server.arg("days").toInt() : 365;
+  if (days < 1) days = 1;
+  if (days > 366) days = 366;
+  const uint32_t to = time_valid() ? static_cast<uint32_t>(time_now().epoch) : UINT32_MAX;
+  const uint32_t span = static_cast<uint32_t>(days) * 86400UL;
+  const uint32_t from = (to > span) ? to - span : 0;
+  send_ok("application/json", tariff_sim_json(*g_cfg, tier, from, to, server.arg("tiers")));
+}
+
 static void handle_admin()
 {
   if (!auth_admin()) return server.requestAuthentication();
 
   String b;
-  b.reserve(7200);
+  b.reserve(8200);
   b += "<h1>HAN Reader Admin</h1>";
 
   b += "<div class='card'><h3>Status</h3>";
-  b += "<p>Data: <b>" + g_data.data_time + "</b> | Refresh: <b>" + g_data.refresh_time + "</b> | Zone: <b>" + g_data.zone + "</b></p>";
-  b += "<p>Import: <b>" + String(g_data.import_power_w, 0) + " W</b>, Spot: <b>" + String(g_data.price_spot_nok_kwh, 2) + "</b>, Total: <b>" + String(g_data.price_total_nok_kwh, 2) + " NOK/kWh</b></p>";
+  b += "<p>Data: <b>" + String(g_data->data_time) + "</b> | Refresh: <b>" + String(g_data->refresh_time) + "</b> | Zone: <b>" + String(g_data->zone) + "</b></p>";
+  b += "<p>Import: <b>" + String(g_data->import_power_w, 0) + " W</b>, Spot: <b>" + String(g_data->price_spot_nok_kwh, 2) + "</b>, Total: <b>" + String(g_data->price_total_nok_kwh, 2) + " NOK/kWh</b></p>";
   b += "<form method='post' action='/admin/refresh_now'><button type='submit'>Refresh now</button></form>";
   b += "</div>";
 
@@ -224,6 +446,12 @@ static void handle_admin()
   b += "<div><label>Poll intervall ms (>=180000)</label><input name='poll' value='" + String(g_cfg->poll_interval_ms) + "'></div>";
   b += "<div><label>HAN baud</label><input name='hanbaud' value='" + String(g_cfg->han_baud) + "'></div>";
 
+  b += "<div><label>HAN seriell (8N1/8E1)</label><input name='hanser' value='" + g_cfg->han_serial + "'></div>";
+  b += "<div><label>HAN protokoll (AUTO/DSMR/HDLC)</label><input name='hanproto' value='" + g_cfg->han_protocol + "'></div>";
+
+  b += "<div><label>HAN autodetect (1/0)</label><input name='hanauto' value='" + String(g_cfg->han_autodetect ? "1" : "0") + "'></div>";
+  b += "<div></div>";
+
   b += "<div><label>HAN RX pin</label><input name='hanrx' value='" + String(g_cfg->han_rx_pin) + "'></div>";
   b += "<div><label>HAN TX pin</label><input name='hantx' value='" + String(g_cfg->han_tx_pin) + "'></div>";
 
@@ -233,6 +461,11 @@ static void handle_admin()
   b += "<div><label>Manuell spot enabled (1/0)</label><input name='mspot' value='" + String(g_cfg->manual_spot_enabled ? "1" : "0") + "'></div>";
   b += "<div><label>Manuell spot NOK/kWh</label><input name='mspotv' value='" + String(g_cfg->manual_spot_nok_kwh, 3) + "'></div>";
 
+  b += "<div><label>ENTSO-E token (tom = av)</label><input name='entsoe' value='" + g_cfg->price_entsoe_token + "'></div>";
+  b += "<div><label>EUR/NOK (for ENTSO-E)</label><input name='eurnok' value='" + String(g_cfg->price_eur_nok, 4) + "'></div>";
+  b += "<div><label>Egen pris-URL ({Y} {M} {D} {zone})</label><input name='purl' value='" + g_cfg->price_custom_url + "'></div>";
+  b += "<div><label>Egen pris-URL uten sertifikatsjekk (1/0)</label><input name='purlins' value='" + String(g_cfg->price_custom_unverified ? "1" : "0") + "'></div>";
+
   b += "<div><label>Tariff profile (CUSTOM/ELVIA_EXAMPLE/BKK_EXAMPLE/TENSIO_EXAMPLE)</label><input name='tprof' value='" + g_cfg->tariff_profile + "'></div>";
   b += "<div><label>Kapasitetsledd tiers (kw:nok,kw:nok)</label><input name='tcap' value='" + g_cfg->tariff_capacity_tiers + "'></div>";
 
@@ -242,6 +475,12 @@ static void handle_admin()
   b += "<div><label>Energiledd helg ore/kWh</label><input name='teweek' value='" + String(g_cfg->tariff_energy_weekend_ore, 2) + "'></div>";
   b += "<div><label>Dagvindu start-slutt (timer)</label><input name='tdstart' value='" + String(g_cfg->tariff_day_start_hour) + "'><input name='tdend' value='" + String(g_cfg->tariff_day_end_hour) + "'></div>";
 
+  b += "<div><label>Ekstra band hverdag (tt-tt:ore,...)</label><input name='tbands' value='" + g_cfg->tariff_bands + "'></div>";
+  b += "<div><label>Helligdager som helg (1/0)</label><input name='thol' value='" + String(g_cfg->tariff_holidays_off ? "1" : "0") + "'></div>";
+
+  b += "<div><label>Vintermaneder (f.eks. 1-3,11-12)</label><input name='twin' value='" + g_cfg->tariff_winter_months + "'></div>";
+  b += "<div><label>Vintertillegg ore/kWh</label><input name='twinore' value='" + String(g_cfg->tariff_winter_extra_ore, 2) + "'></div>";
+
   b += "<div><label>Elavgift ore/kWh</label><input name='telavg' value='" + String(g_cfg->tariff_elavgift_ore, 2) + "'></div>";
   b += "<div><label>Enova ore/kWh</label><input name='tenova' value='" + String(g_cfg->tariff_enova_ore, 2) + "'></div>";
 
@@ -254,6 +493,26 @@ static void handle_admin()
   b += "</div>";
   b += "<button type='submit'>Lagre</button></form></div>";
 
+  const HanAutodetectStatus det = han_autodetect_status();
+  b += "<div class='card'><h3>HAN autodetect</h3>";
+  b += "<p>Status: <b>" + String(han_reader_last_error()) + "</b>";
+  if (det.running) b += " | Tester " + String(det.candidate + 1) + "/" + String(det.candidates);
+  else if (det.result[0]) b += " | Resultat: <b>" + String(det.result) + "</b>";
+  b += "</p><form method='post' action='/admin/han_detect'><button type='submit'>Finn HAN-innstillinger</button></form>";
+  b += "</div>";
+
+  const HanCaptureStatus cap = han_capture_status();
+  b += "<div class='card'><h3>HAN capture</h3>";
+  b += "<p>Opptak: <b>" + String(cap.active ? "AKTIV" : "AV") + "</b> | Fil: " + String(cap.file_bytes) + " B, " + String(cap.records) + " records";
+  b += " | Replay: <b>" + String(cap.replaying ? "AKTIV" : "AV") + "</b></p>";
+  b += "<form method='post' action='/admin/capture'><input type='hidden' name='on' value='" + String(cap.active ? "0" : "1") + "'>";
+  b += "<button type='submit'>" + String(cap.active ? "Stopp opptak" : "Start opptak") + "</button></form>";
+  b += "<p><a href='/admin/capture'>Last ned opptak</a></p>";
+  b += "<form method='post' action='/admin/replay'><label>Replay hastighet (1 = sanntid, 0 = maks)</label><input name='speed' value='1'>";
+  b += "<button type='submit'>Start replay</button></form>";
+  b += "<form method='post' action='/admin/replay_stop'><button type='submit'>Stopp replay (tilbake til UART)</button></form>";
+  b += "</div>";
+
   b += "<div class='card'><h3>API tokens</h3>";
   b += "<p>Main: <code>" + g_cfg->api_token + "</code></p>";
   b += "<p>Homey: <code>" + g_cfg->homey_api_token + "</code></p>";
@@ -263,7 +522,7 @@ static void handle_admin()
   b += "<form method='post' action='/admin/reboot'><button type='submit'>Restart enhet</button></form>";
   b += "</div>";
 
-  server.send(200, "text/html", html_page(b));
+  send_ok("text/html", html_page(b));
 }
 
 static void handle_save()
@@ -281,6 +540,9 @@ static void handle_save()
   if (server.hasArg("disp")) g_cfg->display_enabled = parse_bool_arg(server.arg("disp"));
   if (server.hasArg("poll")) g_cfg->poll_interval_ms = max(180000UL, static_cast<uint32_t>(server.arg("poll").toInt()));
   if (server.hasArg("hanbaud")) g_cfg->han_baud = static_cast<uint32_t>(server.arg("hanbaud").toInt());
+  if (server.hasArg("hanser")) g_cfg->han_serial = server.arg("hanser");
+  if (server.hasArg("hanproto")) g_cfg->han_protocol = server.arg("hanproto");
+  if (server.hasArg("hanauto")) g_cfg->han_autodetect = parse_bool_arg(server.arg("hanauto"));
   if (server.hasArg("hanrx")) g_cfg->han_rx_pin = server.arg("hanrx").toInt();
   if (server.hasArg("hantx")) g_cfg->han_tx_pin = server.arg("hantx").toInt();
 
@@ -288,6 +550,10 @@ static void handle_save()
   if (server.hasArg("papi")) g_cfg->price_api_enabled = parse_bool_arg(server.arg("papi"));
   if (server.hasArg("mspot")) g_cfg->manual_spot_enabled = parse_bool_arg(server.arg("mspot"));
   if (server.hasArg("mspotv")) g_cfg->manual_spot_nok_kwh = server.arg("mspotv").toFloat();
+  if (server.hasArg("entsoe")) g_cfg->price_entsoe_token = server.arg("entsoe");
+  if (server.hasArg("eurnok")) g_cfg->price_eur_nok = server.arg("eurnok").toFloat();
+  if (server.hasArg("purl")) g_cfg->price_custom_url = server.arg("purl");
+  if (server.hasArg("purlins")) g_cfg->price_custom_unverified = parse_bool_arg(server.arg("purlins"));
 
   if (server.hasArg("tprof")) g_cfg->tariff_profile = server.arg("tprof");
   if (server.hasArg("tcap")) g_cfg->tariff_capacity_tiers = server.arg("tcap");
@@ -296,6 +562,10 @@ static void handle_save()
   if (server.hasArg("teweek")) g_cfg->tariff_energy_weekend_ore = server.arg("teweek").toFloat();
   if (server.hasArg("tdstart")) g_cfg->tariff_day_start_hour = server.arg("tdstart").toInt();
   if (server.hasArg("tdend")) g_cfg->tariff_day_end_hour = server.arg("tdend").toInt();
+  if (server.hasArg("tbands")) g_cfg->tariff_bands = server.arg("tbands");
+  if (server.hasArg("thol")) g_cfg->tariff_holidays_off = parse_bool_arg(server.arg("thol"));
+  if (server.hasArg("twin")) g_cfg->tariff_winter_months = server.arg("twin");
+  if (server.hasArg("twinore")) g_cfg->tariff_winter_extra_ore = server.arg("twinore").toFloat();
   if (server.hasArg("telavg")) g_cfg->tariff_elavgift_ore = server.arg("telavg").toFloat();
   if (server.hasArg("tenova")) g_cfg->tariff_enova_ore = server.arg("tenova").toFloat();
   if (server.hasArg("tfix")) g_cfg->tariff_fixed_monthly_nok = server.arg("tfix").toFloat();
@@ -309,14 +579,14 @@ static void handle_save()
   config_save(*g_cfg);
   g_refresh_requested = true;
 
-  server.send(200, "text/html", html_page("<h1>Lagret</h1><p>Innstillinger lagret. <a href='/admin'>Tilbake</a></p>"));
+  send_ok("text/html", html_page("<h1>Lagret</h1><p>Innstillinger lagret. <a href='/admin'>Tilbake</a></p>"));
 }
 
 static void handle_refresh_now()
 {
   if (!auth_admin()) return server.requestAuthentication();
   g_refresh_requested = true;
-  server.send(200, "text/html", html_page("<h1>Refresh trigget</h1><p><a href='/admin'>Tilbake</a></p>"));
+  send_ok("text/html", html_page("<h1>Refresh trigget</h1><p><a href='/admin'>Tilbake</a></p>"));
 }
 
 static void handle_toggle_panic()
@@ -324,17 +594,80 @@ static void handle_toggle_panic()
   if (!auth_admin()) return server.requestAuthentication();
   g_cfg->api_panic_stop = !g_cfg->api_panic_stop;
   config_save(*g_cfg);
-  server.send(200, "text/html", html_page("<h1>Oppdatert</h1><p><a href='/admin'>Tilbake</a></p>"));
+  send_ok("text/html", html_page("<h1>Oppdatert</h1><p><a href='/admin'>Tilbake</a></p>"));
 }
 
 static void handle_reboot()
 {
   if (!auth_admin()) return server.requestAuthentication();
-  server.send(200, "text/html", html_page("<h1>Starter pa nytt</h1>"));
+  send_ok("text/html", html_page("<h1>Starter pa nytt</h1>"));
+  energy_checkpoint_save(true);
+  history_store_flush();
   delay(150);
   ESP.restart();
 }
 
+static void handle_capture_download()
+{
+  if (!auth_admin()) return server.requestAuthentication();
+  if (han_capture_status().active)
+  {
+    server.send(409, "application/json", "{\"ok\":false,\"error\":\"capture_active\"}");
+    return;
+  }
+
+  File f = LittleFS.open(HAN_CAPTURE_PATH, FILE_READ);
+  if (!f)
+  {
+    server.send(404, "application/json", "{\"ok\":false,\"error\":\"no_capture\"}");
+    return;
+  }
+  server.sendHeader("Content-Disposition", "attachment; filename=han_capture.bin");
+  server.streamFile(f, "application/octet-stream");
+  f.close();
+}
+
+static void handle_capture_toggle()
+{
+  if (!auth_admin()) return server.requestAuthentication();
+  han_capture_request(server.hasArg("on") && parse_bool_arg(server.arg("on")));
+  send_ok("text/html", html_page("<h1>Oppdatert</h1><p><a href='/admin'>Tilbake</a></p>"));
+}
+
+static void handle_replay()
+{
+  if (!auth_admin()) return server.requestAuthentication();
+  han_capture_request(false);
+  long speed = server.hasArg("speed") ? server.arg("speed").toInt() : 1;
+  if (speed < 0) speed = 0;
+  if (speed > 10000) speed = 10000;
+  han_replay_source().set_speed(static_cast<uint16_t>(speed));
+  if (!han_reader_begin(*g_cfg, &han_replay_source()))
+  {
+    server.send(503, "text/html", html_page("<h1>Replay feilet</h1><p>" + String(han_reader_last_error()) + "</p><p><a href='/admin'>Tilbake</a></p>"));
+    return;
+  }
+  send_ok("text/html", html_page("<h1>Replay startet</h1><p><a href='/admin'>Tilbake</a></p>"));
+}
+
+static void handle_replay_stop()
+{
+  if (!auth_admin()) return server.requestAuthentication();
+  if (!han_reader_begin(*g_cfg))
+  {
+    server.send(503, "text/html", html_page("<h1>Replay ikke stoppet</h1><p>" + String(han_reader_last_error()) + "</p><p><a href='/admin'>Tilbake</a></p>"));
+    return;
+  }
+  send_ok("text/html", html_page("<h1>Replay stoppet</h1><p><a href='/admin'>Tilbake</a></p>"));
+}
+
+static void handle_han_detect()
+{
+  if (!auth_admin()) return server.requestAuthentication();
+  han_autodetect_start();
+  send_ok("text/html", html_page("<h1>Autodetect startet</h1><p><a href='/admin'>Tilbake</a></p>"));
+}
+
 static void handle_not_found()
 {
   server.send(404, "application/json", "{\"ok\":false,\"error\":\"not_found\"}");
@@ -348,7 +681,13 @@ void webportal_begin(DeviceConfig& cfg)
   server.on("/health", HTTP_GET, handle_health);
   server.on("/status", HTTP_GET, handle_status_main);
   server.on("/status/history", HTTP_GET, handle_history);
+  server.on("/status/perf", HTTP_GET, handle_perf);
+  server.on("/status/sched", HTTP_GET, handle_sched);
+  server.on("/status/prices", HTTP_GET, handle_prices);
+  server.on("/status/plan", HTTP_GET, handle_plan);
+  server.on("/status/tariff_sim", HTTP_GET, handle_tariff_sim);
   server.on("/homey/status", HTTP_GET, handle_status_homey);
+  server.on("/homey/capacity", HTTP_GET, handle_capacity_homey);
   server.on("/ha/status", HTTP_GET, handle_status_ha);
 
   server.on("/admin", HTTP_GET, handle_admin);
@@ -356,9 +695,15 @@ void webportal_begin(DeviceConfig& cfg)
   server.on("/admin/refresh_now", HTTP_POST, handle_refresh_now);
   server.on("/admin/reboot", HTTP_POST, handle_reboot);
   server.on("/admin/toggle_panic", HTTP_POST, handle_toggle_panic);
+  server.on("/admin/capture", HTTP_GET, handle_capture_download);
+  server.on("/admin/capture", HTTP_POST, handle_capture_toggle);
+  server.on("/admin/replay", HTTP_POST, handle_replay);
+  server.on("/admin/replay_stop", HTTP_POST, handle_replay_stop);
+  server.on("/admin/han_detect", HTTP_POST, handle_han_detect);
 
   server.onNotFound(handle_not_found);
   server.begin();
+  boot_mark(BOOT_HTTP_READY);
 }
 
 void webportal_loop()
@@ -368,8 +713,9 @@ void webportal_loop()
 
 void webportal_set_data(const HanSnapshot& data, const HourBar bars[24], float top3HourlyKw)
 {
-  g_data = data;
-  for (int i = 0; i < 24; ++i) g_bars[i] = bars[i];
+  // Both live in the sketch for the whole run; keep pointers, not copies.
+  g_data = &data;
+  g_bars = bars;
   g_top3_kw = top3HourlyKw;
 }
 
@@ -0,0 +1,287 @@
+#include "https_client.h"
+
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+
+// Set to 1 to skip CA checks (e.g. behind a TLS-intercepting proxy). Only
+// requests that allow unverified connections are affected.
+#ifndef HANREADER_TLS_INSECURE
+#define HANREADER_TLS_INSECURE 0
+#endif
+
+// ISRG Root X1 (Let's Encrypt), valid to 2035.
+static const char kIsrgRootX1[] =
+    "-----BEGIN CERTIFICATE-----\n"
+    "MIIFazCCA1OgAwIBAgIRAIIQz7DSQONZRGPgu2OCiwAwDQYJKoZIhvcNAQELBQAw\n"
+    "TzELMAkGA1UEBhMCVVMxKTAnBgNVBAoTIEludGVybmV0IFNlY3VyaXR5IFJlc2Vh\n"
+    "cmNoIEdyb3VwMRUwEwYDVQQDEwxJU1JHIFJvb3QgWDEwHhcNMTUwNjA0MTEwNDM4\n"
+    "WhcNMzUwNjA0MTEwNDM4WjBPMQswCQYDVQQGEwJVUzEpMCcGA1UEChMgSW50ZXJu\n"
+    "ZXQgU2VjdXJpdHkgUmVzZWFyY2ggR3JvdXAxFTATBgNVBAMTDElTUkcgUm9vdCBY\n"
+    "MTCCAiIwDQYJKoZIhvcNAQEBBQADggIPADCCAgoCggIBAK3oJHP0FDfzm54rVygc\n"
+    "h77ct984kIxuPOZXoHj3dcKi/vVqbvYATyjb3miGbESTtrFj/RQSa78f0uoxmyF+\n"
+    "0TM8ukj13Xnfs7j/EvEhmkvBioZxaUpmZmyPfjxwv60pIgbz5MDmgK7iS4+3mX6U\n"
+    "A5/TR5d8mUgjU+g4rk8Kb4Mu0UlXjIB0ttov0DiNewNwIRt18jA8+o+u3dpjq+sW\n"
+    "T8KOEUt+zwvo/7V3LvSye0rgTBIlDHCNAymg4VMk7BPZ7hm/ELNKjD+Jo2FR3qyH\n"
+    "B5T0Y3HsLuJvW5iB4YlcNHlsdu87kGJ55tukmi8mxdAQ4Q7e2RCOFvu396j3x+UC\n"
+    "B5iPNgiV5+I3lg02dZ77DnKxHZu8A/lJBdiB3QW0KtZB6awBdpUKD9jf1b0SHzUv\n"
+    "KBds0pjBqAlkd25HN7rOrFleaJ1/ctaJxQZBKT5ZPt0m9STJEadao0xAH0ahmbWn\n"
+    "OlFuhjuefXKnEgV4We0+UXgVCwOPjdAvBbI+e0ocS3MFEvzG6uBQE3xDk3SzynTn\n"
+    "jh8BCNAw1FtxNrQHusEwMFxIt4I7mKZ9YIqioymCzLq9gwQbooMDQaHWBfEbwrbw\n"
+    "qHyGO0aoSCqI3Haadr8faqU9GY/rOPNk3sgrDQoo//fb4hVC1CLQJ13hef4Y53CI\n"
+    "rU7m2Ys6xt0nUW7/vGT1M0NPAgMBAAGjQjBAMA4GA1UdDwEB/wQEAwIBBjAPBgNV\n"
+    "HRMBAf8EBTADAQH/MB0GA1UdDgQWBBR5tFnme7bl5AFzgAiIyBpY9umbbjANBgkq\n"
+    "hkiG9w0BAQsFAAOCAgEAVR9YqbyyqFDQDLHYGmkgJykIrGF1XIpu+ILlaS/V9lZL\n"
+    "ubhzEFnTIZd+50xx+7LSYK05qAvqFyFWhfFQDlnrzuBZ6brJFe+GnY+EgPbk6ZGQ\n"
+    "3BebYhtF8GaV0nxvwuo77x/Py9auJ/GpsMiu/X1+mvoiBOv/2X/qkSsisRcOj/KK\n"
+    "NFtY2PwByVS5uCbMiogziUwthDyC3+6WVwW6LLv3xLfHTjuCvjHIInNzktHCgKQ5\n"
+    "ORAzI4JMPJ+GslWYHb4phowim57iaztXOoJwTdwJx4nLCgdNbOhdjsnvzqvHu7Ur\n"
+    "TkXWStAmzOVyyghqpZXjFaH3pO3JLF+l+/+sKAIuvtd7u+Nxe5AW0wdeRlN8NwdC\n"
+    "jNPElpzVmbUq4JUagEiuTDkHzsxHpFKVK7q4+63SM1N95R1NbdWhscdCb+ZAJzVc\n"
+    "oyi3B43njTOQ5yOf+1CceWxG1bQVs5ZufpsMljq4Ui0/1lvh+wjChP4kqKOJ2qxq\n"
+    "4RgqsahDYVvTH9w7jXbyLeiNdd8XM2w9U/t7y0Ff/9yi0GE44Za4rF2LN9d11TPA\n"
+    "mRGunUHBcnWEvgJBQl9nJEiU0Zsnvgc/ubhPgXRR4Xq37Z0j4r7g1SgEEzwxA57d\n"
+    "emyPxgcYxn/eR44/KJ4EBs+lVDR3veyJm+kXQ99b21/+jh5Xos1AnX5iItreGCc=\n"
+    "-----END CERTIFICATE-----\n";
+
+struct CaPin {
+  const char* host_suffix;
+  const char* pem;
+};
+
+// The ENTSO-E API URL carries the user's token, so it is only fetched over
+// a verified connection. Build with HANREADER_ENTSOE_CA_PEM set to the root
+// of web-api.tp.entsoe.eu's chain (PEM string literal) to enable it.
+static const CaPin kPins[] = {
+  {"hvakosterstrommen.no", kIsrgRootX1},
+#ifdef HANREADER_ENTSOE_CA_PEM
+  {"entsoe.eu", HANREADER_ENTSOE_CA_PEM},
+#endif
+};
+
+static WiFiClientSecure g_tls;
+static WiFiClient g_plain;
+static WiFiClient* g_client = nullptr;
+static HTTPClient g_http;
+static char g_host[64] = "";
+static uint16_t g_port = 0;
+static HttpsTlsMode g_tls_mode = HTTPS_TLS_NONE;
+static uint32_t g_last_use_ms = 0;
+static HttpsStats g_stats;
+
+// Adapts a body callback to the Stream that HTTPClient::writeToStream wants.
+class BodySink : public Stream {
+ public:
+  BodySink(HttpsBodyFn fn, void* ctx) : fn_(fn), ctx_(ctx) {}
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* data, size_t len) override
+  {
+    const uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < g_stats.min_free_heap || g_stats.min_free_heap == 0) g_stats.min_free_heap = freeHeap;
+    if (fn_) fn_(data, len, ctx_);
+    return len;
+  }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+
+ private:
+  HttpsBodyFn fn_;
+  void* ctx_;
+};
+
+static bool split_url(const char* url, bool& secure, char* host, size_t hostLen, uint16_t& port)
+{
+  secure = strncmp(url, "https://", 8) == 0;
+  if (!secure && strncmp(url, "http://", 7) != 0) return false;
+  const char* h = url + (secure ? 8 : 7);
+  const size_t n = strcspn(h, ":/");
+  if (n == 0 || n >= hostLen) return false;
+  memcpy(host, h, n);
+  host[n] = '\0';
+  port = secure ? 443 : 80;
+  if (h[n] == ':') port = static_cast<uint16_t>(atoi(h + n + 1));
+  return true;
+}
+
+static const char* pinned_ca(const char* host)
+{
+  const size_t hl = strlen(host);
+  for (const CaPin& p : kPins)
+  {
+    const size_t sl = strlen(p.host_suffix);
+    if (hl >= sl && strcmp(host + hl - sl, p.host_suffix) == 0) return p.pem;
+  }
+  return nullptr;
+}
+
+static void close_connection()
+{
+  if (g_client) g_client->stop();
+  g_client = nullptr;
+  g_tls_mode = HTTPS_TLS_NONE;
+  g_host[0] = '\0';
+  g_port = 0;
+}
+
+static bool open_connection(bool secure, const char* host, uint16_t port, bool allowUnverified, HttpsResult& r)
+{
+  close_connection();
+  WiFiClient* client = &g_plain;
+  HttpsTlsMode mode = HTTPS_TLS_PLAIN;
+  if (secure)
+  {
+    const char* ca = (HANREADER_TLS_INSECURE && allowUnverified) ? nullptr : pinned_ca(host);
+    if (ca)
+    {
+      g_tls.setCACert(ca);
+      mode = HTTPS_TLS_VERIFIED;
+    }
+    else if (allowUnverified)
+    {
+      g_tls.setInsecure();
+      mode = HTTPS_TLS_UNVERIFIED;
+    }
+    else
+    {
+      r.tls = HTTPS_TLS_REFUSED;
+      r.code = HTTPS_ERROR_NO_CA;
+      ++g_stats.refused_no_ca;
+      return false;
+    }
+    client = &g_tls;
+  }
+  r.tls = mode;
+
+  const uint32_t heapBefore = ESP.getFreeHeap();
+  const uint32_t t0 = millis();
+  if (!client->connect(host, port)) return false;
+  r.connect_ms = millis() - t0;
+
+  const uint32_t heapAfter = ESP.getFreeHeap();
+  g_stats.tls_heap_bytes = (heapBefore > heapAfter) ? heapBefore - heapAfter : 0;
+  ++g_stats.connects;
+  g_stats.last_connect_ms = r.connect_ms;
+  if (r.connect_ms > g_stats.max_connect_ms) g_stats.max_connect_ms = r.connect_ms;
+  if (mode == HTTPS_TLS_UNVERIFIED) ++g_stats.unverified;
+
+  g_client = client;
+  g_tls_mode = mode;
+  strlcpy(g_host, host, sizeof(g_host));
+  g_port = port;
+  return true;
+}
+
+HttpsResult https_get(const char* url, HttpsBodyFn fn, void* ctx, uint32_t timeoutMs, bool allowUnverified)
+{
+  HttpsResult r;
+  const uint32_t t0 = millis();
+  ++g_stats.requests;
+
+  bool secure = false;
+  char host[64];
+  uint16_t port = 0;
+  if (!split_url(url, secure, host, sizeof(host), port))
+  {
+    r.code = HTTPC_ERROR_CONNECTION_REFUSED;
+    ++g_stats.failures;
+    return r;
+  }
+
+  // An unverified connection is only reused by a request that allows one.
+  const bool sameHost = g_client && g_port == port && strcmp(g_host, host) == 0 &&
+                        (g_client == &g_tls) == secure && g_client->connected() &&
+                        (g_tls_mode != HTTPS_TLS_UNVERIFIED || allowUnverified);
+  if (sameHost)
+  {
+    r.reused = true;
+    ++g_stats.reused;
+  }
+  else if (!open_connection(secure, host, port, allowUnverified, r))
+  {
+    close_connection();
+    if (r.code == 0) r.code = HTTPC_ERROR_CONNECTION_REFUSED;
+    r.total_ms = millis() - t0;
+    ++g_stats.failures;
+    return r;
+  }
+  r.tls = g_tls_mode;
+
+  // HTTPClient finds the socket already open and just sends the request.
+  g_http.setReuse(true);
+  g_http.setTimeout(static_cast<uint16_t>(timeoutMs));
+  if (!g_http.begin(*g_client, url))
+  {
+    close_connection();
+    r.code = HTTPC_ERROR_CONNECTION_REFUSED;
+    ++g_stats.failures;
+    return r;
+  }
+
+  r.code = g_http.GET();
+  if (r.code == 200)
+  {
+    BodySink sink(fn, ctx);
+    r.body_bytes = g_http.writeToStream(&sink);
+  }
+  g_http.end();
+
+  // A failed or cut-short exchange leaves the stream in an unknown state.
+  if (r.code != 200 || r.body_bytes < 0)
+  {
+    close_connection();
+    ++g_stats.failures;
+  }
+  g_last_use_ms = millis();
+  r.total_ms = g_last_use_ms - t0;
+  return r;
+}
+
+bool https_url_pinned(const char* url)
+{
+  bool secure = false;
+  char host[64];
+  uint16_t port = 0;
+  return split_url(url, secure, host, sizeof(host), port) && secure && pinned_ca(host) != nullptr;
+}
+
+const char* https_tls_mode_name(HttpsTlsMode mode)
+{
+  switch (mode)
+  {
+    case HTTPS_TLS_PLAIN: return "plain";
+    case HTTPS_TLS_VERIFIED: return "verified";
+    case HTTPS_TLS_UNVERIFIED: return "unverified";
+    case HTTPS_TLS_REFUSED: return "refused";
+    default: return "none";
+  }
+}
+
+void https_client_idle(uint32_t maxIdleMs)
+{
+  if (g_client && millis() - g_last_use_ms > maxIdleMs) close_connection();
+}
+
+HttpsStats https_client_stats()
+{
+  return g_stats;
+}
+
+String https_client_json()
+{
+  String out = "{";
+  out += "\"requests\":" + String(g_stats.requests) + ",";
+  out += "\"connects\":" + String(g_stats.connects) + ",";
+  out += "\"reused\":" + String(g_stats.reused) + ",";
+  out += "\"failures\":" + String(g_stats.failures) + ",";
+  out += "\"unverified\":" + String(g_stats.unverified) + ",";
+  out += "\"refused_no_ca\":" + String(g_stats.refused_no_ca) + ",";
+  out += "\"insecure_build\":" + String(HANREADER_TLS_INSECURE ? "true" : "false") + ",";
+  out += "\"last_connect_ms\":" + String(g_stats.last_connect_ms) + ",";
+  out += "\"max_connect_ms\":" + String(g_stats.max_connect_ms) + ",";
+  out += "\"tls_heap_bytes\":" + String(g_stats.tls_heap_bytes) + ",";
+  out += "\"min_free_heap\":" + String(g_stats.min_free_heap) + ",";
+  out += "\"open\":" + String(g_client ? "true" : "false") + ",";
+  out += "\"tls\":\"" + String(https_tls_mode_name(g_tls_mode)) + "\"";
+  out += "}";
+  return out;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Shared outbound HTTP(S) client for the fetch worker. One connection is
+// kept open (HTTP/1.1 keep-alive) and reused while requests go to the same
+// host; it is closed after a short idle time to give the TLS buffers back.
+// Hosts with a pinned root CA are verified. Other HTTPS hosts are refused
+// unless the caller allows an unverified connection for that request; the
+// TLS mode of each connection is reported.
+//
+// Not thread-safe: call from one task only.
+
+// Receives the decoded body (no chunk framing) in pieces.
+typedef void (*HttpsBodyFn)(const uint8_t* data, size_t len, void* ctx);
+
+// HTTPS host without a pinned CA, and the request did not allow unverified.
+static const int HTTPS_ERROR_NO_CA = -100;
+
+enum HttpsTlsMode : uint8_t {
+  HTTPS_TLS_NONE = 0,     // no connection yet
+  HTTPS_TLS_PLAIN,        // http://
+  HTTPS_TLS_VERIFIED,     // checked against a pinned CA
+  HTTPS_TLS_UNVERIFIED,   // encrypted, certificate not checked (opt-in)
+  HTTPS_TLS_REFUSED,      // no pinned CA and unverified not allowed
+};
+
+struct HttpsResult {
+  int code = 0;               // HTTP status, or negative HTTPClient error
+  bool reused = false;
+  HttpsTlsMode tls = HTTPS_TLS_NONE;
+  uint32_t connect_ms = 0;    // TCP + TLS handshake; 0 when reused
+  uint32_t total_ms = 0;
+  int32_t body_bytes = 0;     // negative if the body was cut short
+};
+
+struct HttpsStats {
+  uint32_t requests = 0;
+  uint32_t connects = 0;
+  uint32_t reused = 0;
+  uint32_t failures = 0;
+  uint32_t unverified = 0;
+  uint32_t refused_no_ca = 0;
+  uint32_t last_connect_ms = 0;
+  uint32_t max_connect_ms = 0;
+  uint32_t tls_heap_bytes = 0;   // heap taken by the last new connection
+  uint32_t min_free_heap = 0;    // lowest free heap seen during a request
+};
+
+// GET url and stream the body into fn. Returns the HTTP status or a
+// negative error. allowUnverified lets an HTTPS host without a pinned CA
+// connect without certificate checks; never set it for requests that
+// carry a secret.
+HttpsResult https_get(const char* url, HttpsBodyFn fn, void* ctx, uint32_t timeoutMs, bool allowUnverified);
+
+// True if url is https:// to a host with a pinned CA.
+bool https_url_pinned(const char* url);
+
+const char* https_tls_mode_name(HttpsTlsMode mode);
+
+// Closes the kept connection once idle for longer than maxIdleMs.
+void https_client_idle(uint32_t maxIdleMs);
+
+HttpsStats https_client_stats();
+String https_client_json();
@@ -0,0 +1,256 @@
+#include "obis_parser.h"
+
+#include <math.h>
+
+enum : uint8_t {
+  ST_LINE_START = 0,
+  ST_HEADER,
+  ST_CODE,
+  ST_VALUE,
+  ST_SKIP,
+  ST_END,
+};
+
+// CRC-16/ARC, reflected poly 0xA001, as used by DSMR 4/5.
+static const uint16_t kCrcTable[256] = {
+  0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+  0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+  0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+  0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+  0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+  0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+  0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+  0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+  0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+  0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+  0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+  0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+  0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+  0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+  0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+  0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+  0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+  0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+  0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+  0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+  0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+  0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+  0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+  0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+  0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+  0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+  0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+  0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+  0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+  0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+  0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+  0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+};
+
+static const float kPow10Inv[] = {1.0f, 1e-1f, 1e-2f, 1e-3f, 1e-4f, 1e-5f, 1e-6f, 1e-7f, 1e-8f, 1e-9f};
+static const int64_t kMantissaLimit = 100000000000000000LL;
+
+#define OBIS_KEY(c, d, e) ((static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 8) | static_cast<uint32_t>(e))
+
+static ObisEvent field_for_code(const uint8_t g[5])
+{
+  if (g[0] != 1 || g[1] != 0) return OBIS_NONE;
+
+  switch (OBIS_KEY(g[2], g[3], g[4]))
+  {
+    case OBIS_KEY(32, 7, 0): return OBIS_VOLTAGE_L1;
+    case OBIS_KEY(52, 7, 0): return OBIS_VOLTAGE_L2;
+    case OBIS_KEY(72, 7, 0): return OBIS_VOLTAGE_L3;
+    case OBIS_KEY(31, 7, 0): return OBIS_CURRENT_L1;
+    case OBIS_KEY(51, 7, 0): return OBIS_CURRENT_L2;
+    case OBIS_KEY(71, 7, 0): return OBIS_CURRENT_L3;
+    case OBIS_KEY(21, 7, 0): return OBIS_POWER_L1_KW;
+    case OBIS_KEY(41, 7, 0): return OBIS_POWER_L2_KW;
+    case OBIS_KEY(61, 7, 0): return OBIS_POWER_L3_KW;
+    case OBIS_KEY(1, 7, 0): return OBIS_IMPORT_POWER_KW;
+    case OBIS_KEY(2, 7, 0): return OBIS_EXPORT_POWER_KW;
+    case OBIS_KEY(1, 8, 0): return OBIS_IMPORT_ENERGY_KWH;
+    case OBIS_KEY(2, 8, 0): return OBIS_EXPORT_ENERGY_KWH;
+    default: return OBIS_NONE;
+  }
+}
+
+static void begin_code(ObisParser& p, char c)
+{
+  p.state = ST_CODE;
+  p.group = 0;
+  for (int i = 0; i < 5; ++i) p.groups[i] = 0;
+  p.groups[0] = static_cast<uint8_t>(c - '0');
+}
+
+static void begin_value(ObisParser& p)
+{
+  p.state = ST_VALUE;
+  p.negative = false;
+  p.in_fraction = false;
+  p.has_digits = false;
+  p.decimals = 0;
+  p.mantissa = 0;
+}
+
+static int8_t hex_value(char c)
+{
+  if (c >= '0' && c <= '9') return static_cast<int8_t>(c - '0');
+  if (c >= 'A' && c <= 'F') return static_cast<int8_t>(c - 'A' + 10);
+  if (c >= 'a' && c <= 'f') return static_cast<int8_t>(c - 'a' + 10);
+  return -1;
+}
+
+void obis_parser_reset(ObisParser& p)
+{
+  p.state = ST_LINE_START;
+  p.field = OBIS_NONE;
+  p.in_telegram = false;
+  p.telegram_ok = false;
+  p.crc = 0;
+  p.crc_rx = 0;
+  p.crc_digits = 0;
+  p.header_len = 0;
+  p.header[0] = '\0';
+}
+
+ObisEvent obis_parser_feed(ObisParser& p, char c)
+{
+  if (p.state == ST_LINE_START && c == '/')
+  {
+    p.in_telegram = true;
+    p.crc = 0;
+  }
+  if (p.in_telegram && p.state != ST_END)
+  {
+    p.crc = static_cast<uint16_t>((p.crc >> 8) ^ kCrcTable[(p.crc ^ static_cast<uint8_t>(c)) & 0xFF]);
+  }
+
+  if (c == '\r') return OBIS_NONE;
+
+  switch (p.state)
+  {
+    case ST_LINE_START:
+      if (c == '\n' || c == ' ') return OBIS_NONE;
+      if (c == '/')
+      {
+        p.state = ST_HEADER;
+        p.header_len = 0;
+        p.header[p.header_len++] = c;
+      }
+      else if (c == '!')
+      {
+        p.state = ST_END;
+        p.crc_rx = 0;
+        p.crc_digits = 0;
+      }
+      else if (c >= '0' && c <= '9') begin_code(p, c);
+      else p.state = ST_SKIP;
+      return OBIS_NONE;
+
+    case ST_HEADER:
+      if (c == '\n')
+      {
+        while (p.header_len > 0 && p.header[p.header_len - 1] == ' ') --p.header_len;
+        p.header[p.header_len] = '\0';
+        p.state = ST_LINE_START;
+        return OBIS_HEADER;
+      }
+      if (p.header_len < OBIS_HEADER_MAX - 1) p.header[p.header_len++] = c;
+      return OBIS_NONE;
+
+    case ST_CODE:
+      if (c >= '0' && c <= '9')
+      {
+        if (p.group < 5)
+        {
+          const uint16_t v = static_cast<uint16_t>(p.groups[p.group] * 10 + (c - '0'));
+          p.groups[p.group] = (v > 255) ? 255 : static_cast<uint8_t>(v);
+        }
+        return OBIS_NONE;
+      }
+      if (c == '-' || c == ':' || c == '.' || c == '*')
+      {
+        if (p.group < 5) ++p.group;
+        return OBIS_NONE;
+      }
+      if (c == '(' && p.group >= 4)
+      {
+        p.field = field_for_code(p.groups);
+        if (p.field != OBIS_NONE)
+        {
+          begin_value(p);
+          return OBIS_NONE;
+        }
+      }
+      p.state = (c == '\n') ? ST_LINE_START : ST_SKIP;
+      return OBIS_NONE;
+
+    case ST_VALUE:
+      if (c >= '0' && c <= '9')
+      {
+        if (p.mantissa < kMantissaLimit && p.decimals < 9)
+        {
+          p.mantissa = p.mantissa * 10 + (c - '0');
+          if (p.in_fraction) ++p.decimals;
+        }
+        p.has_digits = true;
+        return OBIS_NONE;
+      }
+      if ((c == '.' || c == ',') && !p.in_fraction)
+      {
+        p.in_fraction = true;
+        return OBIS_NONE;
+      }
+      if (c == '-' && !p.has_digits && !p.negative)
+      {
+        p.negative = true;
+        return OBIS_NONE;
+      }
+      if (c == ' ' && !p.has_digits) return OBIS_NONE;
+
+      p.state = (c == '\n') ? ST_LINE_START : ST_SKIP;
+      if ((c == '*' || c == ')') && p.has_digits) return p.field;
+      return OBIS_NONE;
+
+    case ST_END:
+      if (c != '\n')
+      {
+        const int8_t h = hex_value(c);
+        if (h >= 0 && p.crc_digits < 4)
+        {
+          p.crc_rx = static_cast<uint16_t>((p.crc_rx << 4) | h);
+          ++p.crc_digits;
+        }
+        return OBIS_NONE;
+      }
+      p.state = ST_LINE_START;
+      p.telegram_ok = p.in_telegram && (p.crc_digits == 0 || (p.crc_digits == 4 && p.crc_rx == p.crc));
+      p.in_telegram = false;
+      return OBIS_END;
+
+    case ST_SKIP:
+    default:
+      if (c == '\n') p.state = ST_LINE_START;
+      return OBIS_NONE;
+  }
+}
+
+bool obis_parser_telegram_ok(const ObisParser& p)
+{
+  return p.telegram_ok;
+}
+
+float obis_parser_value(const ObisParser& p)
+{
+  float v = static_cast<float>(p.mantissa) * kPow10Inv[p.decimals];
+  return p.negative ? -v : v;
+}
+
+int64_t obis_parser_value_milli(const ObisParser& p)
+{
+  int64_t v = p.mantissa;
+  for (uint8_t d = p.decimals; d < 3; ++d) v *= 10;
+  for (uint8_t d = 3; d < p.decimals; ++d) v /= 10;
+  return p.negative ? -v : v;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+// Byte-at-a-time parser for ASCII DSMR/OBIS telegrams. Works on a fixed
+// buffer only (header line), numbers are parsed in place while streaming.
+
+enum ObisEvent : uint8_t {
+  OBIS_NONE = 0,
+  OBIS_HEADER,
+  OBIS_END,
+
+  OBIS_VOLTAGE_L1,
+  OBIS_VOLTAGE_L2,
+  OBIS_VOLTAGE_L3,
+  OBIS_CURRENT_L1,
+  OBIS_CURRENT_L2,
+  OBIS_CURRENT_L3,
+  OBIS_POWER_L1_KW,
+  OBIS_POWER_L2_KW,
+  OBIS_POWER_L3_KW,
+  OBIS_IMPORT_POWER_KW,
+  OBIS_EXPORT_POWER_KW,
+  OBIS_IMPORT_ENERGY_KWH,
+  OBIS_EXPORT_ENERGY_KWH,
+};
+
+static const uint8_t OBIS_HEADER_MAX = 48;
+
+struct ObisParser {
+  uint8_t state = 0;
+  uint8_t group = 0;
+  uint8_t groups[5] = {0, 0, 0, 0, 0};
+  ObisEvent field = OBIS_NONE;
+
+  bool negative = false;
+  bool in_fraction = false;
+  bool has_digits = false;
+  uint8_t decimals = 0;
+  int64_t mantissa = 0;
+
+  // DSMR CRC16 over '/' .. '!' inclusive, checked against the hex after '!'.
+  bool in_telegram = false;
+  bool telegram_ok = false;
+  uint16_t crc = 0;
+  uint16_t crc_rx = 0;
+  uint8_t crc_digits = 0;
+
+  uint8_t header_len = 0;
+  char header[OBIS_HEADER_MAX] = {0};
+};
+
+void obis_parser_reset(ObisParser& p);
+
+// Feeds one byte. Returns the event completed by this byte, OBIS_NONE otherwise.
+// For value events, read the number with obis_parser_value().
+ObisEvent obis_parser_feed(ObisParser& p, char c);
+
+float obis_parser_value(const ObisParser& p);
+
+// Same value times 1000 without rounding, e.g. a kWh register in Wh.
+int64_t obis_parser_value_milli(const ObisParser& p);
+
+// Valid after OBIS_END: true when the telegram started with a header and the
+// trailing CRC matched (or the meter sends no CRC, as DSMR 2.x does).
+bool obis_parser_telegram_ok(const ObisParser& p);
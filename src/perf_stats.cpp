@@ -0,0 +1,62 @@
+#include "perf_stats.h"
+
+struct PerfEntry {
+  uint32_t calls;
+  uint32_t max_us;
+  uint32_t last_us;
+  uint64_t total_us;
+  uint64_t units;
+};
+
+static const char* const kNames[PERF_PROBE_COUNT] = {
+  "han_parse",
+  "tariff",
+  "price_parse",
+  "status_json",
+  "history_json",
+  "price_plan",
+};
+
+static PerfEntry g_entries[PERF_PROBE_COUNT];
+
+void perf_record(PerfProbe probe, uint32_t elapsed_us, uint32_t units)
+{
+  if (probe >= PERF_PROBE_COUNT) return;
+  PerfEntry& e = g_entries[probe];
+  ++e.calls;
+  e.last_us = elapsed_us;
+  e.total_us += elapsed_us;
+  e.units += units;
+  if (elapsed_us > e.max_us) e.max_us = elapsed_us;
+}
+
+void perf_reset()
+{
+  for (int i = 0; i < PERF_PROBE_COUNT; ++i) g_entries[i] = PerfEntry();
+}
+
+String perf_json()
+{
+  String out;
+  out.reserve(160 * PERF_PROBE_COUNT + 64);
+  out += "{\"ok\":true,\"uptime_ms\":" + String(millis()) + ",\"free_heap\":" + String(ESP.getFreeHeap());
+  out += ",\"min_free_heap\":" + String(ESP.getMinFreeHeap()) + ",\"probes\":{";
+  for (int i = 0; i < PERF_PROBE_COUNT; ++i)
+  {
+    const PerfEntry e = g_entries[i];
+    const float avg = (e.calls > 0) ? static_cast<float>(e.total_us) / static_cast<float>(e.calls) : 0.0f;
+    const float unitsPerSec = (e.total_us > 0) ? static_cast<float>(e.units) * 1e6f / static_cast<float>(e.total_us) : 0.0f;
+
+    if (i > 0) out += ",";
+    out += "\"" + String(kNames[i]) + "\":{";
+    out += "\"calls\":" + String(e.calls) + ",";
+    out += "\"avg_us\":" + String(avg, 1) + ",";
+    out += "\"max_us\":" + String(e.max_us) + ",";
+    out += "\"last_us\":" + String(e.last_us) + ",";
+    out += "\"units\":" + String(static_cast<uint32_t>(e.units)) + ",";
+    out += "\"units_per_s\":" + String(unitsPerSec, 0);
+    out += "}";
+  }
+  out += "}}";
+  return out;
+}
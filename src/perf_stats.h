@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Lightweight timing probes for the hot paths, reported as JSON on
+// /status/perf. Each probe must only be recorded from one task.
+
+enum PerfProbe : uint8_t {
+  PERF_HAN_PARSE = 0, // per ring chunk, units = bytes
+  PERF_TARIFF,
+  PERF_PRICE_PARSE,   // units = payload bytes
+  PERF_STATUS_JSON,   // units = output bytes
+  PERF_HISTORY_JSON,  // units = output bytes
+  PERF_PRICE_PLAN,    // series build + selection, units = slots
+  PERF_PROBE_COUNT
+};
+
+void perf_record(PerfProbe probe, uint32_t elapsed_us, uint32_t units = 0);
+void perf_reset();
+String perf_json();
+
+class PerfScope {
+ public:
+  explicit PerfScope(PerfProbe probe, uint32_t units = 0) : probe_(probe), units_(units), start_(micros()) {}
+  ~PerfScope() { perf_record(probe_, micros() - start_, units_); }
+  void set_units(uint32_t units) { units_ = units; }
+
+ private:
+  PerfProbe probe_;
+  uint32_t units_;
+  uint32_t start_;
+};
@@ -0,0 +1,270 @@
+#include "price_day.h"
+
+// ---- day builder ----
+
+void price_day_begin(PriceDayBuilder& b, PriceDay& day, uint32_t dayStart, const char* zone)
+{
+  day = PriceDay();
+  day.start = dayStart;
+  strlcpy(day.zone, zone, sizeof(day.zone));
+  for (uint8_t i = 0; i < PRICE_SLOTS_MAX; ++i) day.nok_kwh[i] = NAN;
+  b = PriceDayBuilder();
+  b.day = &day;
+}
+
+static bool place(PriceDay& day, uint32_t t, float price)
+{
+  const uint32_t slot = (t - day.start) / day.slot_s;
+  if (slot >= PRICE_SLOTS_MAX) return false;
+  day.nok_kwh[slot] = price;
+  if (slot + 1 > day.count) day.count = static_cast<uint8_t>(slot + 1);
+  return true;
+}
+
+void price_day_add(PriceDayBuilder& b, uint32_t t, float nokKwh)
+{
+  if (b.bad || !b.day) return;
+  PriceDay& day = *b.day;
+  if (t < day.start)
+  {
+    b.bad = true;
+    return;
+  }
+  if (b.entries++ == 0)
+  {
+    b.first = t;
+    b.first_price = nokKwh;
+    return;
+  }
+  if (b.entries == 2)
+  {
+    if (t <= b.first || (t - b.first != 900 && t - b.first != 3600))
+    {
+      b.bad = true;
+      return;
+    }
+    day.slot_s = static_cast<uint16_t>(t - b.first);
+    place(day, b.first, b.first_price);
+  }
+  if (!place(day, t, nokKwh)) b.bad = true;
+}
+
+bool price_day_complete(const PriceDayBuilder& b)
+{
+  // At least 23 hours: the spring DST day.
+  return b.day && !b.bad && static_cast<uint32_t>(b.day->count) * b.day->slot_s >= 23UL * 3600UL;
+}
+
+// ---- time and URL helpers ----
+
+static int64_t days_from_civil(int y, int m, int d)
+{
+  y -= (m <= 2) ? 1 : 0;
+  const int era = (y >= 0 ? y : y - 399) / 400;
+  const int yoe = y - era * 400;
+  const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return static_cast<int64_t>(era) * 146097 + doe - 719468;
+}
+
+static int digits(const char* s, uint8_t n)
+{
+  int v = 0;
+  for (uint8_t i = 0; i < n; ++i)
+  {
+    if (s[i] < '0' || s[i] > '9') return -1;
+    v = v * 10 + (s[i] - '0');
+  }
+  return v;
+}
+
+bool price_iso_to_epoch(const char* s, uint32_t& out)
+{
+  const size_t len = strlen(s);
+  if (len < 17 || s[10] != 'T') return false;
+  const int y = digits(s, 4), mo = digits(s + 5, 2), d = digits(s + 8, 2);
+  const int h = digits(s + 11, 2), mi = digits(s + 14, 2);
+  if (y < 0 || mo < 1 || d < 1 || h < 0 || mi < 0) return false;
+
+  int sec = 0;
+  int32_t offset = 0;
+  const char* z = s + 16;
+  if (*z == ':')
+  {
+    sec = digits(z + 1, 2);
+    if (sec < 0) return false;
+    z += 3;
+  }
+  if (*z == '+' || *z == '-')
+  {
+    const int oh = digits(z + 1, 2), om = digits(z + 4, 2);
+    if (oh < 0 || om < 0) return false;
+    offset = (oh * 3600 + om * 60) * (*z == '-' ? -1 : 1);
+  }
+  else if (*z != 'Z') return false;
+
+  out = static_cast<uint32_t>(days_from_civil(y, mo, d) * 86400LL + h * 3600 + mi * 60 + sec - offset);
+  return true;
+}
+
+static size_t put(char* out, size_t o, size_t len, const char* s)
+{
+  while (*s && o + 1 < len) out[o++] = *s++;
+  return o;
+}
+
+void price_url_expand(const char* tmpl, uint16_t y, uint8_t m, uint8_t d, const char* zone, char* out, size_t len)
+{
+  if (len == 0) return;
+  char ys[6];
+  char ms[4];
+  char ds[4];
+  snprintf(ys, sizeof(ys), "%04u", y);
+  snprintf(ms, sizeof(ms), "%02u", m);
+  snprintf(ds, sizeof(ds), "%02u", d);
+
+  size_t o = 0;
+  const char* p = tmpl;
+  const char* keys[] = {"{Y}", "{M}", "{D}", "{zone}"};
+  const char* values[] = {ys, ms, ds, zone};
+  while (*p && o + 1 < len)
+  {
+    bool replaced = false;
+    for (uint8_t k = 0; k < 4 && !replaced; ++k)
+    {
+      const size_t kl = strlen(keys[k]);
+      if (strncmp(p, keys[k], kl) != 0) continue;
+      o = put(out, o, len, values[k]);
+      p += kl;
+      replaced = true;
+    }
+    if (!replaced) out[o++] = *p++;
+  }
+  out[o] = '\0';
+}
+
+// ---- hvakosterstrommen-style JSON ----
+
+void price_json_day_begin(PriceJsonDay& s, PriceDayBuilder& b)
+{
+  s.parser = PriceJsonParser();
+  s.builder = &b;
+}
+
+void price_json_day_feed(PriceJsonDay& s, const uint8_t* data, size_t len)
+{
+  for (size_t i = 0; i < len; ++i)
+  {
+    if (price_json_feed(s.parser, static_cast<char>(data[i])) != PJSON_ENTRY) continue;
+    uint32_t t = 0;
+    if (price_iso_to_epoch(s.parser.time_start, t)) price_day_add(*s.builder, t, s.parser.nok_per_kwh);
+    else s.builder->bad = true;
+  }
+}
+
+// ---- ENTSO-E Publication_MarketDocument (XML) ----
+
+void entsoe_doc_begin(EntsoeDoc& s, PriceDayBuilder& b, uint32_t dayStart, uint32_t dayEnd, float eurNok)
+{
+  s = EntsoeDoc();
+  s.builder = &b;
+  s.day_start = dayStart;
+  s.day_end = dayEnd;
+  s.nok_per_eur_mwh = eurNok / 1000.0f;
+}
+
+static void entsoe_put(EntsoeDoc& s, int32_t pos, float price)
+{
+  const uint32_t t = s.period_start + static_cast<uint32_t>(pos - 1) * s.res_s;
+  if (t >= s.day_start && t < s.day_end) price_day_add(*s.builder, t, price);
+}
+
+// Curve type A03 leaves out points that repeat the previous price.
+static void entsoe_fill_to(EntsoeDoc& s, int32_t pos)
+{
+  if (isnan(s.last_price)) return;
+  for (int32_t p = s.last_pos + 1; p < pos; ++p) entsoe_put(s, p, s.last_price);
+}
+
+static void entsoe_end_element(EntsoeDoc& s)
+{
+  const char* n = s.name;
+  if (strcmp(n, "Period") == 0)
+  {
+    if (s.in_period && s.res_s == s.accepted_res && s.res_s > 0 && s.period_end > s.period_start)
+    {
+      entsoe_fill_to(s, static_cast<int32_t>((s.period_end - s.period_start) / s.res_s) + 1);
+    }
+    s.in_period = false;
+    return;
+  }
+  if (!s.in_period) return;
+
+  uint32_t t = 0;
+  if (strcmp(n, "start") == 0 && price_iso_to_epoch(s.text, t)) s.period_start = t;
+  else if (strcmp(n, "end") == 0 && price_iso_to_epoch(s.text, t)) s.period_end = t;
+  else if (strcmp(n, "resolution") == 0)
+  {
+    s.res_s = (strcmp(s.text, "PT15M") == 0) ? 900 : (strcmp(s.text, "PT60M") == 0) ? 3600 : 0;
+    if (s.accepted_res == 0) s.accepted_res = s.res_s;
+  }
+  else if (strcmp(n, "position") == 0) s.position = atoi(s.text);
+  else if (strcmp(n, "price.amount") == 0)
+  {
+    if (s.res_s == 0 || s.res_s != s.accepted_res || s.position <= s.last_pos) return;
+    const float price = strtof(s.text, nullptr) * s.nok_per_eur_mwh;
+    entsoe_fill_to(s, s.position);
+    entsoe_put(s, s.position, price);
+    s.last_pos = s.position;
+    s.last_price = price;
+  }
+}
+
+static void entsoe_feed(EntsoeDoc& s, char c)
+{
+  if (!s.in_tag)
+  {
+    if (c == '<')
+    {
+      s.in_tag = true;
+      s.closing = false;
+      s.name_done = false;
+      s.name_len = 0;
+      return;
+    }
+    if (s.text_len < ENTSOE_TEXT_MAX - 1) s.text[s.text_len++] = c;
+    s.text[s.text_len] = '\0';
+    return;
+  }
+
+  if (c == '>')
+  {
+    s.in_tag = false;
+    s.name[s.name_len] = '\0';
+    if (s.closing) entsoe_end_element(s);
+    else if (strcmp(s.name, "Period") == 0)
+    {
+      s.in_period = true;
+      s.period_start = 0;
+      s.period_end = 0;
+      s.res_s = 0;
+      s.last_pos = 0;
+      s.last_price = NAN;
+    }
+    s.text_len = 0;
+    s.text[0] = '\0';
+    return;
+  }
+  if (c == '/' && s.name_len == 0)
+  {
+    s.closing = true;
+    return;
+  }
+  if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '/') s.name_done = true;
+  if (!s.name_done && s.name_len < ENTSOE_NAME_MAX - 1) s.name[s.name_len++] = c;
+}
+
+void entsoe_doc_feed(EntsoeDoc& s, const uint8_t* data, size_t len)
+{
+  for (size_t i = 0; i < len; ++i) entsoe_feed(s, static_cast<char>(data[i]));
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+#include "price_json.h"
+
+// One local day of spot prices and the streaming builders that fill it from
+// provider payloads (hvakosterstrommen-style JSON, ENTSO-E A44 XML). No
+// network or flash here, so recorded documents can be replayed off-device.
+
+static const uint8_t PRICE_SLOTS_MAX = 100;  // 25 h x 4
+
+struct PriceDay {
+  uint32_t start = 0;       // local midnight epoch; 0 = empty
+  uint16_t slot_s = 3600;
+  uint8_t count = 0;
+  uint8_t source = 0;       // PriceProviderId that filled it
+  char zone[4] = "";
+  float nok_kwh[PRICE_SLOTS_MAX];
+};
+
+// Places streamed entries into a day. The slot length is the spacing of
+// the first two entries.
+struct PriceDayBuilder {
+  PriceDay* day = nullptr;
+  uint32_t first = 0;
+  float first_price = NAN;
+  uint16_t entries = 0;
+  bool bad = false;
+};
+
+void price_day_begin(PriceDayBuilder& b, PriceDay& day, uint32_t dayStart, const char* zone);
+void price_day_add(PriceDayBuilder& b, uint32_t t, float nokKwh);
+
+// True when the entries cover a whole day (23 h or more) without errors.
+bool price_day_complete(const PriceDayBuilder& b);
+
+// 2026-02-09T13:00:00+01:00 (hvakosterstrommen) or 2026-02-08T23:00Z (ENTSO-E) -> epoch
+bool price_iso_to_epoch(const char* s, uint32_t& out);
+
+// Copies tmpl into out with {Y} {M} {D} {zone} filled in; cut at len.
+void price_url_expand(const char* tmpl, uint16_t y, uint8_t m, uint8_t d, const char* zone, char* out, size_t len);
+
+// ---- hvakosterstrommen-style JSON ----
+
+struct PriceJsonDay {
+  PriceJsonParser parser;
+  PriceDayBuilder* builder = nullptr;
+};
+
+void price_json_day_begin(PriceJsonDay& s, PriceDayBuilder& b);
+void price_json_day_feed(PriceJsonDay& s, const uint8_t* data, size_t len);
+
+// ---- ENTSO-E Publication_MarketDocument (A44) ----
+//
+// Only Period, timeInterval start/end, resolution, position and
+// price.amount are looked at. Points outside dayStart..dayEnd are dropped;
+// curve type A03 points left out because they repeat the previous price are
+// filled in. A document mixing PT15M and PT60M periods keeps the resolution
+// of the first one.
+
+static const uint8_t ENTSOE_NAME_MAX = 24;
+static const uint8_t ENTSOE_TEXT_MAX = 32;
+
+struct EntsoeDoc {
+  PriceDayBuilder* builder = nullptr;
+  uint32_t day_start = 0;
+  uint32_t day_end = 0;
+  float nok_per_eur_mwh = 0.0f;
+
+  bool in_tag = false;
+  bool closing = false;
+  bool name_done = false;
+  uint8_t name_len = 0;
+  char name[ENTSOE_NAME_MAX];
+  uint8_t text_len = 0;
+  char text[ENTSOE_TEXT_MAX];
+
+  bool in_period = false;
+  uint32_t period_start = 0;
+  uint32_t period_end = 0;
+  uint16_t res_s = 0;
+  uint16_t accepted_res = 0;
+  int32_t position = 0;
+  int32_t last_pos = 0;
+  float last_price = NAN;
+};
+
+void entsoe_doc_begin(EntsoeDoc& s, PriceDayBuilder& b, uint32_t dayStart, uint32_t dayEnd, float eurNok);
+void entsoe_doc_feed(EntsoeDoc& s, const uint8_t* data, size_t len);
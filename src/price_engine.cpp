@@ -1,55 +1,211 @@
 #include "price_engine.h"
+#include "https_client.h"
+#include "price_provider.h"
+#include "price_table.h"
+#include "time_service.h"
 
 #include <WiFi.h>
-#include <HTTPClient.h>
-#include <WiFiClientSecure.h>
-#include <time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
 
-static int cached_day = -1;
-static int cached_hour = -1;
-static String cached_zone = "";
-static float cached_price = NAN;
+#ifndef HANREADER_PRICE_CORE
+#define HANREADER_PRICE_CORE 0
+#endif
 
-static int hour_from_iso(const String& iso)
+// Nord Pool publishes day-ahead prices around 13:00 CET; the API has them
+// shortly after. Each device waits a random extra 0-20 min past 13:15.
+static const uint32_t PREFETCH_OFFSET_S = 13UL * 3600UL + 15UL * 60UL;
+static const uint32_t PREFETCH_JITTER_S = 20UL * 60UL;
+static const uint32_t RETRY_BASE_MS = 60000UL;
+static const uint32_t RETRY_MAX_MS = 30UL * 60UL * 1000UL;
+static const uint32_t IDLE_CLOSE_MS = 20000UL;
+
+// Fetches run on a worker task; the main path posts a request and later
+// drains the response, so it never waits on the network. Connection and
+// handshake stats live in the shared HTTPS client.
+struct PriceRequest {
+  uint32_t day_start = 0;
+  uint32_t day_end = 0;
+  uint16_t year = 0;
+  uint8_t month = 0;
+  uint8_t mday = 0;
+  PriceFetchConfig cfg;
+};
+
+struct PriceResponse {
+  bool ok = false;
+  PriceProviderId provider = PRICE_PROV_COUNT;
+  uint32_t latency_ms = 0;
+  char error[40] = "";
+  PriceDay day;
+};
+
+struct FetchState {
+  uint32_t prefetch_epoch = 0;  // earliest time to ask for tomorrow
+  uint32_t retry_at_ms = 0;
+  bool retry_wait = false;
+  bool in_flight = false;
+  uint8_t failures = 0;         // consecutive
+  uint32_t fetches = 0;
+  uint32_t failed = 0;
+  uint32_t last_latency_ms = 0;
+  uint32_t max_latency_ms = 0;
+  String last_error = "";
+};
+
+static FetchState g_fetch;
+static QueueHandle_t g_requests = nullptr;
+static QueueHandle_t g_responses = nullptr;
+static TaskHandle_t g_worker = nullptr;
+static void (*g_on_update)() = nullptr;
+
+static void plan_prefetch(uint32_t dayStart)
 {
-  // 2026-02-09T13:00:00+01:00
-  const int t = iso.indexOf('T');
-  if (t < 0 || t + 3 >= static_cast<int>(iso.length())) return -1;
-  return iso.substring(t + 1, t + 3).toInt();
+  g_fetch.prefetch_epoch = dayStart + PREFETCH_OFFSET_S + esp_random() % PREFETCH_JITTER_S;
 }
 
-static bool parse_current_hour_price(const String& payload, int currentHour, float& out)
+static void on_day(uint8_t, const TimeNow& now)
 {
-  int pos = 0;
-  while (true)
-  {
-    int ts = payload.indexOf("\"time_start\":\"", pos);
-    if (ts < 0) break;
-    int te = payload.indexOf('"', ts + 14);
-    if (te < 0) break;
+  plan_prefetch(now.day_start);
+}
+
+static void worker_task(void*);
 
-    String iso = payload.substring(ts + 14, te);
-    int h = hour_from_iso(iso);
+void price_engine_begin()
+{
+  price_table_begin();
+  time_service_subscribe(TIME_EV_VALID | TIME_EV_DAY, on_day);
+
+  g_requests = xQueueCreate(1, sizeof(PriceRequest));
+  g_responses = xQueueCreate(1, sizeof(PriceResponse));
+  // mbedTLS needs a deep stack for the handshake.
+  xTaskCreatePinnedToCore(worker_task, "price_fetch", 8192, nullptr, 1, &g_worker, HANREADER_PRICE_CORE);
+}
+
+void price_engine_on_update(void (*fn)())
+{
+  g_on_update = fn;
+}
 
-    int ps = payload.indexOf("\"NOK_per_kWh\":", te);
-    if (ps < 0) break;
-    int pe = payload.indexOf(',', ps);
-    if (pe < 0) pe = payload.indexOf('}', ps);
-    if (pe < 0) break;
+// Local midnight after dayStart; fills the local date of that day.
+static uint32_t next_day_start(uint32_t dayStart, tm& local)
+{
+  time_t t = static_cast<time_t>(dayStart);
+  localtime_r(&t, &local);
+  local.tm_mday += 1;
+  local.tm_hour = 0;
+  local.tm_min = 0;
+  local.tm_sec = 0;
+  local.tm_isdst = -1;
+  return static_cast<uint32_t>(mktime(&local));
+}
 
-    String val = payload.substring(ps + 14, pe);
-    val.trim();
+static void fetch_day(const PriceRequest& req, PriceResponse& res)
+{
+  const uint32_t t0 = millis();
+  res.provider = price_provider_fetch_day(req.cfg, req.day_start, req.day_end, req.year, req.month, req.mday,
+                                          res.day, res.error, sizeof(res.error));
+  res.latency_ms = millis() - t0;
+  res.ok = res.provider != PRICE_PROV_COUNT;
+}
 
-    if (h == currentHour)
+static void worker_task(void*)
+{
+  // Static: a PriceResponse is too big for a comfortable stack frame here.
+  static PriceRequest req;
+  static PriceResponse res;
+  for (;;)
+  {
+    // Wake now and then to drop an idle keep-alive connection.
+    if (xQueueReceive(g_requests, &req, pdMS_TO_TICKS(5000)) != pdTRUE)
     {
-      out = val.toFloat();
-      return true;
+      https_client_idle(IDLE_CLOSE_MS);
+      continue;
     }
+    res = PriceResponse();
+    fetch_day(req, res);
+    xQueueSend(g_responses, &res, portMAX_DELAY);
+    if (g_on_update) g_on_update();
+  }
+}
+
+// Books a finished fetch: table, stats and backoff.
+static void drain_responses()
+{
+  static PriceResponse res;
+  if (!g_responses || xQueueReceive(g_responses, &res, 0) != pdTRUE) return;
+
+  g_fetch.in_flight = false;
+  g_fetch.last_latency_ms = res.latency_ms;
+  if (res.latency_ms > g_fetch.max_latency_ms) g_fetch.max_latency_ms = res.latency_ms;
+
+  if (res.ok)
+  {
+    price_table_store(res.day);
+    g_fetch.failures = 0;
+    g_fetch.retry_wait = false;
+    g_fetch.last_error = "";
+    return;
+  }
+
+  ++g_fetch.failed;
+  g_fetch.last_error = res.error;
+  if (g_fetch.failures < 255) ++g_fetch.failures;
+  const uint8_t shift = (g_fetch.failures > 5) ? 5 : g_fetch.failures - 1;
+  uint32_t wait = RETRY_BASE_MS << shift;
+  if (wait > RETRY_MAX_MS) wait = RETRY_MAX_MS;
+  g_fetch.retry_at_ms = millis() + wait + esp_random() % (wait / 2);
+  g_fetch.retry_wait = true;
+}
+
+static void fetch_config(const DeviceConfig& cfg, PriceFetchConfig& out)
+{
+  strlcpy(out.zone, cfg.price_zone.c_str(), sizeof(out.zone));
+  strlcpy(out.entsoe_token, cfg.price_entsoe_token.c_str(), sizeof(out.entsoe_token));
+  strlcpy(out.custom_url, cfg.price_custom_url.c_str(), sizeof(out.custom_url));
+  out.custom_unverified = cfg.price_custom_unverified;
+  out.eur_nok = cfg.price_eur_nok;
+}
+
+// Today if missing; tomorrow once it is published. Failures back off
+// exponentially with jitter.
+static void maybe_request(const DeviceConfig& cfg, const TimeNow& now)
+{
+  if (!g_requests || g_fetch.in_flight) return;
+  if (WiFi.status() != WL_CONNECTED) return;
+  if (g_fetch.retry_wait && static_cast<int32_t>(millis() - g_fetch.retry_at_ms) < 0) return;
 
-    pos = pe + 1;
+  const char* zone = cfg.price_zone.c_str();
+  tm next;
+  const uint32_t tomorrow = next_day_start(now.day_start, next);
+  uint32_t target = 0;
+  uint32_t end = 0;
+  tm local = now.local;
+  if (!price_table_day(now.day_start, zone))
+  {
+    target = now.day_start;
+    end = tomorrow;
   }
+  else if (static_cast<uint32_t>(now.epoch) >= g_fetch.prefetch_epoch && !price_table_day(tomorrow, zone))
+  {
+    tm after;
+    target = tomorrow;
+    end = next_day_start(tomorrow, after);
+    local = next;
+  }
+  if (target == 0) return;
 
-  return false;
+  static PriceRequest req;
+  req.day_start = target;
+  req.day_end = end;
+  req.year = static_cast<uint16_t>(local.tm_year + 1900);
+  req.month = static_cast<uint8_t>(local.tm_mon + 1);
+  req.mday = static_cast<uint8_t>(local.tm_mday);
+  fetch_config(cfg, req.cfg);
+  if (xQueueSend(g_requests, &req, 0) != pdTRUE) return;
+  g_fetch.in_flight = true;
+  ++g_fetch.fetches;
 }
 
 SpotPriceResult price_engine_get_now(const DeviceConfig& cfg)
@@ -72,74 +228,56 @@ SpotPriceResult price_engine_get_now(const DeviceConfig& cfg)
     return r;
   }
 
-  if (WiFi.status() != WL_CONNECTED)
-  {
-    r.ok = false;
-    r.message = "WiFi disconnected";
-    return r;
-  }
-
-  tm t;
-  if (!getLocalTime(&t, 200))
+  const TimeNow& now = time_now();
+  if (!now.valid)
   {
     r.ok = false;
     r.message = "Time not synced";
     return r;
   }
 
-  if (cached_day == t.tm_mday && cached_hour == t.tm_hour && cached_zone == cfg.price_zone && !isnan(cached_price))
-  {
-    r.ok = true;
-    r.nok_per_kwh = cached_price;
-    r.source = "hvakosterstrommen_cache";
-    r.message = "Cached";
-    return r;
-  }
-
-  char path[128];
-  snprintf(path, sizeof(path), "https://www.hvakosterstrommen.no/api/v1/prices/%04d/%02d-%02d_%s.json",
-           t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, cfg.price_zone.c_str());
+  drain_responses();
+  maybe_request(cfg, now);
 
-  WiFiClientSecure client;
-  client.setInsecure();
-
-  HTTPClient http;
-  if (!http.begin(client, path))
-  {
-    r.ok = false;
-    r.message = "HTTP begin failed";
-    return r;
-  }
-
-  http.setTimeout(7000);
-  const int code = http.GET();
-  if (code != 200)
-  {
-    http.end();
-    r.ok = false;
-    r.message = String("HTTP ") + code;
-    return r;
-  }
-
-  String payload = http.getString();
-  http.end();
-
-  float p = NAN;
-  if (!parse_current_hour_price(payload, t.tm_hour, p))
+  const float p = price_table_at(static_cast<uint32_t>(now.epoch), cfg.price_zone.c_str());
+  if (isnan(p))
   {
     r.ok = false;
-    r.message = "No current-hour price in payload";
+    if (WiFi.status() != WL_CONNECTED) r.message = "WiFi disconnected";
+    else if (g_fetch.in_flight) r.message = "Fetching";
+    else r.message = g_fetch.last_error;
     return r;
   }
 
-  cached_day = t.tm_mday;
-  cached_hour = t.tm_hour;
-  cached_zone = cfg.price_zone;
-  cached_price = p;
-
+  const PriceDay* day = price_table_day(now.day_start, cfg.price_zone.c_str());
   r.ok = true;
   r.nok_per_kwh = p;
-  r.source = "hvakosterstrommen";
-  r.message = "Live";
+  r.source = price_provider_name(static_cast<PriceProviderId>(day ? day->source : static_cast<uint8_t>(PRICE_PROV_COUNT)));
+  r.message = "Table";
   return r;
 }
+
+String price_engine_json(const DeviceConfig& cfg)
+{
+  const TimeNow& now = time_now();
+  String out = "{";
+  out += "\"zone\":\"" + cfg.price_zone + "\",";
+  out += "\"fetches\":" + String(g_fetch.fetches) + ",";
+  out += "\"failed\":" + String(g_fetch.failed) + ",";
+  out += "\"failures\":" + String(g_fetch.failures) + ",";
+  out += "\"in_flight\":" + String(g_fetch.in_flight ? "true" : "false") + ",";
+  out += "\"last_latency_ms\":" + String(g_fetch.last_latency_ms) + ",";
+  out += "\"max_latency_ms\":" + String(g_fetch.max_latency_ms) + ",";
+  out += "\"last_error\":\"" + g_fetch.last_error + "\",";
+  out += "\"prefetch_after\":" + String(g_fetch.prefetch_epoch) + ",";
+  const int32_t retry = g_fetch.retry_wait ? static_cast<int32_t>(g_fetch.retry_at_ms - millis()) : 0;
+  out += "\"retry_in_s\":" + String(retry > 0 ? retry / 1000 : 0) + ",";
+  out += "\"now\":" + String(now.valid ? static_cast<uint32_t>(now.epoch) : 0) + ",";
+  PriceFetchConfig fc;
+  fetch_config(cfg, fc);
+  out += "\"providers\":" + price_provider_json(fc) + ",";
+  out += "\"http\":" + https_client_json() + ",";
+  out += "\"days\":" + price_table_json(cfg.price_zone.c_str());
+  out += "}";
+  return out;
+}
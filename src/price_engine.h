@@ -3,6 +3,9 @@
 #include <Arduino.h>
 #include "config_store.h"
 
+// Spot prices come from a day table (see price_table.h) that is fetched
+// once per day and zone; tomorrow's prices are prefetched in the afternoon.
+
 struct SpotPriceResult {
   bool ok = false;
   float nok_per_kwh = NAN;
@@ -10,4 +13,16 @@ struct SpotPriceResult {
   String message = "NO DATA";
 };
 
+// Loads the persisted table, hooks day changes into the time service and
+// starts the fetch worker.
+void price_engine_begin();
+
+// Called on the worker task when a fetch finished (ok or not); keep it short.
+void price_engine_on_update(void (*fn)());
+
+// Price in force now, from the table. Books finished fetches and queues the
+// next missing day for the worker when the retry timer allows; never blocks.
 SpotPriceResult price_engine_get_now(const DeviceConfig& cfg);
+
+// Price table plus fetch state, for /status/prices.
+String price_engine_json(const DeviceConfig& cfg);
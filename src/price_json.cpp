@@ -0,0 +1,127 @@
+#include "price_json.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Entries are the objects one level inside the top-level array.
+static const uint8_t ENTRY_DEPTH = 2;
+
+void price_json_reset(PriceJsonParser& p)
+{
+  p = PriceJsonParser();
+}
+
+static void append(char* buf, uint8_t& len, uint8_t cap, char c)
+{
+  if (len < cap - 1) buf[len++] = c;
+  buf[len] = '\0';
+}
+
+static void finish_value(PriceJsonParser& p, bool quoted)
+{
+  p.in_scalar = false;
+  if (p.depth != ENTRY_DEPTH) return;
+
+  if (quoted && strcmp(p.key, "time_start") == 0)
+  {
+    memcpy(p.time_start, p.value, p.value_len + 1);
+    p.has_time = true;
+  }
+  else if (!quoted && strcmp(p.key, "NOK_per_kWh") == 0)
+  {
+    char* end = nullptr;
+    p.nok_per_kwh = strtof(p.value, &end);
+    p.has_price = end != p.value;
+  }
+}
+
+PriceJsonEvent price_json_feed(PriceJsonParser& p, char c)
+{
+  ++p.bytes;
+
+  if (p.in_string)
+  {
+    if (p.escape) p.escape = false;
+    else if (c == '\\')
+    {
+      p.escape = true;
+      return PJSON_NONE;
+    }
+    else if (c == '"')
+    {
+      p.in_string = false;
+      if (p.reading_key) p.reading_key = false;
+      else finish_value(p, true);
+      return PJSON_NONE;
+    }
+    if (p.reading_key) append(p.key, p.key_len, PJSON_KEY_MAX, c);
+    else append(p.value, p.value_len, PJSON_VALUE_MAX, c);
+    return PJSON_NONE;
+  }
+
+  switch (c)
+  {
+    case '{':
+      if (++p.depth == ENTRY_DEPTH)
+      {
+        p.has_time = false;
+        p.has_price = false;
+      }
+      p.expect_key = true;
+      return PJSON_NONE;
+
+    case '[':
+      ++p.depth;
+      return PJSON_NONE;
+
+    case '}':
+    {
+      if (p.in_scalar) finish_value(p, false);
+      const bool entry = p.depth == ENTRY_DEPTH && p.has_time && p.has_price;
+      if (p.depth > 0) --p.depth;
+      if (!entry) return PJSON_NONE;
+      ++p.entries;
+      return PJSON_ENTRY;
+    }
+
+    case ']':
+      if (p.in_scalar) finish_value(p, false);
+      if (p.depth > 0) --p.depth;
+      return PJSON_NONE;
+
+    case '"':
+      p.in_string = true;
+      p.escape = false;
+      p.reading_key = p.expect_key;
+      if (p.reading_key) p.key_len = 0;
+      else p.value_len = 0;
+      return PJSON_NONE;
+
+    case ':':
+      p.expect_key = false;
+      return PJSON_NONE;
+
+    case ',':
+      if (p.in_scalar) finish_value(p, false);
+      p.expect_key = true;
+      return PJSON_NONE;
+
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+      if (p.in_scalar) finish_value(p, false);
+      return PJSON_NONE;
+
+    default:
+      // Numbers and literals.
+      if (p.expect_key) return PJSON_NONE;
+      if (!p.in_scalar)
+      {
+        p.in_scalar = true;
+        p.value_len = 0;
+      }
+      append(p.value, p.value_len, PJSON_VALUE_MAX, c);
+      return PJSON_NONE;
+  }
+}
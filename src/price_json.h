@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+// Byte-at-a-time tokenizer for price payloads: an array of flat objects
+// such as {"NOK_per_kWh":0.71,...,"time_start":"2026-02-09T13:00:00+01:00"}.
+// Keys and scalar values of each entry are collected in fixed buffers; the
+// body never needs to be in memory as a whole.
+
+enum PriceJsonEvent : uint8_t {
+  PJSON_NONE = 0,
+  PJSON_ENTRY,   // an entry with both time_start and NOK_per_kWh just closed
+};
+
+static const uint8_t PJSON_KEY_MAX = 16;
+static const uint8_t PJSON_VALUE_MAX = 32;
+
+struct PriceJsonParser {
+  uint8_t depth = 0;
+  bool in_string = false;
+  bool escape = false;
+  bool reading_key = false;
+  bool expect_key = false;
+  bool in_scalar = false;
+
+  uint8_t key_len = 0;
+  char key[PJSON_KEY_MAX] = {0};
+  uint8_t value_len = 0;
+  char value[PJSON_VALUE_MAX] = {0};
+
+  // Current entry.
+  bool has_time = false;
+  bool has_price = false;
+  char time_start[PJSON_VALUE_MAX] = {0};
+  float nok_per_kwh = 0.0f;
+
+  uint32_t bytes = 0;
+  uint16_t entries = 0;
+};
+
+void price_json_reset(PriceJsonParser& p);
+
+// Feeds one byte. On PJSON_ENTRY, read p.time_start and p.nok_per_kwh.
+PriceJsonEvent price_json_feed(PriceJsonParser& p, char c);
@@ -0,0 +1,137 @@
+#include "price_planner.h"
+#include "perf_stats.h"
+#include "price_table.h"
+#include "tariff_engine.h"
+
+#include <algorithm>
+#include <time.h>
+
+static const uint16_t SAMPLE_S = 900;
+
+static uint32_t g_start[PLAN_SLOTS_MAX];
+static float g_total[PLAN_SLOTS_MAX];
+static uint16_t g_order[PLAN_SLOTS_MAX];
+
+// Total price per slot from `from` until the deadline or the end of the
+// table. Hourly slots over a 15-minute table take the average.
+static uint16_t build_series(const DeviceConfig& cfg, float top3Kw, const PlanQuery& q)
+{
+  const char* zone = cfg.price_zone.c_str();
+  const uint8_t samples = static_cast<uint8_t>(q.slot_s / SAMPLE_S);
+  uint32_t t = q.from - (q.from % q.slot_s);
+  uint32_t localHour = 0xFFFFFFFFUL;
+  tm local = {};
+  uint16_t n = 0;
+
+  while (n < PLAN_SLOTS_MAX && (q.deadline == 0 || t + q.slot_s <= q.deadline))
+  {
+    float spot = 0.0f;
+    for (uint8_t i = 0; i < samples; ++i) spot += price_table_at(t + i * SAMPLE_S, zone);
+    if (isnan(spot)) break;
+    spot /= samples;
+
+    // The tariff band only changes on the hour.
+    if (t / 3600UL != localHour)
+    {
+      localHour = t / 3600UL;
+      time_t at = static_cast<time_t>(t);
+      localtime_r(&at, &local);
+    }
+    g_start[n] = t;
+    g_total[n] = tariff_compute(tariff_active(), spot, top3Kw, tariff_rate_index(tariff_active(), local)).total_nok_kwh;
+    ++n;
+    t += q.slot_s;
+  }
+  return n;
+}
+
+static float average(uint16_t first, uint16_t count)
+{
+  float sum = 0.0f;
+  for (uint16_t i = first; i < first + count; ++i) sum += g_total[i];
+  return sum / count;
+}
+
+// Running sum over k slots; the first minimum wins, so ties go to the earliest.
+static uint16_t cheapest_block(uint16_t n, uint16_t k)
+{
+  float sum = 0.0f;
+  for (uint16_t i = 0; i < k; ++i) sum += g_total[i];
+  float best = sum;
+  uint16_t at = 0;
+  for (uint16_t i = k; i < n; ++i)
+  {
+    sum += g_total[i] - g_total[i - k];
+    if (sum < best)
+    {
+      best = sum;
+      at = static_cast<uint16_t>(i - k + 1);
+    }
+  }
+  return at;
+}
+
+// Leaves the k cheapest slot indices first in g_order, in time order.
+static void cheapest_slots(uint16_t n, uint16_t k)
+{
+  for (uint16_t i = 0; i < n; ++i) g_order[i] = i;
+  auto cheaper = [](uint16_t a, uint16_t b) { return g_total[a] < g_total[b] || (g_total[a] == g_total[b] && a < b); };
+  if (k < n) std::nth_element(g_order, g_order + k, g_order + n, cheaper);
+  std::sort(g_order, g_order + k);
+}
+
+static String window_json(uint32_t start, uint32_t end, float avg)
+{
+  return "{\"start\":" + String(start) + ",\"end\":" + String(end) + ",\"avg_nok_kwh\":" + String(avg, 4) + "}";
+}
+
+static String error_json(const char* msg)
+{
+  return String("{\"ok\":false,\"error\":\"") + msg + "\"}";
+}
+
+String price_plan_json(const DeviceConfig& cfg, float top3_hourly_kw, const PlanQuery& q)
+{
+  if (q.slot_s != 900 && q.slot_s != 3600) return error_json("res must be 15m or hour");
+  if (q.slots == 0 || q.slots > PLAN_SLOTS_MAX) return error_json("slots out of range");
+
+  const uint32_t t0 = micros();
+  const uint16_t n = build_series(cfg, top3_hourly_kw, q);
+  if (n < q.slots) return error_json("not enough prices before deadline");
+  const uint16_t k = q.slots;
+  const uint16_t block = cheapest_block(n, k);
+  cheapest_slots(n, k);
+  const uint32_t us = micros() - t0;
+  perf_record(PERF_PRICE_PLAN, us, n);
+
+  String out;
+  out.reserve(400 + 64 * k);
+  out += "{";
+  out += "\"ok\":true,";
+  out += "\"slot_s\":" + String(q.slot_s) + ",";
+  out += "\"slots\":" + String(k) + ",";
+  out += "\"from\":" + String(g_start[0]) + ",";
+  out += "\"until\":" + String(g_start[n - 1] + q.slot_s) + ",";
+  out += "\"available\":" + String(n) + ",";
+  out += "\"now\":" + window_json(g_start[0], g_start[k - 1] + q.slot_s, average(0, k)) + ",";
+  out += "\"block\":" + window_json(g_start[block], g_start[block + k - 1] + q.slot_s, average(block, k)) + ",";
+
+  // Selected slots merged into runs of adjacent ones.
+  float sum = 0.0f;
+  String runs;
+  uint16_t i = 0;
+  while (i < k)
+  {
+    uint16_t j = i;
+    float runSum = g_total[g_order[i]];
+    while (j + 1 < k && g_order[j + 1] == g_order[j] + 1) runSum += g_total[g_order[++j]];
+    if (runs.length() > 0) runs += ",";
+    runs += window_json(g_start[g_order[i]], g_start[g_order[j]] + q.slot_s, runSum / (j - i + 1));
+    sum += runSum;
+    i = j + 1;
+  }
+  out += "\"split\":{\"avg_nok_kwh\":" + String(sum / k, 4) + ",\"runs\":[" + runs + "]},";
+  out += "\"compute_us\":" + String(us);
+  out += "}";
+  return out;
+}
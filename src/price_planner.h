@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config_store.h"
+
+// Cheapest time to run a load from the cached price table. Each slot is
+// priced at the total (spot + grid + taxes) from the tariff engine, then:
+//   block - the cheapest N contiguous slots (sliding-window sum)
+//   split - the cheapest N slots anywhere (top-k selection), as runs
+// Both are linear in the number of slots up to the deadline.
+
+static const uint16_t PLAN_SLOTS_MAX = 2 * 100;  // two days of 15-min slots
+
+struct PlanQuery {
+  uint32_t from = 0;        // epoch; rounded down to the slot it falls in
+  uint32_t deadline = 0;    // load must be done by then; 0 = end of the table
+  uint16_t slot_s = 3600;   // 3600 or 900
+  uint16_t slots = 1;       // how many slots the load needs
+};
+
+String price_plan_json(const DeviceConfig& cfg, float top3_hourly_kw, const PlanQuery& q);
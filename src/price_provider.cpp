@@ -0,0 +1,258 @@
+#include "price_provider.h"
+#include "https_client.h"
+#include "perf_stats.h"
+#include "price_day.h"
+#include "price_provider_health.h"
+
+#include <time.h>
+
+// Build-time override so a local HTTP stand-in can serve (or delay, or
+// fail) the day files: <base>/<YYYY>/<MM>-<DD>_<zone>.json
+#ifndef HANREADER_PRICE_BASE_URL
+#define HANREADER_PRICE_BASE_URL "https://www.hvakosterstrommen.no/api/v1/prices"
+#endif
+
+// A stand-in set at build time is trusted with the token even over http.
+#ifndef HANREADER_ENTSOE_BASE_URL
+#define HANREADER_ENTSOE_BASE_URL "https://web-api.tp.entsoe.eu/api"
+#define ENTSOE_STAND_IN 0
+#else
+#define ENTSOE_STAND_IN 1
+#endif
+
+static const uint32_t FETCH_TIMEOUT_MS = 5000UL;
+
+struct FetchArgs {
+  const PriceFetchConfig* cfg;
+  uint32_t day_start;
+  uint32_t day_end;
+  uint16_t y;
+  uint8_t m;
+  uint8_t d;
+};
+
+// ---- body callbacks (parsers in price_day.cpp) ----
+
+static uint32_t g_parse_us = 0;
+
+static void json_body(const uint8_t* data, size_t len, void* ctx)
+{
+  const uint32_t t0 = micros();
+  price_json_day_feed(*static_cast<PriceJsonDay*>(ctx), data, len);
+  g_parse_us += micros() - t0;
+}
+
+static void entsoe_body(const uint8_t* data, size_t len, void* ctx)
+{
+  const uint32_t t0 = micros();
+  entsoe_doc_feed(*static_cast<EntsoeDoc*>(ctx), data, len);
+  g_parse_us += micros() - t0;
+}
+
+static const char* entsoe_area(const char* zone)
+{
+  if (strcmp(zone, "NO1") == 0) return "10YNO-1--------2";
+  if (strcmp(zone, "NO2") == 0) return "10YNO-2--------T";
+  if (strcmp(zone, "NO3") == 0) return "10YNO-3--------J";
+  if (strcmp(zone, "NO4") == 0) return "10YNO-4--------9";
+  if (strcmp(zone, "NO5") == 0) return "10Y1001A1001A48H";
+  return nullptr;
+}
+
+static void utc_stamp(uint32_t epoch, char out[13])
+{
+  const time_t t = static_cast<time_t>(epoch);
+  tm u;
+  gmtime_r(&t, &u);
+  snprintf(out, 13, "%04d%02d%02d%02d%02d", u.tm_year + 1900, u.tm_mon + 1, u.tm_mday, u.tm_hour, u.tm_min);
+}
+
+// ---- provider table ----
+
+struct PriceProvider {
+  const char* name;
+  bool (*enabled)(const PriceFetchConfig& cfg);
+  bool (*url)(const FetchArgs& a, char* out, size_t len);
+  bool (*unverified_ok)(const PriceFetchConfig& cfg);
+  bool xml;
+  bool secret;   // the URL carries a token: never sent without a pinned CA
+};
+
+static bool never_unverified(const PriceFetchConfig&)
+{
+  return false;
+}
+
+static bool hvakoster_enabled(const PriceFetchConfig&)
+{
+  return true;
+}
+
+static bool hvakoster_url(const FetchArgs& a, char* out, size_t len)
+{
+  snprintf(out, len, "%s/%04u/%02u-%02u_%s.json", HANREADER_PRICE_BASE_URL, a.y, a.m, a.d, a.cfg->zone);
+  return true;
+}
+
+static bool entsoe_enabled(const PriceFetchConfig& cfg)
+{
+  return cfg.entsoe_token[0] != '\0' && cfg.eur_nok > 0.0f;
+}
+
+static bool entsoe_url(const FetchArgs& a, char* out, size_t len)
+{
+  const char* area = entsoe_area(a.cfg->zone);
+  if (!area) return false;
+  char from[13];
+  char to[13];
+  utc_stamp(a.day_start, from);
+  utc_stamp(a.day_end, to);
+  snprintf(out, len, "%s?securityToken=%s&documentType=A44&in_Domain=%s&out_Domain=%s&periodStart=%s&periodEnd=%s",
+           HANREADER_ENTSOE_BASE_URL, a.cfg->entsoe_token, area, area, from, to);
+  return true;
+}
+
+static bool custom_enabled(const PriceFetchConfig& cfg)
+{
+  return cfg.custom_url[0] != '\0';
+}
+
+static bool custom_unverified_ok(const PriceFetchConfig& cfg)
+{
+  return cfg.custom_unverified;
+}
+
+static bool custom_url(const FetchArgs& a, char* out, size_t len)
+{
+  price_url_expand(a.cfg->custom_url, a.y, a.m, a.d, a.cfg->zone, out, len);
+  return true;
+}
+
+static const PriceProvider kProviders[PRICE_PROV_COUNT] = {
+  {"hvakosterstrommen", hvakoster_enabled, hvakoster_url, never_unverified, false, false},
+  {"entsoe", entsoe_enabled, entsoe_url, never_unverified, true, true},
+  {"custom", custom_enabled, custom_url, custom_unverified_ok, false, false},
+};
+
+static PriceProviderStats g_stats[PRICE_PROV_COUNT];
+
+// Checked before the URL (and its token) is built.
+static bool secret_safe(uint8_t id)
+{
+  if (!kProviders[id].secret) return true;
+  if (id == PRICE_PROV_ENTSOE) return ENTSOE_STAND_IN || https_url_pinned(HANREADER_ENTSOE_BASE_URL);
+  return false;
+}
+
+// One attempt against one provider.
+static bool fetch_from(uint8_t id, const FetchArgs& a, PriceDay& out, char* err, size_t errLen)
+{
+  const PriceProvider& p = kProviders[id];
+  static char url[320];
+  if (!p.url(a, url, sizeof(url)))
+  {
+    strlcpy(err, "Zone not supported", errLen);
+    return false;
+  }
+
+  PriceDayBuilder b;
+  price_day_begin(b, out, a.day_start, a.cfg->zone);
+  out.source = id;
+
+  // Parser state is static: both are too large for the worker's stack frame.
+  static PriceJsonDay json;
+  static EntsoeDoc xml;
+  HttpsBodyFn fn = json_body;
+  void* ctx = &json;
+  if (p.xml)
+  {
+    entsoe_doc_begin(xml, b, a.day_start, a.day_end, a.cfg->eur_nok);
+    fn = entsoe_body;
+    ctx = &xml;
+  }
+  else price_json_day_begin(json, b);
+
+  g_parse_us = 0;
+  const HttpsResult r = https_get(url, fn, ctx, FETCH_TIMEOUT_MS, p.unverified_ok(*a.cfg));
+  g_stats[id].tls = r.tls;
+  if (r.body_bytes > 0) perf_record(PERF_PRICE_PARSE, g_parse_us, r.body_bytes);
+
+  if (r.code != 200)
+  {
+    if (r.code == HTTPS_ERROR_NO_CA) strlcpy(err, "No pinned CA for host", errLen);
+    else if (r.code < 0) strlcpy(err, "Connect failed", errLen);
+    else snprintf(err, errLen, "HTTP %d", r.code);
+    price_provider_record(g_stats[id], false, r.total_ms, err);
+    return false;
+  }
+  if (r.body_bytes < 0 || !price_day_complete(b))
+  {
+    strlcpy(err, r.body_bytes < 0 ? "Body truncated" : "Incomplete price day", errLen);
+    price_provider_record(g_stats[id], false, r.total_ms, err);
+    return false;
+  }
+  price_provider_record(g_stats[id], true, r.total_ms, "");
+  return true;
+}
+
+PriceProviderId price_provider_fetch_day(const PriceFetchConfig& cfg, uint32_t dayStart, uint32_t dayEnd,
+                                         uint16_t y, uint8_t m, uint8_t d, PriceDay& out,
+                                         char* err, size_t errLen)
+{
+  FetchArgs a = {&cfg, dayStart, dayEnd, y, m, d};
+
+  uint8_t order[PRICE_PROV_COUNT];
+  uint8_t n = 0;
+  for (uint8_t id = 0; id < PRICE_PROV_COUNT; ++id)
+  {
+    if (!kProviders[id].enabled(cfg)) continue;
+    if (!secret_safe(id))
+    {
+      // Refused, not failed: it must not back off or count against health.
+      g_stats[id].tls = HTTPS_TLS_REFUSED;
+      strlcpy(g_stats[id].last_error, "No pinned CA, token not sent", sizeof(g_stats[id].last_error));
+      continue;
+    }
+    order[n++] = id;
+  }
+  price_provider_sort(g_stats, order, n);
+
+  strlcpy(err, "No price provider enabled", errLen);
+  for (uint8_t i = 0; i < n; ++i)
+  {
+    if (fetch_from(order[i], a, out, err, errLen)) return static_cast<PriceProviderId>(order[i]);
+  }
+  return PRICE_PROV_COUNT;
+}
+
+const char* price_provider_name(PriceProviderId id)
+{
+  return (id < PRICE_PROV_COUNT) ? kProviders[id].name : "none";
+}
+
+PriceProviderStats price_provider_stats(PriceProviderId id)
+{
+  return (id < PRICE_PROV_COUNT) ? g_stats[id] : PriceProviderStats();
+}
+
+String price_provider_json(const PriceFetchConfig& cfg)
+{
+  String out = "[";
+  for (uint8_t id = 0; id < PRICE_PROV_COUNT; ++id)
+  {
+    const PriceProviderStats& s = g_stats[id];
+    if (id > 0) out += ",";
+    out += "{\"name\":\"" + String(kProviders[id].name) + "\",";
+    out += "\"enabled\":" + String(kProviders[id].enabled(cfg) ? "true" : "false") + ",";
+    out += "\"secure_ok\":" + String(secret_safe(id) ? "true" : "false") + ",";
+    out += "\"healthy\":" + String(price_provider_cooling_down(s) ? "false" : "true") + ",";
+    out += "\"ok\":" + String(s.ok) + ",";
+    out += "\"failed\":" + String(s.failed) + ",";
+    out += "\"avg_ms\":" + String(s.avg_ms) + ",";
+    out += "\"tls\":\"" + String(https_tls_mode_name(s.tls)) + "\",";
+    out += "\"last_ms\":" + String(s.last_ms) + ",";
+    out += "\"last_error\":\"" + String(s.last_error) + "\"}";
+  }
+  out += "]";
+  return out;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+#include "https_client.h"
+#include "price_table.h"
+
+// Spot price sources. Every provider turns its own format into the same
+// PriceDay (NOK/kWh excl. VAT, local-midnight slots). Each keeps health and
+// latency stats; a fetch tries enabled providers healthiest and fastest
+// first and fails over to the next one.
+
+enum PriceProviderId : uint8_t {
+  PRICE_PROV_HVAKOSTER = 0,   // hvakosterstrommen.no, NOK
+  PRICE_PROV_ENTSOE,          // ENTSO-E day-ahead (A44), EUR/MWh, needs a token
+  PRICE_PROV_CUSTOM,          // user URL returning hvakosterstrommen-style JSON
+  PRICE_PROV_COUNT,
+};
+
+// What a fetch needs from the config; copied so the worker task owns it.
+struct PriceFetchConfig {
+  char zone[4] = "";
+  char entsoe_token[48] = "";
+  char custom_url[128] = "";   // {Y} {M} {D} {zone} are filled in
+  bool custom_unverified = false;  // https without a pinned CA is opt-in
+  float eur_nok = 11.5f;
+};
+
+struct PriceProviderStats {
+  uint32_t ok = 0;
+  uint32_t failed = 0;
+  uint8_t consecutive_failures = 0;
+  uint32_t last_fail_ms = 0;
+  uint32_t last_ms = 0;
+  uint32_t avg_ms = 0;          // smoothed latency of successful fetches
+  HttpsTlsMode tls = HTTPS_TLS_NONE;  // of the last attempt
+  char last_error[40] = "";
+};
+
+// Fetches one local day (dayStart..dayEnd, local date y-m-d) into out.
+// Returns the provider that delivered, or PRICE_PROV_COUNT if none did
+// (err then holds the last error).
+PriceProviderId price_provider_fetch_day(const PriceFetchConfig& cfg, uint32_t dayStart, uint32_t dayEnd,
+                                         uint16_t y, uint8_t m, uint8_t d, PriceDay& out,
+                                         char* err, size_t errLen);
+
+const char* price_provider_name(PriceProviderId id);
+PriceProviderStats price_provider_stats(PriceProviderId id);
+String price_provider_json(const PriceFetchConfig& cfg);
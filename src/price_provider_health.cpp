@@ -0,0 +1,50 @@
+#include "price_provider_health.h"
+
+static const uint32_t COOLDOWN_MS = 10UL * 60UL * 1000UL;  // after 2 failures in a row
+static const uint32_t UNMEASURED_MS = 60000UL;             // rank before any success
+
+bool price_provider_cooling_down(const PriceProviderStats& s)
+{
+  return s.consecutive_failures >= 2 && millis() - s.last_fail_ms < COOLDOWN_MS;
+}
+
+uint32_t price_provider_rank(const PriceProviderStats& s)
+{
+  uint32_t r = s.avg_ms ? s.avg_ms : UNMEASURED_MS;
+  if (price_provider_cooling_down(s)) r += 0x40000000UL;
+  return r;
+}
+
+void price_provider_record(PriceProviderStats& s, bool ok, uint32_t ms, const char* err)
+{
+  s.last_ms = ms;
+  if (ok)
+  {
+    ++s.ok;
+    s.consecutive_failures = 0;
+    s.avg_ms = s.avg_ms ? (s.avg_ms * 3 + ms) / 4 : ms;
+    s.last_error[0] = '\0';
+    return;
+  }
+  ++s.failed;
+  if (s.consecutive_failures < 255) ++s.consecutive_failures;
+  s.last_fail_ms = millis();
+  strlcpy(s.last_error, err, sizeof(s.last_error));
+}
+
+void price_provider_sort(const PriceProviderStats* stats, uint8_t* ids, uint8_t n)
+{
+  // Insertion sort; three entries at most.
+  for (uint8_t i = 1; i < n; ++i)
+  {
+    const uint8_t id = ids[i];
+    const uint32_t r = price_provider_rank(stats[id]);
+    uint8_t k = i;
+    while (k > 0 && price_provider_rank(stats[ids[k - 1]]) > r)
+    {
+      ids[k] = ids[k - 1];
+      --k;
+    }
+    ids[k] = id;
+  }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Arduino.h>
+#include "price_provider.h"
+
+// Provider health bookkeeping and the failover order built from it. Kept
+// apart from the fetch so the ordering can be checked off-device.
+
+// Two failures in a row put a provider last for ten minutes.
+bool price_provider_cooling_down(const PriceProviderStats& s);
+
+// Lower is tried first: smoothed latency (a fixed guess before the first
+// success), pushed behind every healthy provider while cooling down.
+uint32_t price_provider_rank(const PriceProviderStats& s);
+
+void price_provider_record(PriceProviderStats& s, bool ok, uint32_t ms, const char* err);
+
+// Sorts ids[0..n) by rank of stats[id]; ties keep the given order.
+void price_provider_sort(const PriceProviderStats* stats, uint8_t* ids, uint8_t n);
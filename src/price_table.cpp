@@ -0,0 +1,120 @@
+#include "price_table.h"
+#include "price_provider.h"
+
+#include <LittleFS.h>
+
+static const char* kPath = "/prices.bin";
+static const char* kTmpPath = "/prices.tmp";
+static const uint32_t kMagic = 0x31545250;  // "PRT1"
+
+struct TableFile {
+  uint32_t magic;
+  uint16_t size;
+  PriceDay days[PRICE_DAYS];
+};
+
+static PriceDay g_days[PRICE_DAYS];
+
+static bool zone_is(const PriceDay& d, const char* zone)
+{
+  return strncmp(d.zone, zone, sizeof(d.zone)) == 0;
+}
+
+static void persist()
+{
+  TableFile f;
+  f.magic = kMagic;
+  f.size = sizeof(TableFile);
+  memcpy(f.days, g_days, sizeof(g_days));
+
+  // Write beside and rename, so a reset mid-write keeps the old table.
+  File out = LittleFS.open(kTmpPath, FILE_WRITE);
+  if (!out) return;
+  const size_t n = out.write(reinterpret_cast<const uint8_t*>(&f), sizeof(f));
+  out.close();
+  if (n != sizeof(f)) return;
+  LittleFS.remove(kPath);
+  LittleFS.rename(kTmpPath, kPath);
+}
+
+void price_table_begin()
+{
+  File in = LittleFS.open(kPath, FILE_READ);
+  if (!in) return;
+  TableFile f;
+  const size_t n = in.read(reinterpret_cast<uint8_t*>(&f), sizeof(f));
+  in.close();
+  if (n != sizeof(f) || f.magic != kMagic || f.size != sizeof(TableFile)) return;
+  memcpy(g_days, f.days, sizeof(g_days));
+}
+
+void price_table_store(const PriceDay& day)
+{
+  // Same day first; otherwise the oldest slot, with other zones counting as oldest.
+  uint8_t target = 0;
+  uint32_t oldest = UINT32_MAX;
+  for (uint8_t i = 0; i < PRICE_DAYS; ++i)
+  {
+    const PriceDay& d = g_days[i];
+    if (d.start == day.start && zone_is(d, day.zone))
+    {
+      target = i;
+      break;
+    }
+    const uint32_t age = zone_is(d, day.zone) ? d.start : 0;
+    if (age < oldest)
+    {
+      oldest = age;
+      target = i;
+    }
+  }
+  g_days[target] = day;
+  persist();
+}
+
+const PriceDay* price_table_day(uint32_t dayStart, const char* zone)
+{
+  for (uint8_t i = 0; i < PRICE_DAYS; ++i)
+  {
+    const PriceDay& d = g_days[i];
+    if (d.count > 0 && d.start == dayStart && zone_is(d, zone)) return &d;
+  }
+  return nullptr;
+}
+
+float price_table_at(uint32_t t, const char* zone)
+{
+  for (uint8_t i = 0; i < PRICE_DAYS; ++i)
+  {
+    const PriceDay& d = g_days[i];
+    if (d.count == 0 || t < d.start || !zone_is(d, zone)) continue;
+    const uint32_t slot = (t - d.start) / d.slot_s;
+    if (slot < d.count) return d.nok_kwh[slot];
+  }
+  return NAN;
+}
+
+String price_table_json(const char* zone)
+{
+  String out;
+  out.reserve(PRICE_DAYS * PRICE_SLOTS_MAX * 8 + 128);
+  out += "[";
+  bool first = true;
+  const uint8_t older = (g_days[0].start <= g_days[1].start) ? 0 : 1;
+  for (uint8_t n = 0; n < PRICE_DAYS; ++n)
+  {
+    const PriceDay& d = g_days[n == 0 ? older : 1 - older];
+    if (d.count == 0 || !zone_is(d, zone)) continue;
+    if (!first) out += ",";
+    first = false;
+    out += "{\"start\":" + String(d.start) + ",\"slot_s\":" + String(d.slot_s) + ",\"source\":\"" + price_provider_name(static_cast<PriceProviderId>(d.source)) + "\",\"nok_kwh\":[";
+    for (uint8_t k = 0; k < d.count; ++k)
+    {
+      if (k > 0) out += ",";
+      out += String(d.nok_kwh[k], 4);
+    }
+    out += "]}";
+  }
+  out += "]";
+  return out;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+#include "price_day.h"
+
+// Spot prices for two days (normally today and tomorrow), one fixed array
+// per day. Slots are hourly or 15-minute and counted in real seconds from
+// local midnight, so DST days just have 23/25 (92/100) slots. A lookup is an
+// index computation. The table is kept in LittleFS across reboots.
+
+static const uint8_t PRICE_DAYS = 2;
+
+// Loads the persisted table.
+void price_table_begin();
+
+// Stores a complete day, replacing the same day or the oldest one, and persists.
+void price_table_store(const PriceDay& day);
+
+const PriceDay* price_table_day(uint32_t dayStart, const char* zone);
+
+// Price in force at epoch t, NAN if not in the table.
+float price_table_at(uint32_t t, const char* zone);
+
+String price_table_json(const char* zone);
@@ -0,0 +1,163 @@
+#include "scheduler.h"
+
+#include <esp_pm.h>
+
+struct SchedTask {
+  SchedFn fn = nullptr;
+  uint32_t next_due = 0;
+  volatile uint32_t triggered_ms = 0;  // first trigger since the last run
+  volatile bool pending = false;
+  SchedTaskStats st;
+};
+
+static const uint32_t IDLE_MAX_MS = 20;
+
+static SchedTask g_tasks[SCHED_MAX_TASKS];
+static uint8_t g_count = 0;
+static uint32_t g_idle_ms = 0;
+static uint32_t g_started_ms = 0;
+static bool g_light_sleep = false;
+
+int8_t sched_add(const char* name, SchedFn fn, uint32_t period_ms, uint32_t deadline_ms, uint8_t priority)
+{
+  if (g_count >= SCHED_MAX_TASKS || !fn) return -1;
+  if (g_count == 0) g_started_ms = millis();
+
+  SchedTask& t = g_tasks[g_count];
+  t.fn = fn;
+  t.next_due = millis();
+  t.pending = false;
+  t.st.name = name;
+  t.st.period_ms = period_ms;
+  t.st.deadline_ms = deadline_ms;
+  t.st.priority = priority;
+  return static_cast<int8_t>(g_count++);
+}
+
+void sched_set_period(int8_t id, uint32_t period_ms)
+{
+  if (id < 0 || id >= g_count) return;
+  g_tasks[id].st.period_ms = period_ms;
+  g_tasks[id].next_due = millis() + period_ms;
+}
+
+void sched_trigger(int8_t id)
+{
+  if (id < 0 || id >= SCHED_MAX_TASKS) return;
+  SchedTask& t = g_tasks[id];
+  // A second trigger before the run keeps the first time: latency counts
+  // from the oldest event still waiting.
+  if (t.pending) return;
+  t.triggered_ms = millis();
+  t.pending = true;
+}
+
+static bool is_due(const SchedTask& t, uint32_t now)
+{
+  if (t.pending) return true;
+  return t.st.period_ms > 0 && static_cast<int32_t>(now - t.next_due) >= 0;
+}
+
+static void run_task(SchedTask& t, uint32_t now)
+{
+  // Event-triggered runs are measured from the trigger, periodic ones from
+  // their slot (whichever came first when both are due).
+  uint32_t due = t.next_due;
+  if (t.pending && (t.st.period_ms == 0 || static_cast<int32_t>(t.triggered_ms - t.next_due) < 0)) due = t.triggered_ms;
+  if (static_cast<int32_t>(now - due) < 0) due = now;
+  const uint32_t late = now - due;
+  if (late > t.st.max_late_ms) t.st.max_late_ms = late;
+  if (t.st.deadline_ms > 0 && late > t.st.deadline_ms) ++t.st.misses;
+
+  t.pending = false;
+  if (t.st.period_ms > 0)
+  {
+    t.next_due += t.st.period_ms;
+    // Skip missed slots instead of running back to back.
+    if (static_cast<int32_t>(now - t.next_due) >= 0) t.next_due = now + t.st.period_ms;
+  }
+
+  const uint32_t start = micros();
+  t.fn();
+  const uint32_t us = micros() - start;
+
+  ++t.st.runs;
+  t.st.last_us = us;
+  t.st.total_us += us;
+  if (us > t.st.max_us) t.st.max_us = us;
+}
+
+void sched_run_once()
+{
+  for (;;)
+  {
+    const uint32_t now = millis();
+    int8_t best = -1;
+    for (uint8_t i = 0; i < g_count; ++i)
+    {
+      if (!is_due(g_tasks[i], now)) continue;
+      if (best < 0 || g_tasks[i].st.priority < g_tasks[best].st.priority) best = static_cast<int8_t>(i);
+    }
+    if (best < 0) break;
+    run_task(g_tasks[best], now);
+  }
+
+  const uint32_t now = millis();
+  uint32_t wait = IDLE_MAX_MS;
+  for (uint8_t i = 0; i < g_count; ++i)
+  {
+    const SchedTask& t = g_tasks[i];
+    if (t.pending) return;
+    if (t.st.period_ms == 0) continue;
+    const int32_t left = static_cast<int32_t>(t.next_due - now);
+    if (left <= 0) return;
+    if (static_cast<uint32_t>(left) < wait) wait = static_cast<uint32_t>(left);
+  }
+
+  // vTaskDelay lets the idle task run; with power management configured
+  // that is where frequency scaling and light sleep happen.
+  g_idle_ms += wait;
+  delay(wait);
+}
+
+void sched_configure_power(bool allowLightSleep)
+{
+#if CONFIG_PM_ENABLE
+  esp_pm_config_t pm = {};
+  pm.max_freq_mhz = 240;
+  pm.min_freq_mhz = 80;
+  pm.light_sleep_enable = allowLightSleep;
+  g_light_sleep = (esp_pm_configure(&pm) == ESP_OK) && allowLightSleep;
+#else
+  (void)allowLightSleep;
+  g_light_sleep = false;
+#endif
+}
+
+String sched_json()
+{
+  String out;
+  out.reserve(200 * g_count + 96);
+  const uint32_t upMs = millis() - g_started_ms;
+  out += "{\"ok\":true,\"uptime_ms\":" + String(upMs) + ",\"idle_ms\":" + String(g_idle_ms);
+  out += ",\"light_sleep\":" + String(g_light_sleep ? "true" : "false") + ",\"tasks\":[";
+  for (uint8_t i = 0; i < g_count; ++i)
+  {
+    const SchedTaskStats& s = g_tasks[i].st;
+    const float avg = (s.runs > 0) ? static_cast<float>(s.total_us) / static_cast<float>(s.runs) : 0.0f;
+    if (i > 0) out += ",";
+    out += "{\"name\":\"" + String(s.name) + "\",";
+    out += "\"period_ms\":" + String(s.period_ms) + ",";
+    out += "\"deadline_ms\":" + String(s.deadline_ms) + ",";
+    out += "\"priority\":" + String(s.priority) + ",";
+    out += "\"runs\":" + String(s.runs) + ",";
+    out += "\"misses\":" + String(s.misses) + ",";
+    out += "\"max_late_ms\":" + String(s.max_late_ms) + ",";
+    out += "\"avg_us\":" + String(avg, 1) + ",";
+    out += "\"max_us\":" + String(s.max_us) + ",";
+    out += "\"total_ms\":" + String(static_cast<uint32_t>(s.total_us / 1000ULL));
+    out += "}";
+  }
+  out += "]}";
+  return out;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Cooperative deadline scheduler for loop(). Tasks run to completion; among
+// due tasks the lowest priority number goes first. A period of 0 makes a
+// task event-only (sched_trigger). Lateness beyond the deadline is a miss.
+
+typedef void (*SchedFn)();
+
+static const uint8_t SCHED_MAX_TASKS = 12;
+
+struct SchedTaskStats {
+  const char* name = "";
+  uint32_t period_ms = 0;
+  uint32_t deadline_ms = 0;
+  uint8_t priority = 0;
+  uint32_t runs = 0;
+  uint32_t misses = 0;
+  uint32_t max_late_ms = 0;
+  uint32_t last_us = 0;
+  uint32_t max_us = 0;
+  uint64_t total_us = 0;
+};
+
+int8_t sched_add(const char* name, SchedFn fn, uint32_t period_ms, uint32_t deadline_ms, uint8_t priority);
+void sched_set_period(int8_t id, uint32_t period_ms);
+
+// Safe from other tasks; the target runs on the next pass.
+void sched_trigger(int8_t id);
+
+// Runs every due task once, then idles until the next one is due.
+void sched_run_once();
+
+// Lets idle time drop the CPU clock, and use automatic light sleep when
+// allowed (not while a UART must keep receiving).
+void sched_configure_power(bool allowLightSleep);
+
+String sched_json();
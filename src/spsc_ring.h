@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Lock-free single-producer/single-consumer byte ring. N must be a power of two.
+// The producer only writes head, the consumer only writes tail.
+template <size_t N>
+class SpscRing {
+  static_assert((N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+ public:
+  size_t push(const uint8_t* data, size_t len)
+  {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    const uint32_t tail = tail_.load(std::memory_order_acquire);
+    const size_t space = N - (head - tail);
+    if (len > space) len = space;
+
+    for (size_t i = 0; i < len; ++i) buf_[(head + i) & (N - 1)] = data[i];
+    head_.store(head + static_cast<uint32_t>(len), std::memory_order_release);
+    return len;
+  }
+
+  size_t pop(uint8_t* out, size_t max)
+  {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    const uint32_t head = head_.load(std::memory_order_acquire);
+    size_t avail = head - tail;
+    if (avail > max) avail = max;
+
+    for (size_t i = 0; i < avail; ++i) out[i] = buf_[(tail + i) & (N - 1)];
+    tail_.store(tail + static_cast<uint32_t>(avail), std::memory_order_release);
+    return avail;
+  }
+
+  size_t used() const
+  {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  void clear()
+  {
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+ private:
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  uint8_t buf_[N];
+};
@@ -0,0 +1,72 @@
+#include "tariff_calendar.h"
+
+static const uint16_t kMonthStart[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+static HolidayYear g_years[2];
+
+static bool is_leap(int y)
+{
+  return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+static uint16_t yday_of(int y, int month, int mday)
+{
+  return static_cast<uint16_t>(kMonthStart[month - 1] + (month > 2 && is_leap(y) ? 1 : 0) + mday - 1);
+}
+
+// Anonymous Gregorian algorithm (Meeus/Jones/Butcher).
+uint16_t calendar_easter_yday(int year)
+{
+  const int a = year % 19;
+  const int b = year / 100;
+  const int c = year % 100;
+  const int d = b / 4;
+  const int e = b % 4;
+  const int f = (b + 8) / 25;
+  const int g = (b - f + 1) / 3;
+  const int h = (19 * a + b - d - g + 15) % 30;
+  const int i = c / 4;
+  const int k = c % 4;
+  const int l = (32 + 2 * e + 2 * i - h - k) % 7;
+  const int m = (a + 11 * h + 22 * l) / 451;
+  const int month = (h + l - 7 * m + 114) / 31;
+  const int day = ((h + l - 7 * m + 114) % 31) + 1;
+  return yday_of(year, month, day);
+}
+
+static void mark(HolidayYear& y, int yday)
+{
+  y.bits[yday >> 3] |= static_cast<uint8_t>(1u << (yday & 7));
+}
+
+static void build(HolidayYear& out, int year)
+{
+  out = HolidayYear();
+  out.year = static_cast<int16_t>(year);
+
+  mark(out, yday_of(year, 1, 1));    // nyttarsdag
+  mark(out, yday_of(year, 5, 1));    // arbeidernes dag
+  mark(out, yday_of(year, 5, 17));   // grunnlovsdag
+  mark(out, yday_of(year, 12, 25));  // 1. juledag
+  mark(out, yday_of(year, 12, 26));  // 2. juledag
+
+  // Palmesondag, skjaertorsdag, langfredag, paaskedag, 2. paaskedag,
+  // Kristi himmelfart, pinsedag, 2. pinsedag.
+  static const int8_t kFromEaster[] = {-7, -3, -2, 0, 1, 39, 49, 50};
+  const int easter = calendar_easter_yday(year);
+  for (int8_t off : kFromEaster) mark(out, easter + off);
+}
+
+const HolidayYear& calendar_holidays(int year)
+{
+  HolidayYear& slot = g_years[year & 1];
+  if (slot.year != year) build(slot, year);
+  return slot;
+}
+
+bool calendar_is_holiday(int year, int yday)
+{
+  if (yday < 0 || yday > 365) return false;
+  const HolidayYear& y = calendar_holidays(year);
+  return (y.bits[yday >> 3] >> (yday & 7)) & 1;
+}
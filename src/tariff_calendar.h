@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+// Norwegian public holidays (helligdager). Each year is worked out once into
+// a day-of-year bitmap (the last two years are kept), so a lookup is a bit
+// test. Movable days follow Easter Sunday (Gregorian computus).
+
+struct HolidayYear {
+  int16_t year = -1;
+  uint8_t bits[46] = {0};  // bit n = tm_yday n
+};
+
+// Easter Sunday as day of year, 0-based like tm_yday.
+uint16_t calendar_easter_yday(int year);
+
+// year as tm_year + 1900, yday as tm_yday.
+bool calendar_is_holiday(int year, int yday);
+
+const HolidayYear& calendar_holidays(int year);
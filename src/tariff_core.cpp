@@ -0,0 +1,58 @@
+#include "tariff_core.h"
+#include "tariff_calendar.h"
+
+static const char* const kDayTypeNames[TARIFF_DAY_TYPES] = {"workday", "offday", "winter_workday", "winter_offday"};
+
+TariffDayType tariff_day_type(const CompiledTariff& t, const tm& local)
+{
+  bool offday = local.tm_wday == 0 || local.tm_wday == 6;
+  if (!offday && t.holidays_off) offday = calendar_is_holiday(local.tm_year + 1900, local.tm_yday);
+  const bool winter = (t.winter_months >> local.tm_mon) & 1;
+  if (winter) return offday ? TARIFF_DAY_WINTER_OFF : TARIFF_DAY_WINTER_WORK;
+  return offday ? TARIFF_DAY_OFF : TARIFF_DAY_WORK;
+}
+
+const char* tariff_day_type_name(TariffDayType type)
+{
+  return (type < TARIFF_DAY_TYPES) ? kDayTypeNames[type] : "?";
+}
+
+uint8_t tariff_rate_index(const CompiledTariff& t, const tm& local)
+{
+  return static_cast<uint8_t>(tariff_day_type(t, local) * 24 + local.tm_hour);
+}
+
+// Smallest tier that holds the peak; above the largest tier, the largest.
+int8_t tariff_capacity_tier(const CompiledTariff& t, float top3_hourly_kw)
+{
+  if (t.tier_count == 0) return -1;
+  uint8_t lo = 0;
+  uint8_t hi = t.tier_count;
+  while (lo < hi)
+  {
+    const uint8_t mid = static_cast<uint8_t>((lo + hi) / 2);
+    if (t.tiers[mid].limit_kw < top3_hourly_kw) lo = static_cast<uint8_t>(mid + 1);
+    else hi = mid;
+  }
+  return static_cast<int8_t>(lo < t.tier_count ? lo : t.tier_count - 1);
+}
+
+float tariff_capacity_monthly_nok(const CompiledTariff& t, float top3_hourly_kw)
+{
+  const int8_t i = tariff_capacity_tier(t, top3_hourly_kw);
+  return (i < 0) ? 0.0f : t.tiers[i].monthly_nok;
+}
+
+TariffResult tariff_compute(const CompiledTariff& t, float spot_nok_kwh, float top3_hourly_kw, uint8_t rateIndex)
+{
+  TariffResult result;
+  const float capacity_monthly = tariff_capacity_monthly_nok(t, top3_hourly_kw);
+  const float fixed_share_nok = (capacity_monthly + t.fixed_monthly_nok) / t.expected_monthly_kwh * t.vat_factor;
+  const float grid_total = t.grid_nok_kwh[rateIndex % TARIFF_RATE_SLOTS] + fixed_share_nok;
+
+  result.grid_nok_kwh = grid_total;
+  result.total_nok_kwh = spot_nok_kwh * t.vat_factor + grid_total;
+  result.selected_capacity_kw = top3_hourly_kw;
+  result.selected_capacity_nok_month = capacity_monthly;
+  return result;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+// A grid tariff as lookup tables: one 24-hour rate vector per day type
+// (workday or weekend/holiday, summer or winter) and the capacity tiers
+// sorted by limit. A lookup is a holiday bit test, an array load and a
+// binary search over the tiers, without allocating. No device
+// dependencies; tariff_engine.h builds these from the config.
+
+static const uint8_t TARIFF_TIERS_MAX = 16;
+
+struct TariffTier {
+  float limit_kw;
+  float monthly_nok;
+};
+
+enum TariffDayType : uint8_t {
+  TARIFF_DAY_WORK = 0,
+  TARIFF_DAY_OFF,          // weekend or public holiday
+  TARIFF_DAY_WINTER_WORK,
+  TARIFF_DAY_WINTER_OFF,
+  TARIFF_DAY_TYPES,
+};
+
+static const uint8_t TARIFF_RATE_SLOTS = TARIFF_DAY_TYPES * 24;
+
+struct CompiledTariff {
+  uint8_t tier_count = 0;
+  TariffTier tiers[TARIFF_TIERS_MAX];           // ascending limit_kw
+  float grid_nok_kwh[TARIFF_RATE_SLOTS];         // energy + elavgift + Enova, VAT applied
+  float energy_nok_kwh[TARIFF_RATE_SLOTS];       // energy charge alone, ex VAT
+  float elavgift_nok_kwh = 0.0f;                 // ex VAT
+  float enova_nok_kwh = 0.0f;
+  uint16_t winter_months = 0;                    // bit n = tm_mon n
+  bool holidays_off = true;                      // holidays priced as weekend
+  float vat_factor = 1.0f;
+  float fixed_monthly_nok = 0.0f;
+  float expected_monthly_kwh = 1.0f;
+};
+
+struct TariffResult {
+  float grid_nok_kwh = NAN;
+  float total_nok_kwh = NAN;
+  float selected_capacity_kw = NAN;
+  float selected_capacity_nok_month = NAN;
+};
+
+TariffDayType tariff_day_type(const CompiledTariff& t, const tm& local);
+const char* tariff_day_type_name(TariffDayType type);
+
+// Index into grid_nok_kwh: day type * 24 + local hour.
+uint8_t tariff_rate_index(const CompiledTariff& t, const tm& local);
+
+// Index into tiers for a top-3 average, -1 without tiers.
+int8_t tariff_capacity_tier(const CompiledTariff& t, float top3_hourly_kw);
+float tariff_capacity_monthly_nok(const CompiledTariff& t, float top3_hourly_kw);
+TariffResult tariff_compute(const CompiledTariff& t, float spot_nok_kwh, float top3_hourly_kw, uint8_t rateIndex);
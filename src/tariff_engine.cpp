@@ -1,26 +1,94 @@
 #include "tariff_engine.h"
-#include <math.h>
+#include "perf_stats.h"
 
-static float pick_energy_ore(const DeviceConfig& cfg, bool weekend, int hour)
+struct TariffBand {
+  uint8_t from = 0;
+  uint8_t to = 0;  // exclusive; from > to wraps past midnight
+  float ore = 0.0f;
+};
+
+static CompiledTariff g_active;
+
+static bool in_hours(int hour, int from, int to)
 {
-  if (weekend) return cfg.tariff_energy_weekend_ore;
+  return (from <= to) ? (hour >= from && hour < to) : (hour >= from || hour < to);
+}
+
+static float pick_energy_ore(const DeviceConfig& cfg, bool offday, int hour)
+{
+  if (offday) return cfg.tariff_energy_weekend_ore;
   if (hour >= cfg.tariff_day_start_hour && hour < cfg.tariff_day_end_hour) return cfg.tariff_energy_day_ore;
   return cfg.tariff_energy_night_ore;
 }
 
-float tariff_select_capacity_monthly_nok(const DeviceConfig& cfg, float top3_hourly_kw)
+// "07-11:52,17-21:52" -> workday bands that override the day/night price.
+static uint8_t parse_bands(const String& text, TariffBand* out)
 {
-  String tiers = cfg.tariff_capacity_tiers;
-  tiers.trim();
-  if (tiers.length() == 0) return 0.0f;
+  uint8_t n = 0;
+  int start = 0;
+  while (start < static_cast<int>(text.length()) && n < TARIFF_BANDS_MAX)
+  {
+    int comma = text.indexOf(',', start);
+    if (comma < 0) comma = text.length();
+    String token = text.substring(start, comma);
+    token.trim();
 
-  float selected = 0.0f;
-  float smallestMatchingLimit = INFINITY;
-  float fallbackLargestLimit = -1.0f;
-  float fallbackLargestMonthly = 0.0f;
+    const int dash = token.indexOf('-');
+    const int colon = token.indexOf(':');
+    if (dash > 0 && colon > dash)
+    {
+      const long from = token.substring(0, dash).toInt();
+      const long to = token.substring(dash + 1, colon).toInt();
+      if (from >= 0 && from < 24 && to >= 0 && to <= 24 && from != to)
+      {
+        out[n].from = static_cast<uint8_t>(from);
+        out[n].to = static_cast<uint8_t>(to % 24);
+        out[n].ore = token.substring(colon + 1).toFloat();
+        ++n;
+      }
+    }
+    start = comma + 1;
+  }
+  return n;
+}
 
+// "1-3,11-12" -> bit per month (bit 0 = January).
+static uint16_t parse_months(const String& text)
+{
+  uint16_t mask = 0;
   int start = 0;
-  while (start < tiers.length())
+  while (start < static_cast<int>(text.length()))
+  {
+    int comma = text.indexOf(',', start);
+    if (comma < 0) comma = text.length();
+    String token = text.substring(start, comma);
+    token.trim();
+
+    const int dash = token.indexOf('-');
+    const long from = (dash > 0 ? token.substring(0, dash) : token).toInt();
+    const long to = (dash > 0) ? token.substring(dash + 1).toInt() : from;
+    if (from >= 1 && from <= 12 && to >= 1 && to <= 12)
+    {
+      for (long m = from;; m = m % 12 + 1)
+      {
+        mask |= static_cast<uint16_t>(1u << (m - 1));
+        if (m == to) break;
+      }
+    }
+    start = comma + 1;
+  }
+  return mask;
+}
+
+// "2:219,5:299,..." -> tiers sorted by limit. Runs on config changes only.
+static void compile_tiers(const String& text, CompiledTariff& out)
+{
+  String tiers = text;
+  tiers.trim();
+  out.tier_count = 0;
+
+  int start = 0;
+  while (start < static_cast<int>(tiers.length()) && out.tier_count < TARIFF_TIERS_MAX)
   {
     int comma = tiers.indexOf(',', start);
     if (comma < 0) comma = tiers.length();
@@ -30,58 +98,68 @@ float tariff_select_capacity_monthly_nok(const DeviceConfig& cfg, float top3_hou
     int colon = token.indexOf(':');
     if (colon > 0)
     {
-      float limit = token.substring(0, colon).toFloat();
-      float monthly = token.substring(colon + 1).toFloat();
-      if (limit > fallbackLargestLimit)
-      {
-        fallbackLargestLimit = limit;
-        fallbackLargestMonthly = monthly;
-      }
-      if (top3_hourly_kw <= limit && limit < smallestMatchingLimit)
+      TariffTier t;
+      t.limit_kw = token.substring(0, colon).toFloat();
+      t.monthly_nok = token.substring(colon + 1).toFloat();
+      uint8_t i = out.tier_count++;
+      while (i > 0 && out.tiers[i - 1].limit_kw > t.limit_kw)
       {
-        smallestMatchingLimit = limit;
-        selected = monthly;
+        out.tiers[i] = out.tiers[i - 1];
+        --i;
       }
+      out.tiers[i] = t;
     }
 
     start = comma + 1;
   }
-
-  if (isinf(smallestMatchingLimit)) return fallbackLargestMonthly;
-  return selected;
 }
 
-TariffResult tariff_compute_now(const DeviceConfig& cfg,
-                                float spot_nok_kwh,
-                                float top3_hourly_kw,
-                                bool isWeekend,
-                                int hourLocal)
+void tariff_compile(const DeviceConfig& cfg, CompiledTariff& out)
 {
-  TariffResult result;
-
-  float energy_ore = pick_energy_ore(cfg, isWeekend, hourLocal);
-  float variable_grid_nok = (energy_ore + cfg.tariff_elavgift_ore + cfg.tariff_enova_ore) / 100.0f;
-
-  float capacity_monthly = tariff_select_capacity_monthly_nok(cfg, top3_hourly_kw);
-  float fixed_monthly = cfg.tariff_fixed_monthly_nok;
+  compile_tiers(cfg.tariff_capacity_tiers, out);
+  out.vat_factor = cfg.tariff_include_vat ? 1.0f + (cfg.tariff_vat_percent / 100.0f) : 1.0f;
+  out.fixed_monthly_nok = cfg.tariff_fixed_monthly_nok;
+  out.expected_monthly_kwh = (cfg.tariff_expected_monthly_kwh < 1.0f) ? 1.0f : cfg.tariff_expected_monthly_kwh;
 
-  float expected_monthly_kwh = cfg.tariff_expected_monthly_kwh;
-  if (expected_monthly_kwh < 1.0f) expected_monthly_kwh = 1.0f;
+  out.elavgift_nok_kwh = cfg.tariff_elavgift_ore / 100.0f;
+  out.enova_nok_kwh = cfg.tariff_enova_ore / 100.0f;
+  out.winter_months = parse_months(cfg.tariff_winter_months);
+  out.holidays_off = cfg.tariff_holidays_off;
 
-  float fixed_share_nok = (capacity_monthly + fixed_monthly) / expected_monthly_kwh;
-  float grid_total = variable_grid_nok + fixed_share_nok;
-  float total = spot_nok_kwh + grid_total;
+  TariffBand bands[TARIFF_BANDS_MAX];
+  const uint8_t bandCount = parse_bands(cfg.tariff_bands, bands);
 
-  if (cfg.tariff_include_vat)
+  for (uint8_t type = 0; type < TARIFF_DAY_TYPES; ++type)
   {
-    float vatFactor = 1.0f + (cfg.tariff_vat_percent / 100.0f);
-    grid_total *= vatFactor;
-    total *= vatFactor;
+    const bool offday = type == TARIFF_DAY_OFF || type == TARIFF_DAY_WINTER_OFF;
+    const bool winter = type >= TARIFF_DAY_WINTER_WORK;
+    for (uint8_t h = 0; h < 24; ++h)
+    {
+      float ore = pick_energy_ore(cfg, offday, h);
+      for (uint8_t b = 0; b < bandCount && !offday; ++b)
+      {
+        if (in_hours(h, bands[b].from, bands[b].to)) ore = bands[b].ore;
+      }
+      if (winter) ore += cfg.tariff_winter_extra_ore;
+      out.energy_nok_kwh[type * 24 + h] = ore / 100.0f;
+      ore += cfg.tariff_elavgift_ore + cfg.tariff_enova_ore;
+      out.grid_nok_kwh[type * 24 + h] = ore / 100.0f * out.vat_factor;
+    }
   }
+}
+
+void tariff_engine_configure(const DeviceConfig& cfg)
+{
+  tariff_compile(cfg, g_active);
+}
+
+const CompiledTariff& tariff_active()
+{
+  return g_active;
+}
 
-  result.grid_nok_kwh = grid_total;
-  result.total_nok_kwh = total;
-  result.selected_capacity_kw = top3_hourly_kw;
-  result.selected_capacity_nok_month = capacity_monthly;
-  return result;
+TariffResult tariff_compute_now(float spot_nok_kwh, float top3_hourly_kw, const tm& local)
+{
+  PerfScope perf(PERF_TARIFF);
+  return tariff_compute(g_active, spot_nok_kwh, top3_hourly_kw, tariff_rate_index(g_active, local));
 }
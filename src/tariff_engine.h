@@ -2,17 +2,17 @@
 
 #include <Arduino.h>
 #include "config_store.h"
+#include "tariff_core.h"
 
-struct TariffResult {
-  float grid_nok_kwh = NAN;
-  float total_nok_kwh = NAN;
-  float selected_capacity_kw = NAN;
-  float selected_capacity_nok_month = NAN;
-};
+// The tariff is compiled from the config once (on boot and on save): the
+// capacity tiers are parsed and sorted, and the variable grid price with
+// VAT is laid out per day type (tariff_core.h).
 
-float tariff_select_capacity_monthly_nok(const DeviceConfig& cfg, float top3_hourly_kw);
-TariffResult tariff_compute_now(const DeviceConfig& cfg,
-                                float spot_nok_kwh,
-                                float top3_hourly_kw,
-                                bool isWeekend,
-                                int hourLocal);
+static const uint8_t TARIFF_BANDS_MAX = 6;
+
+void tariff_compile(const DeviceConfig& cfg, CompiledTariff& out);
+
+// The tariff of the running config; rebuilt by tariff_engine_configure().
+void tariff_engine_configure(const DeviceConfig& cfg);
+const CompiledTariff& tariff_active();
+TariffResult tariff_compute_now(float spot_nok_kwh, float top3_hourly_kw, const tm& local);
@@ -0,0 +1,132 @@
+#include "tariff_sim.h"
+#include "tariff_calendar.h"
+
+static void close_hour(SimLoad& load)
+{
+  if (load.hour_start != 0) capacity_peaks_add_hour(load.peaks, load.hour_kwh);
+  load.hour_kwh = 0.0f;
+}
+
+static void close_day(SimLoad& load)
+{
+  if (load.day_key >= 0) capacity_peaks_close_day(load.peaks);
+}
+
+static uint8_t days_in_month(int year, int mon)
+{
+  static const uint8_t kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  return static_cast<uint8_t>(kDays[mon] + (mon == 1 && leap ? 1 : 0));
+}
+
+// Only the first month can start late and only the last can end early;
+// the ones in between are charged in full.
+static void close_month(SimLoad& load, bool last)
+{
+  if (load.month_key < 0 || load.months >= SIM_MONTHS_MAX) return;
+  const float from = (load.months == 0) ? load.month_from_day : 0.0f;
+  const float to = last ? load.month_to_day : load.month_days;
+  float share = (to - from) / load.month_days;
+  if (share > 1.0f) share = 1.0f;
+  load.month_share[load.months] = (share > 0.0f) ? share : 0.0f;
+  load.month_peak_kw[load.months++] = capacity_peaks_mean_kw(load.peaks);
+  capacity_peaks_reset(load.peaks);
+}
+
+void sim_load_init(SimLoad& load, float* kwh, uint8_t* hour, uint8_t* cal, uint16_t capacity, uint16_t slotSeconds)
+{
+  load = SimLoad();
+  load.slot_s = slotSeconds;
+  load.kwh = kwh;
+  load.hour = hour;
+  load.cal = cal;
+  load.capacity = capacity;
+}
+
+bool sim_load_add(SimLoad& load, uint32_t start, float kwh, const tm& local)
+{
+  if (load.count >= load.capacity) return false;
+
+  // The hour closes into the day it belongs to, before the day rolls over.
+  const uint32_t hourStart = start - (start % 3600UL);
+  if (hourStart != load.hour_start)
+  {
+    close_hour(load);
+    load.hour_start = hourStart;
+  }
+  const int32_t dayKey = local.tm_year * 400 + local.tm_yday;
+  if (dayKey != load.day_key)
+  {
+    close_day(load);
+    load.day_key = dayKey;
+  }
+  const float day = (local.tm_mday - 1) + (local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec) / 86400.0f;
+  const int32_t monthKey = local.tm_year * 12 + local.tm_mon;
+  if (monthKey != load.month_key)
+  {
+    close_month(load, false);
+    load.month_key = monthKey;
+    load.month_days = days_in_month(local.tm_year + 1900, local.tm_mon);
+    load.month_from_day = day;
+  }
+  load.month_to_day = day + load.slot_s / 86400.0f;
+
+  const bool weekend = local.tm_wday == 0 || local.tm_wday == 6;
+  const bool holiday = calendar_is_holiday(local.tm_year + 1900, local.tm_yday);
+  load.hour_kwh += kwh;
+  load.kwh[load.count] = kwh;
+  load.hour[load.count] = static_cast<uint8_t>(local.tm_hour);
+  load.cal[load.count] = static_cast<uint8_t>((weekend ? 1 : 0) | (holiday ? 2 : 0) | (local.tm_mon << 4));
+  ++load.count;
+  return true;
+}
+
+void sim_load_finish(SimLoad& load)
+{
+  close_hour(load);
+  close_day(load);
+  close_month(load, true);
+  load.hour_start = 0;
+  load.day_key = -1;
+  load.month_key = -1;
+}
+
+SimResult tariff_sim_run(const SimLoad& load, const CompiledTariff& t)
+{
+  // Calendar byte -> first rate slot of its day type, for this tariff.
+  uint8_t base[256];
+  for (uint16_t c = 0; c < 256; ++c)
+  {
+    const uint8_t month = static_cast<uint8_t>(c >> 4);
+    const bool offday = (c & 1) || ((c & 2) && t.holidays_off);
+    const bool winter = month < 12 && ((t.winter_months >> month) & 1);
+    const uint8_t type = static_cast<uint8_t>((winter ? TARIFF_DAY_WINTER_WORK : TARIFF_DAY_WORK) + (offday ? 1 : 0));
+    base[c] = static_cast<uint8_t>(type * 24);
+  }
+
+  SimResult r;
+  float kwh = 0.0f;
+  float energy = 0.0f;
+  const float* grid = t.grid_nok_kwh;
+  for (uint16_t i = 0; i < load.count; ++i)
+  {
+    kwh += load.kwh[i];
+    energy += load.kwh[i] * grid[base[load.cal[i]] + load.hour[i]];
+  }
+
+  float capacity = 0.0f;
+  float months = 0.0f;
+  for (uint8_t m = 0; m < load.months; ++m)
+  {
+    capacity += tariff_capacity_monthly_nok(t, load.month_peak_kw[m]) * load.month_share[m];
+    months += load.month_share[m];
+  }
+
+  r.kwh = kwh;
+  r.energy_nok = energy;
+  r.capacity_nok = capacity * t.vat_factor;
+  r.fixed_nok = t.fixed_monthly_nok * months * t.vat_factor;
+  r.months = months;
+  r.total_nok = r.energy_nok + r.capacity_nok + r.fixed_nok;
+  return r;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include "capacity_peaks.h"
+#include "tariff_core.h"
+
+// What-if replay of recorded consumption against other tariffs. The load is
+// kept as parallel arrays (struct of arrays): energy, local hour and a
+// calendar byte per interval, so a replay is one branch-free pass per
+// tariff with a table lookup per interval. Monthly capacity peaks (the
+// same basis as the live tariff, capacity_peaks.h) do not depend on the
+// tariff and are worked out once while loading.
+//
+// Spot is the same under every grid tariff, so results are grid cost only:
+// energy charge, elavgift, Enova, capacity and fixed fee, each with VAT when
+// the tariff includes it.
+//
+// No device dependencies: tariff_sim_report.h feeds it from the history
+// store, and the host tests and benchmarks drive it directly.
+
+static const uint16_t SIM_SLOTS_MAX = 368 * 24;  // a year of hours or 92 days of quarters
+static const uint8_t SIM_MONTHS_MAX = 14;
+
+// Calendar byte: bit 0 weekend, bit 1 public holiday, bits 4-7 month (0-11).
+struct SimLoad {
+  uint16_t capacity = 0;
+  uint16_t count = 0;
+  float* kwh = nullptr;
+  uint8_t* hour = nullptr;
+  uint8_t* cal = nullptr;
+
+  uint8_t months = 0;
+  float month_peak_kw[SIM_MONTHS_MAX] = {0.0f};  // capacity basis per month
+  float month_share[SIM_MONTHS_MAX] = {0.0f};    // part of the month covered, 0..1
+  uint16_t slot_s = 3600;
+
+  // Running state while loading.
+  uint32_t hour_start = 0;
+  float hour_kwh = 0.0f;
+  int32_t day_key = -1;
+  int32_t month_key = -1;
+  uint8_t month_days = 0;
+  float month_from_day = 0.0f;   // first covered day of the open month (0-based, fractional)
+  float month_to_day = 0.0f;     // end of the last slot in it
+  CapacityPeaks peaks;
+};
+
+struct SimResult {
+  float kwh = 0.0f;
+  float energy_nok = 0.0f;    // energy charge + elavgift + Enova
+  float capacity_nok = 0.0f;
+  float fixed_nok = 0.0f;
+  float total_nok = 0.0f;
+  float months = 0.0f;        // months charged, partial ones pro rata
+};
+
+// Points the load at caller-owned arrays of `capacity` entries each;
+// slotSeconds is the length of one interval (3600 or 900).
+void sim_load_init(SimLoad& load, float* kwh, uint8_t* hour, uint8_t* cal, uint16_t capacity, uint16_t slotSeconds);
+
+// Appends one interval (oldest first). Returns false when the arrays are full.
+bool sim_load_add(SimLoad& load, uint32_t start, float kwh, const tm& local);
+
+// Closes the last hour, day and month. The first and last month are only
+// charged capacity and fixed fee for the part of them the load covers.
+void sim_load_finish(SimLoad& load);
+
+SimResult tariff_sim_run(const SimLoad& load, const CompiledTariff& t);
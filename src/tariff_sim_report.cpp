@@ -0,0 +1,117 @@
+#include "tariff_sim_report.h"
+#include "tariff_engine.h"
+#include "tariff_sim.h"
+
+#include <time.h>
+
+static bool load_record(const HistRecord& r, void* ctx)
+{
+  SimLoad& load = *static_cast<SimLoad*>(ctx);
+  time_t at = static_cast<time_t>(r.start);
+  tm local;
+  localtime_r(&at, &local);
+  return sim_load_add(load, r.start, r.energy_dwh / 10000.0f, local);
+}
+
+static String result_json(const char* name, const SimResult& r)
+{
+  String out = "{";
+  out += "\"tariff\":\"" + String(name) + "\",";
+  out += "\"total_nok\":" + String(r.total_nok, 2) + ",";
+  out += "\"energy_nok\":" + String(r.energy_nok, 2) + ",";
+  out += "\"capacity_nok\":" + String(r.capacity_nok, 2) + ",";
+  out += "\"fixed_nok\":" + String(r.fixed_nok, 2);
+  out += "}";
+  return out;
+}
+
+String tariff_sim_json(const DeviceConfig& cfg, HistTier tier, uint32_t from, uint32_t to, const String& altTiers)
+{
+  float* kwh = static_cast<float*>(malloc(SIM_SLOTS_MAX * sizeof(float)));
+  uint8_t* hour = static_cast<uint8_t*>(malloc(SIM_SLOTS_MAX));
+  uint8_t* cal = static_cast<uint8_t*>(malloc(SIM_SLOTS_MAX));
+  if (!kwh || !hour || !cal)
+  {
+    free(kwh);
+    free(hour);
+    free(cal);
+    return "{\"ok\":false,\"error\":\"out of memory\"}";
+  }
+
+  const uint32_t t0 = millis();
+  SimLoad load;
+  sim_load_init(load, kwh, hour, cal, SIM_SLOTS_MAX, tier == HIST_QUARTER ? 900 : 3600);
+  history_store_query(tier, from, to, load_record, &load);
+  sim_load_finish(load);
+  const uint32_t loadMs = millis() - t0;
+
+  static CompiledTariff compiled;
+  static const char* const kProfiles[] = {"ELVIA_EXAMPLE", "BKK_EXAMPLE", "TENSIO_EXAMPLE"};
+  String results;
+  float best = INFINITY;
+  String bestName;
+  uint32_t simUs = 0;
+  float totalKwh = 0.0f;
+  float chargedMonths = 0.0f;
+
+  auto run = [&](const DeviceConfig& variant, const String& name) {
+    tariff_compile(variant, compiled);
+    const uint32_t s0 = micros();
+    const SimResult r = tariff_sim_run(load, compiled);
+    simUs += micros() - s0;
+    totalKwh = r.kwh;
+    chargedMonths = r.months;
+    if (results.length() > 0) results += ",";
+    results += result_json(name.c_str(), r);
+    if (r.total_nok < best)
+    {
+      best = r.total_nok;
+      bestName = name;
+    }
+  };
+
+  // The running config under its own profile name (CUSTOM unless a preset).
+  run(cfg, cfg.tariff_profile);
+  DeviceConfig variant = cfg;
+  for (const char* p : kProfiles)
+  {
+    if (cfg.tariff_profile == p) continue;
+    variant = cfg;
+    variant.tariff_profile = p;
+    config_apply_tariff_profile(variant, true);
+    run(variant, p);
+  }
+  int start = 0;
+  while (start < static_cast<int>(altTiers.length()))
+  {
+    int bar = altTiers.indexOf('|', start);
+    if (bar < 0) bar = altTiers.length();
+    variant = cfg;
+    variant.tariff_capacity_tiers = altTiers.substring(start, bar);
+    run(variant, "TIERS:" + variant.tariff_capacity_tiers);
+    start = bar + 1;
+  }
+
+  String out;
+  out.reserve(320 + results.length());
+  out += "{";
+  out += "\"ok\":true,";
+  out += "\"res\":\"" + String(history_tier_name(tier)) + "\",";
+  out += "\"from\":" + String(from) + ",";
+  out += "\"to\":" + String(to) + ",";
+  out += "\"slots\":" + String(load.count) + ",";
+  out += "\"truncated\":" + String(load.count >= load.capacity ? "true" : "false") + ",";
+  out += "\"months\":" + String(load.months) + ",";
+  out += "\"charged_months\":" + String(chargedMonths, 2) + ",";
+  out += "\"kwh\":" + String(totalKwh, 1) + ",";
+  out += "\"load_ms\":" + String(loadMs) + ",";
+  out += "\"sim_us\":" + String(simUs) + ",";
+  out += "\"cheapest\":\"" + bestName + "\",";
+  out += "\"results\":[" + results + "]";
+  out += "}";
+
+  free(kwh);
+  free(hour);
+  free(cal);
+  return out;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config_store.h"
+#include "history_store.h"
+
+// /status/tariff_sim: replays stored history from `from` to `to`
+// (tariff_sim.h) against the built-in profiles, the running config
+// (CUSTOM) and each alternative tier set in altTiers ("kW:NOK,...|kW:NOK,...").
+String tariff_sim_json(const DeviceConfig& cfg, HistTier tier, uint32_t from, uint32_t to, const String& altTiers);
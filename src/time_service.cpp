@@ -0,0 +1,184 @@
+#include "time_service.h"
+
+#include <string.h>
+
+// Anything before 2023 means SNTP hasn't set the clock yet.
+static const time_t kMinValidEpoch = 1672531200;
+
+struct TimeSub {
+  uint8_t events = 0;
+  TimeEventFn fn = nullptr;
+};
+
+static TimeNow g_now;
+static uint32_t g_ms_base = 0;
+static time_t g_epoch_base = 0;
+
+static time_t g_next_minute = 0;
+static time_t g_next_quarter = 0;
+static time_t g_next_hour = 0;
+static time_t g_next_day = 0;
+static time_t g_next_month = 0;
+
+static TimeSub g_subs[TIME_MAX_SUBSCRIBERS];
+static uint8_t g_sub_count = 0;
+
+static void fill_now(time_t epoch)
+{
+  g_now.epoch = epoch;
+  localtime_r(&epoch, &g_now.local);
+  const tm& t = g_now.local;
+  snprintf(g_now.hhmm, sizeof(g_now.hhmm), "%02d:%02d", t.tm_hour, t.tm_min);
+  strftime(g_now.date, sizeof(g_now.date), "%Y-%m-%d", &t);
+  strftime(g_now.iso, sizeof(g_now.iso), "%Y-%m-%dT%H:%M:%S%z", &t);
+  // %z gives +0100; insert the colon for ISO 8601.
+  const size_t n = strlen(g_now.iso);
+  if (n == 24)
+  {
+    g_now.iso[25] = '\0';
+    g_now.iso[24] = g_now.iso[23];
+    g_now.iso[23] = g_now.iso[22];
+    g_now.iso[22] = ':';
+  }
+}
+
+static time_t local_midnight(const tm& base, int addDays, int addMonths)
+{
+  tm t = base;
+  t.tm_hour = 0;
+  t.tm_min = 0;
+  t.tm_sec = 0;
+  t.tm_isdst = -1;
+  if (addMonths != 0)
+  {
+    t.tm_mday = 1;
+    t.tm_mon += addMonths;
+  }
+  t.tm_mday += addDays;
+  return mktime(&t);
+}
+
+static void compute_short_boundaries()
+{
+  // Norwegian time only ever shifts by whole hours, so local minutes,
+  // quarters and hours start on UTC boundaries, also across CET/CEST changes.
+  const time_t e = g_now.epoch;
+  g_now.minute_start = static_cast<uint32_t>(e - (e % 60));
+  g_now.quarter_start = static_cast<uint32_t>(e - (e % 900));
+  g_now.hour_start = static_cast<uint32_t>(e - (e % 3600));
+  g_next_minute = g_now.minute_start + 60;
+  g_next_quarter = g_now.quarter_start + 900;
+  g_next_hour = g_now.hour_start + 3600;
+}
+
+static void compute_boundaries()
+{
+  compute_short_boundaries();
+  g_now.day_start = static_cast<uint32_t>(local_midnight(g_now.local, 0, 0));
+  g_now.month_start = static_cast<uint32_t>(local_midnight(g_now.local, 1 - g_now.local.tm_mday, 0));
+  tm jan1 = g_now.local;
+  jan1.tm_mon = 0;
+  jan1.tm_mday = 1;
+  g_now.year_start = static_cast<uint32_t>(local_midnight(jan1, 0, 0));
+  g_next_day = local_midnight(g_now.local, 1, 0);
+  g_next_month = local_midnight(g_now.local, 0, 1);
+}
+
+static void fire(uint8_t events)
+{
+  for (uint8_t i = 0; i < g_sub_count; ++i)
+  {
+    const uint8_t ev = events & g_subs[i].events;
+    if (ev) g_subs[i].fn(ev, g_now);
+  }
+}
+
+void time_service_start_sntp(const char* tz, const char* ntp1, const char* ntp2)
+{
+  configTime(0, 0, ntp1, ntp2);
+  setenv("TZ", tz, 1);
+  tzset();
+}
+
+void time_service_tick()
+{
+  const uint32_t ms = millis();
+  const time_t epoch = time(nullptr);
+  if (epoch < kMinValidEpoch) return;
+
+  g_ms_base = ms;
+  g_epoch_base = epoch;
+
+  if (!g_now.valid)
+  {
+    fill_now(epoch);
+    compute_boundaries();
+    g_now.valid = true;
+    fire(TIME_EV_VALID);
+    return;
+  }
+
+  if (epoch == g_now.epoch) return;
+
+  if (epoch < g_now.epoch)
+  {
+    // SNTP stepped the clock back; re-anchor without firing events.
+    fill_now(epoch);
+    compute_boundaries();
+    return;
+  }
+
+  uint8_t events = 0;
+  if (epoch >= g_next_minute) events |= TIME_EV_MINUTE;
+  if (epoch >= g_next_quarter) events |= TIME_EV_QUARTER;
+  if (epoch >= g_next_hour) events |= TIME_EV_HOUR;
+  if (epoch >= g_next_day) events |= TIME_EV_DAY;
+  if (epoch >= g_next_month) events |= TIME_EV_MONTH;
+
+  const int prevYear = g_now.local.tm_year;
+  fill_now(epoch);
+  if (events == 0) return;
+
+  if ((events & TIME_EV_MONTH) && g_now.local.tm_year != prevYear) events |= TIME_EV_YEAR;
+  if (events & TIME_EV_DAY) compute_boundaries();
+  else compute_short_boundaries();
+  fire(events);
+}
+
+const TimeNow& time_now()
+{
+  return g_now;
+}
+
+bool time_valid()
+{
+  return g_now.valid;
+}
+
+time_t time_service_epoch_at(uint32_t ms)
+{
+  if (!g_now.valid) return 0;
+  const int32_t deltaMs = static_cast<int32_t>(ms - g_ms_base);
+  return g_epoch_base + deltaMs / 1000;
+}
+
+void time_format_hhmm(time_t epoch, char out[6])
+{
+  if (epoch < kMinValidEpoch)
+  {
+    strlcpy(out, "--:--", 6);
+    return;
+  }
+  tm t;
+  localtime_r(&epoch, &t);
+  snprintf(out, 6, "%02d:%02d", t.tm_hour, t.tm_min);
+}
+
+bool time_service_subscribe(uint8_t events, TimeEventFn fn)
+{
+  if (!fn || g_sub_count >= TIME_MAX_SUBSCRIBERS) return false;
+  g_subs[g_sub_count].events = events;
+  g_subs[g_sub_count].fn = fn;
+  ++g_sub_count;
+  return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+
+// Wall-clock service. The clock is read once per tick; in between, epoch time
+// is derived from millis() through the last mapping. Hour/day/month changes
+// are detected against precomputed boundary epochs and delivered to
+// subscribers, so consumers don't poll tm fields.
+
+enum TimeEvent : uint8_t {
+  TIME_EV_VALID = 1 << 0,   // first tick with a synced clock
+  TIME_EV_HOUR = 1 << 1,
+  TIME_EV_DAY = 1 << 2,
+  TIME_EV_MONTH = 1 << 3,
+  TIME_EV_YEAR = 1 << 4,
+  TIME_EV_MINUTE = 1 << 5,
+  TIME_EV_QUARTER = 1 << 6,   // 15-minute settlement interval
+};
+
+struct TimeNow {
+  bool valid = false;
+  time_t epoch = 0;
+  tm local = {};
+  char hhmm[6] = "--:--";
+  char date[11] = "";        // YYYY-MM-DD
+  char iso[26] = "";         // YYYY-MM-DDTHH:MM:SS+01:00
+
+  // Start of the interval `epoch` falls in, for each boundary event.
+  uint32_t minute_start = 0;
+  uint32_t quarter_start = 0;
+  uint32_t hour_start = 0;
+  uint32_t day_start = 0;
+  uint32_t month_start = 0;
+  uint32_t year_start = 0;
+};
+
+typedef void (*TimeEventFn)(uint8_t events, const TimeNow& now);
+
+static const uint8_t TIME_MAX_SUBSCRIBERS = 8;
+
+// Sets the zone and starts SNTP. Safe to call before WiFi is up.
+void time_service_start_sntp(const char* tz, const char* ntp1, const char* ntp2);
+
+// Samples the clock and fires boundary events. Call about once a second.
+void time_service_tick();
+
+const TimeNow& time_now();
+bool time_valid();
+
+// Epoch for a millis() timestamp, via the current mapping (0 if not synced).
+time_t time_service_epoch_at(uint32_t ms);
+void time_format_hhmm(time_t epoch, char out[6]);
+
+bool time_service_subscribe(uint8_t events, TimeEventFn fn);
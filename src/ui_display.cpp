@@ -23,8 +23,8 @@ static void draw_header(const HanSnapshot& s)
   display.print("HAN Reader");
 
   char price[32];
-  if (isnan(s.price_total_nok_kwh)) snprintf(price, sizeof(price), "%s --.-", s.zone.c_str());
-  else snprintf(price, sizeof(price), "%s %.2f", s.zone.c_str(), s.price_total_nok_kwh);
+  if (isnan(s.price_total_nok_kwh)) snprintf(price, sizeof(price), "%s --.-", s.zone);
+  else snprintf(price, sizeof(price), "%s %.2f", s.zone, s.price_total_nok_kwh);
   int16_t x1, y1;
   uint16_t w, h;
   display.getTextBounds(price, 0, 0, &x1, &y1, &w, &h);
@@ -69,22 +69,31 @@ static void draw_energy_block(const HanSnapshot& s)
   display.setCursor(x + 10, y + 18);
   display.print("Energi");
 
-  display.setCursor(x + 10, y + 44);
+  display.setCursor(x + 10, y + 38);
   display.print("Dag: ");
   display.print(s.day_energy_kwh, 2);
   display.print(" kWh");
 
-  display.setCursor(x + 10, y + 68);
+  display.setCursor(x + 10, y + 57);
   display.print("Mnd: ");
   display.print(s.month_energy_kwh, 1);
   display.print(" kWh");
 
-  display.setCursor(x + 10, y + 92);
+  display.setCursor(x + 10, y + 76);
   display.print("Ar: ");
   display.print(s.year_energy_kwh, 0);
   display.print(" kWh");
 
-  display.setCursor(x + 10, y + 116);
+  // Actual cost so far, today / this month.
+  display.setCursor(x + 10, y + 95);
+  display.print("Kr: ");
+  if (isnan(s.day_cost_nok)) display.print("--");
+  else display.print(s.day_cost_nok, 0);
+  display.print(" / ");
+  if (isnan(s.month_cost_nok)) display.print("--");
+  else display.print(s.month_cost_nok, 0);
+
+  display.setCursor(x + 10, y + 114);
   display.print("Data: ");
   display.print(s.data_time);
 }